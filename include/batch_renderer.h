@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tiny_gl_text_renderer/colors.h"
+
+namespace tiny_graph_plot
+{
+
+using tiny_gl_text_renderer::color_t;
+
+/**
+    One plot of a batch: a graph loaded from a file, drawn into a PNG image.
+    In a spec file each plot is a line of key=value fields separated by
+    whitespace, values with spaces are put in double quotes, '#' starts a
+    comment. Only 'data' and 'out' are required, relative paths are
+    relative to the directory of the spec file.
+        data=path       text file (see GraphTextFile) or binary graph file (see GraphFile)
+        x=0 y=1         columns of a text file
+        out=path        PNG file to write
+        size=1280x720   image size in pixels
+        xrange=min:max  visible range, the range of the data by default
+        yrange=min:max
+        color=blue      a name from colors.h or r,g,b[,a] in [0; 1]
+        line=3          line width, 0 to draw only the markers
+        marker=5        marker size, 0 to draw only the lines
+        density=1       draw the points as a density map, see Graph::SetDensityMode()
+        scheme=bright   dark (default) or bright
+        xtitle="t, s"   axis titles
+        ytitle="U, V"
+*/
+struct PlotSpec {
+    std::string data_path_;
+    unsigned int x_column_ = 0u;
+    unsigned int y_column_ = 1u;
+    std::string out_path_;
+    unsigned int width_ = 1280u;
+    unsigned int height_ = 720u;
+    bool has_x_range_ = false;
+    bool has_y_range_ = false;
+    double x_min_ = 0.0;
+    double x_max_ = 1.0;
+    double y_min_ = 0.0;
+    double y_max_ = 1.0;
+    color_t color_ = tiny_gl_text_renderer::colors::cyan;
+    float line_width_ = 2.0f;
+    float marker_size_ = 0.0f;
+    bool density_ = false;
+    bool bright_ = false;
+    std::string x_title_ = "x axis";
+    std::string y_title_ = "y axis";
+};
+
+//! Outcome of BatchRenderer::Run()
+struct BatchStats {
+    unsigned int n_plots_ = 0u;
+    unsigned int n_failed_ = 0u;
+    unsigned int n_threads_ = 0u;
+    double seconds_ = 0.0; //!< Wall time of the whole batch, loading included
+    double GetPlotsPerSecond() const noexcept {
+        return (seconds_ > 0.0) ? (double)(n_plots_ - n_failed_) / seconds_ : 0.0;
+    }
+};
+
+/**
+    Renders many plots into images without a window and without OpenGL.
+    Each plot is loaded and drawn by a SoftwareCanvas on one of the workers
+    of a pool of its own, so the plots are independent and no locking is
+    needed between them. With a single thread the plots are rendered one
+    after another, each one using the global pool for its loading and
+    drawing instead.
+*/
+class BatchRenderer
+{
+public:
+    //! 'p_n_threads' = 0 means one thread per hardware thread
+    explicit BatchRenderer(const unsigned int p_n_threads = 0u) : n_threads_(p_n_threads) {}
+    ~BatchRenderer() = default;
+    BatchRenderer(const BatchRenderer& other) = delete;
+    BatchRenderer(BatchRenderer&& other) = delete;
+    BatchRenderer& operator=(const BatchRenderer& other) = delete;
+    BatchRenderer& operator=(BatchRenderer&& other) = delete;
+public:
+    void AddPlot(const PlotSpec& p_spec) { specs_.push_back(p_spec); }
+    //! Add the plots of a spec file, see PlotSpec. Returns false and prints the reason on failure.
+    bool LoadSpecs(const char* const p_path);
+    size_t GetNplots() const noexcept { return specs_.size(); }
+    //! Render all the plots, the failed ones are reported on stderr
+    BatchStats Run() const;
+    //! Parse one line of a spec file. Returns false and prints the reason on failure.
+    static bool ParseSpec(const std::string& p_line, PlotSpec& o_spec);
+private:
+    static bool RenderPlot(const PlotSpec& p_spec);
+private:
+    unsigned int n_threads_;
+    std::vector<PlotSpec> specs_;
+};
+
+} // end of namespace tiny_graph_plot
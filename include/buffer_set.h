@@ -1,6 +1,5 @@
 #pragma once
 
-#include <functional>
 #include <string>
 #include <type_traits>
 
@@ -15,7 +14,7 @@ template<typename VERTEX_TYPE>
 class BufferSet
 {
 	static_assert(std::is_same<VERTEX_TYPE, tiny_gl_text_renderer::vertex_colored_t>::value
-		       || std::is_same<VERTEX_TYPE, tiny_gl_text_renderer::vertex_textured_t>::value);
+		       || std::is_same<VERTEX_TYPE, tiny_gl_text_renderer::vertex_glyph_t>::value);
 public:
 	explicit BufferSet(const char* const name);
 	~BufferSet();
@@ -33,7 +32,6 @@ public:
 	void DrawQuads(const unsigned int n_primitives) const;
 	void DrawWires(const unsigned int n_primitives) const;
 	void DrawMarkers(const unsigned int n_primitives) const;
-	void DrawQuadsWithTextures(const size_t n_labels, std::function<GLuint(const size_t)> get_label_tex_id) const;
 private:
 	const std::string name_;
 	GLuint vao_;
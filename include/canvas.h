@@ -2,13 +2,17 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "tiny_gl_text_renderer/colors.h"
 #include "tiny_gl_text_renderer/data_types.h"
 #include "tiny_gl_text_renderer/mat4.h"
 #include "tiny_gl_text_renderer/text_renderer.h"
 #include "buffer_set.h"
+#include "frame_profiler.h"
 #include "grid.h"
+#include "png_exporter.h"
 #include "shader_program.h"
 #include "user_window.h"
 #include "xy_range.h"
@@ -19,6 +23,8 @@ namespace tiny_graph_plot
 {
 
 using tiny_gl_text_renderer::color_t;
+using tiny_gl_text_renderer::Vec2f;
+using tiny_gl_text_renderer::Vec2d;
 using tiny_gl_text_renderer::Vec4f;
 using tiny_gl_text_renderer::Vec4d;
 using tiny_gl_text_renderer::Mat4f;
@@ -31,6 +37,7 @@ template<typename T> class CanvasManager;
 template<typename T> class Drawable;
 template<typename T> class Graph;
 template<typename T, typename VALUETYPE> class Histogram1d;
+template<typename T, typename VALUETYPE> class Histogram2d;
 class SizeInfo;
 
 template<typename T>
@@ -40,7 +47,8 @@ class Canvas : public UserWindow
                || std::is_same<T, double>::value, "");
     friend class CanvasManager<T>;
 private:
-    explicit Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h);
+    explicit Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h,
+                    const OffscreenContext* offscreen_context = nullptr);
     virtual ~Canvas() override;
     Canvas(const Canvas& other) = delete;
     Canvas(Canvas&& other) = delete;
@@ -49,10 +57,87 @@ private:
 public:
     void AddGraph(const Graph<T>& p_graph);
     void AddHistogram(const Histogram1d<T, unsigned long>& p_histo);
+    void AddHistogram2d(const Histogram2d<T, unsigned long>& p_histo);
     void Show();
     virtual void Draw() /*const*/ override;
+    /**
+        Write the canvas into dir/filename as PNG. A canvas with a window
+        exports what has been drawn last, an offscreen canvas is rendered first.
+    */
+    void ExportPNG(const char* const dir, const char* const filename);
+    /**
+        Same as ExportPNG() without waiting for the GPU and the encoder.
+        A canvas with a window requests a frame and reads it back before
+        the buffers are swapped, an offscreen canvas is rendered at once.
+        The file is written on a background thread, which then calls
+        'callback' if it is set, see PngExporter. The pending reads are
+        collected by Draw() and CanvasManager::PollEvents().
+    */
+    void ExportPNGAsync(const char* const dir, const char* const filename,
+                        const PngExporter::Callback& callback = nullptr);
+    /**
+        Positions of the points relative to the first point of their chunk,
+        see Graph::GetVertexChunkSize(), as they are sent to the GPU, and the
+        origins of the chunks. 'o_vertices' holds 'p_n' points, 'o_origins'
+        one per chunk.
+    */
+    static void PackVertices(const Vec2<T>* const p_points, const unsigned int p_n,
+                             Vec2f* const o_vertices, Vec2d* const o_origins);
+    //! Called after each export started with F1
+    void SetSnapshotCallback(const PngExporter::Callback& callback) { snapshot_callback_ = callback; }
+    //! Median and 99th percentile of the CPU and GPU times of the passes of the last frames
+    FrameStats GetFrameStats() const { return profiler_.GetStats(); }
+    //! Show the frame stats over the canvas, F2 toggles it
+    void SetPerfOverlay(const bool p_on);
+private:
+    //! What has already been sent to the GPU for each graph
+    struct GraphUploadState {
+        unsigned int generation_ = 0u;
+        unsigned int n_v_ = 0u; //!< Vertices reserved for the graph
+        unsigned int n_points_ = 0u;
+        std::vector<unsigned int> n_final_; //!< Points of each level which will not change
+        std::vector<unsigned int> level_offsets_; //!< Where each level was put within n_v_
+    };
+    //! Bin values of a histogram on the GPU, the outline is built by the vertex shader
+    struct HistogramBuffers {
+        GLuint tboID_ = 0u;
+        GLuint texID_ = 0u;
+        unsigned int n_bins_ = 0u; //!< Allocated size
+        unsigned int generation_ = 0u;
+    };
+    /**
+        Point counts per pixel of a graph in the density mode. They are kept
+        until the visible range, the frame size or the data change, so that
+        redrawing e.g. for the cursor only runs the colormap pass.
+    */
+    struct DensityCache {
+        GLuint texID_ = 0u;    //!< Counts, frame sized
+        GLuint maxTexID_ = 0u; //!< Maximum count, 1x1
+        int w_ = 0;
+        int h_ = 0;
+        XYrange<double> range_;
+        unsigned int generation_ = 0u;
+        unsigned int n_points_ = 0u;
+        bool valid_ = false;
+    };
+    //! Bins of a 2D histogram as a single-channel texture, colored by _texID_colormap
+    struct Histogram2dTexture {
+        GLuint texID_ = 0u;
+        unsigned int n_bins_x_ = 0u; //!< Allocated size
+        unsigned int n_bins_y_ = 0u;
+        unsigned int generation_ = 0u;
+    };
 private:
     void Init();
+    void InitOffscreenTarget();
+    //! Render an offscreen canvas and resolve it into _fboID_resolve
+    void DrawOffscreen();
+    //! Grid, axes, vref, frame and the drawables, into _fboID_scene
+    void DrawScene();
+    //! Everything the static layer depends on, apart from the data
+    void BuildStaticLayerKey(std::vector<double>& o_key) const;
+    void UpdateStaticLayer();
+    void DrawStaticLayer() const;
     virtual void Clear() const override;
     virtual void Reshape(int p_width, int p_height) override;
     void PrintCursorValues(const double xs, const double ys) const;
@@ -62,13 +147,37 @@ private:
     void SendFixedIndicesToGPU() const;
     int SendGridToGPU();
     void DrawGrid() const;
+    void DrawProceduralGrid() const;
     void DrawAxes() const;
     void DrawVref() const;
     void SendFrameVerticesToGPU() const;
     void FillInFrame() const;
     void DrawFrame() const;
-    void SendDrawableToGPU(const Drawable<T>* const p_graph, const SizeInfo& p_offset) const;
-    void DrawDrawable     (const Drawable<T>* const p_graph, const SizeInfo& p_offset) const;
+    void UpdateTotalRange();
+    void AllocateGraphBuffers();
+    //! Lay the graphs out anew, the vertices which are still valid are moved on the GPU
+    void RelayoutGraphBuffers();
+    bool GraphsChanged() const;
+    void SyncGraphs();
+    void SendVerticesToGPU(const Vec2<T>* const p_points, const unsigned int p_n,
+                           const unsigned int p_offset);
+    void SendChunkTranslationsToGPU();
+    void SendGraphToGPU   (const Graph<T>* const p_graph, const SizeInfo& p_offset,
+                           GraphUploadState& p_state);
+    void DrawGraph        (const Graph<T>* const p_graph, const SizeInfo& p_offset) const;
+    void DrawGraphDensity (const size_t p_index, const SizeInfo& p_offset);
+    void SplatGraphDensity(const size_t p_index, const SizeInfo& p_offset, const int p_w, const int p_h);
+    void SendHistogramToGPU(const size_t p_index);
+    void DrawHistogram    (const size_t p_index) const;
+    void SendHistogram2dToGPU(const size_t p_index);
+    void DrawHistogram2d  (const size_t p_index) const;
+    //! Primitives drawn by DrawVertexRange()
+    enum class vertex_pass_t { VP_ALL, VP_MARKERS, VP_WIRES };
+    //! With 'p_indexed' the vertices are the elements [p_first; p_first + p_n) of _iboID_graphs
+    void DrawVertexRange  (const Drawable<T>* const p_graph, const SizeInfo& p_offset,
+                           const unsigned int p_first, const unsigned int p_n,
+                           const bool p_indexed = false,
+                           const vertex_pass_t p_pass = vertex_pass_t::VP_ALL) const;
     virtual void DrawCursor      (const double xs,  const double ys) const override;
     virtual void DrawSelRectangle(const double xs0, const double ys0,
                                   const double xs1, const double ys1) const override;
@@ -77,6 +186,9 @@ private:
     virtual void UpdateTexTextRef(const double xs,  const double ys) override;
     void UpdateTexTextGridSize();
     void UpdateTexAxesValues();
+    void UpdateTexPerfOverlay();
+    //! 'p_axis' is 0 for X and 1 for Y
+    const std::string& GetTickString(const unsigned int p_axis, const double p_value, const double p_step);
 private:
     // Buffers
     GLuint _vaoID_grid;         //!< 1. Grid
@@ -90,9 +202,28 @@ private:
     GLuint _iboID_frame_onscr_w;
     GLuint _iboID_frame_onscr_q;
     GLuint _vaoID_graphs;       //!< 5. Graphs
-    GLuint _vboID_graphs;
-    GLuint _iboID_graphs_w;
-    GLuint _iboID_graphs_m;
+    GLuint _vboID_graphs;       //!< Only positions, tightly packed Vec2f
+    GLuint _tboID_graphs;       //!< Translation of each vertex chunk, see chunk_origins_
+    GLuint _texID_graphs;
+    GLuint _iboID_graphs;       //!< Decimated vertices of the graph being drawn, see DrawGraph()
+    GLuint _vaoID_histograms;   //!< Empty, histograms have no vertex attributes
+    GLuint _texID_colormap;     //!< 1D colormap of the 2D histograms and the density maps
+    GLuint _fboID_density;      //!< Target of the density splat and reduce passes
+    std::vector<GLuint> _texID_density_reduce; //!< Levels of the maximum reduction, shared
+    GLuint _fboID_target = 0u;  //!< Where the canvas is drawn, 0 for the window
+    GLuint _rboID_target = 0u;  //!< Offscreen canvases: multisampled color buffer
+    GLuint _fboID_resolve = 0u; //!< Offscreen canvases: single-sampled copy to be read back
+    GLuint _rboID_resolve = 0u;
+    GLuint _fboID_scene = 0u;      //!< Where DrawScene() draws: _fboID_target or _fboID_static_ms
+    GLuint _fboID_static_ms = 0u;  //!< Windows: static layer, multisampled as the window
+    GLuint _rboID_static_ms = 0u;
+    GLuint _fboID_static = 0u;     //!< Windows: static layer resolved into _texID_static
+    GLuint _texID_static = 0u;
+    PngExporter png_exporter_;
+    //! Exports of a window canvas, read back at the end of the next Draw()
+    std::vector<std::pair<std::string, PngExporter::Callback>> pending_exports_;
+    PngExporter::Callback snapshot_callback_;
+    mutable FrameProfiler profiler_; //!< Also used by the const draw methods
     BufferSet<vertex_colored_t> buf_set_cursor_; //!< 6. Cursor
     GLuint _vaoID_sel;          //!< 7. Select rectangle
     GLuint _vboID_sel;
@@ -104,19 +235,75 @@ private:
     ShaderProgram prog_onscr_q_;
     ShaderProgram prog_w_;
     ShaderProgram prog_onscr_w_;
-    ShaderProgram prog_m_;
+    ShaderProgram prog_gr_w_; //!< Graphs use compact vertices, see _vboID_graphs
+    ShaderProgram prog_gr_m_;
+    ShaderProgram prog_h_; //!< Histograms, see HistogramBuffers
+    ShaderProgram prog_h2_; //!< 2D histograms, see Histogram2dTexture
+    ShaderProgram prog_d_reduce_;  //!< Density maps, see DensityCache
+    ShaderProgram prog_d_resolve_;
+    ShaderProgram prog_static_; //!< Copy of the static layer into the window
+    ShaderProgram prog_pg_; //!< Procedural grid, see SetProceduralGrid()
     ShaderProgram prog_c_;
     // Other uniforms
     GLint _fr_bg_unif_onscr_q; //!< In frame background color
     GLint _circle_r_unif_c;
+    GLint _color_unif_gr_w;       //!< Color of the current drawable
+    GLint _color_unif_gr_m;       //!< Color of the current drawable
+    GLint _marker_size_unif_gr_m; //!< Marker size of the current drawable
+    GLint _scale_unif_gr_w;       //!< Visible range to clip space scale
+    GLint _scale_unif_gr_m;       //!< Visible range to clip space scale
+    GLint _color_unif_h;
+    GLint _marker_size_unif_h;
+    GLint _vertices_per_bin_unif_h;
+    GLint _bin_ref_unif_h;
+    GLint _bin_transform_unif_h;
+    GLint _y_transform_unif_h;
+    GLint _rect_unif_h2;
+    GLint _uv_rect_unif_h2;
+    GLint _value_scale_unif_h2;
+    GLint _lines_unif_pg;
+    GLint _colors_unif_pg;
+    GLint _widths_unif_pg;
+    GLint _extent_unif_pg;
+    GLint _stipple_unif_pg;
 private:
     std::vector<const Graph<T>*> _graphs;
     std::vector<const Histogram1d<T, unsigned long>*> _histograms;
-    XYrange<float> _total_xy_range;
-    XYrange<float> _visible_range;
-    XYrange<float> _visible_range_start; //!< At mouse press
+    std::vector<GraphUploadState> graphs_upload_state_;
+    std::vector<HistogramBuffers> histogram_buffers_;
+    std::vector<DensityCache> density_caches_; //!< For each graph
+    int density_reduce_w_ = 0; //!< Frame size of _texID_density_reduce
+    int density_reduce_h_ = 0;
+    std::vector<const Histogram2d<T, unsigned long>*> _histograms2d;
+    std::vector<Histogram2dTexture> histogram2d_textures_;
+    /**
+        The grid, the axes, the frame and the drawables of a window canvas
+        are drawn into the static layer, which is only redrawn when the
+        data or any parameter it depends on, collected into the key,
+        changes. Every frame copies it into the window with one quad and
+        draws the text, the cursor, the circles and the selection on top.
+    */
+    bool static_layer_valid_ = false;
+    int static_layer_w_ = 0;
+    int static_layer_h_ = 0;
+    std::vector<double> static_layer_key_;      //!< See BuildStaticLayerKey()
+    std::vector<double> static_layer_key_next_; //!< Scratch, kept to avoid reallocations
+    /**
+        The vertices of the graphs are stored in chunks of
+        Graph<T>::GetVertexChunkSize() relative to the origin of the chunk,
+        the first point of the chunk. For each chunk the vertex shader gets
+        the translation (origin - center of the visible range) * scale,
+        which is calculated in double precision on the CPU. This way even
+        the graphs far away from zero keep the precision at any zoom level.
+    */
+    std::vector<Vec2d> chunk_origins_;
+    bool chunk_translations_valid_ = false;
+    mutable std::vector<unsigned int> decimated_vertices_; //!< Scratch of DrawGraph()
+    XYrange<double> _total_xy_range;
+    XYrange<double> _visible_range;
+    XYrange<double> _visible_range_start; //!< At mouse press
 private:
-    Grid<float> _grid;
+    Grid<double> _grid;
 private:
     virtual void CenterView(const double xs,  const double ys) override;
     virtual void Pan       (const double xs,  const double ys) override;
@@ -135,37 +322,32 @@ private:
                               double& o_xs, double& o_ys) const override;
     virtual void SaveStartState() override;
     virtual void ToggleGraphVisibility(const int iGraph) const override;
-    void ExportPNG(const char* const dir, const char* const filename) const;
+    virtual void TogglePerfOverlay() override { this->SetPerfOverlay(!perf_overlay_); }
     void UpdateMatricesReshape();
     void UpdateMatricesPanZoom();
-    // Transformation matrices are stored using single precision floats,
-    // thus performing transformations in double precision make no sense.
-    Vec4f TransformToVisrange(const double xs, const double ys,
-        Vec4f* const o_in_clip_space = nullptr,
-        Vec4f* const o_in_viewport_space = nullptr) const;
-    Vec4f TransformToVisrange(const Vec4f& in_screen_space,
-        Vec4f* const o_in_clip_space = nullptr,
-        Vec4f* const o_in_viewport_space = nullptr) const;
-    //Vec4d TransformToVisrangeHP(const double xs, const double ys,
-    //    Vec4d* const o_in_clip_space = nullptr) const;
-    //Vec4d TransformToVisrangeHP(const Vec4d& in_screen_space,
-    //    Vec4d* const o_in_clip_space = nullptr) const;
+    // Screen to visible range transformations use the double precision
+    // matrices, so that the cursor stays precise at deep zoom.
+    Vec4d TransformToVisrange(const double xs, const double ys,
+        Vec4d* const o_in_clip_space = nullptr,
+        Vec4d* const o_in_viewport_space = nullptr) const;
+    Vec4d TransformToVisrange(const Vec4d& in_screen_space,
+        Vec4d* const o_in_clip_space = nullptr,
+        Vec4d* const o_in_viewport_space = nullptr) const;
 private:
     // Direct matrices
     Mat4f _screen_to_viewport;
     Mat4f _viewport_to_clip;
     Mat4f _screen_to_clip;
-    Mat4f _clip_to_visrange;
     // Inverse matrices
     Mat4f _viewport_to_screen;
     Mat4f _clip_to_viewport;
     Mat4f _clip_to_screen;
-    Mat4f _visrange_to_clip;
+    Mat4f _visrange_to_clip_rtc; //!< For coordinates relative to the center of the visible range
     // For intermediate high-precision calculations
-    //Mat4d _screen_to_viewport_hp;
-    //Mat4d _viewport_to_clip_hp;
+    Mat4d _screen_to_viewport_hp;
+    Mat4d _viewport_to_clip_hp;
     //Mat4d _screen_to_clip_hp;
-    //Mat4d _clip_to_visrange_hp;
+    Mat4d _clip_to_visrange_hp;
     //Mat4d _screen_to_visrange_hp;
     // ===========================================================================
 private:
@@ -192,6 +374,19 @@ private:
     size_t _x_axis_values_lables_start_idx = 4u;
     size_t _y_axis_values_lables_start_idx = 24u;
     size_t _labels_start_idx = 44u;
+    size_t _perf_labels_start_idx = 0u; //!< Header, then one line per frame_pass_t. 0 until Show().
+    bool perf_overlay_ = false;
+    bool perf_overlay_valid_ = false;
+    std::chrono::steady_clock::time_point perf_overlay_time_; //!< Of the last update
+    /**
+        The axis values are only updated when the grid or the view has
+        changed, see UpdateTexAxesValues(). The strings of the tick values
+        are kept while the coarse grid steps stay the same, so that panning
+        only formats the values which come into view.
+    */
+    bool axes_values_valid_ = false;
+    double tick_strings_step_[2] = { 0.0, 0.0 }; //!< Coarse steps of X and Y the strings were made for
+    std::unordered_map<long long, std::string> tick_strings_[2]; //!< Of X and Y, keyed by value / step
     // ===========================================================================
 public: // visual parameters
     void SetXaxisTitle(const char* title) { x_axis_title_ = std::string(title); }
@@ -211,6 +406,15 @@ public: // visual parameters
     void DisableFrame()   noexcept { enable_frame_   = false; }
     void DisableCursor()  noexcept { enable_cursor_  = false; }
     void DisableCircles() noexcept { enable_circles_ = false; }
+    /**
+        Draw the grid in a fragment shader from the grid steps and the visible
+        range instead of building and sending its lines: panning and zooming
+        then cost no geometry work and no uploads. Off by default.
+    */
+    void SetProceduralGrid(const bool p_on) noexcept {
+        procedural_grid_ = p_on; grid_valid_ = false; axes_values_valid_ = false;
+        _grid.Invalidate(); }
+    bool GetProceduralGrid() const noexcept { return procedural_grid_; }
     // Color settings ------------------------------------------------------------
     void SetDarkColorScheme();
     void SetBrightColorScheme();
@@ -234,7 +438,7 @@ public: // visual parameters
     void SetVrefLineWidth       (const float width) noexcept { vref_line_width_   = width; }
     void SetFrameLineWidth      (const float width) noexcept { frame_line_width_  = width; }
     void SetCursorLineWidth     (const float width) noexcept { cursor_line_width_ = width; }
-    void SetFontSize(const float size) noexcept { font_size_ = size; }
+    void SetFontSize(const float size) noexcept { font_size_ = size; axes_values_valid_ = false; }
     void SetCircleRadius(const unsigned int r) noexcept { circle_r_ = r; }
     void SetMarginXleft(const unsigned int w_in_pix) {
         margin_xl_pix_ = w_in_pix; this->UpdateSizeLimits(); }
@@ -261,6 +465,8 @@ private: // visual parameters
     bool enable_frame_   = true;
     bool enable_cursor_  = true;
     bool enable_circles_ = true;
+    bool procedural_grid_ = false;
+    bool grid_valid_ = false; //!< Whether SendGridToGPU() has been called since the grid mode was set
     color_t background_color_ = tiny_gl_text_renderer::colors::gray1;
     color_t in_frame_bg_color_ = tiny_gl_text_renderer::colors::gray05;
     color_t axes_line_color_  = tiny_gl_text_renderer::colors::gray75;
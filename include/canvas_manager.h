@@ -3,6 +3,8 @@
 #include <vector>
 
 #include "canvas.h"
+#include "graph_manager.h"
+#include "offscreen_context.h"
 
 namespace tiny_graph_plot
 {
@@ -13,7 +15,8 @@ class CanvasManager
     static_assert(std::is_same<T, float>::value
                || std::is_same<T, double>::value, "");
 public:
-	explicit CanvasManager();
+	//! The event loop drains the queues of the graphs of 'p_graph_manager', see Graph::Push()
+	explicit CanvasManager(GraphManager<T>* const p_graph_manager = nullptr);
 	~CanvasManager();
     CanvasManager(const CanvasManager& other) = delete;
     CanvasManager(CanvasManager&& other) = delete;
@@ -23,9 +26,47 @@ public:
 	Canvas<T>& CreateCanvas(const char* name,
 		const unsigned int w = 800u, const unsigned int h = 600u,
 		const unsigned int x = 50u, const unsigned int y = 50u);
+	/**
+		Canvas without a window, rendered into a framebuffer object of w x h
+		pixels in an OffscreenContext, so that plots can be made on machines
+		without a display or a GPU. It is set up as a normal canvas, including
+		Show(), then ExportPNG() renders it and writes the image.
+	*/
+	Canvas<T>& CreateOffscreenCanvas(const unsigned int w = 800u, const unsigned int h = 600u);
 	void WaitForTheWindowsToClose();
+	/**
+		Process pending events without blocking and draw the frames they
+		requested, including the canvases whose graphs received new data
+		(see Graph::Append() and Graph::Push()), at most one per canvas.
+		The finished reads of Canvas::ExportPNGAsync() are passed to the
+		encoders, also for the offscreen canvases.
+		Returns false once the first window has been closed,
+		or if there are no windows.
+	*/
+	bool PollEvents();
 private:
+	Canvas<T>* GetFirstWindowCanvas() const;
+	//! Pass the finished PNG reads to the encoders, returns true if some are still on the GPU
+	bool PollExports();
+	/**
+		Draw the frames requested by the windows, see UserWindow::RequestFrame().
+		Returns the time in seconds until the next frame delayed by a frame
+		rate cap is due, negative if there is none.
+	*/
+	double RenderFrames();
+	/**
+		Drain the queues of the graphs through the graph manager and request
+		the frames of the windows whose graphs have changed. Returns true if
+		some graph has a queue.
+	*/
+	bool SyncGraphQueues();
+private:
+	//! The producers do not wake up the event loop, see Graph::Push(), so it polls their queues
+	static constexpr double queue_poll_period_ = 0.005;
+	GraphManager<T>* graph_manager_ = nullptr; //!< Owns the graphs whose queues are drained
 	std::vector<Canvas<T>*> canvases_;
+	OffscreenContext offscreen_context_; //!< Shared by the offscreen canvases
+	bool glfw_initialized_ = false; //!< Only on the first window, not needed offscreen
 	bool glew_initialized_ = false;
 };
 
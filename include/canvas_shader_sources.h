@@ -90,24 +90,185 @@ void main() {
 }
 )";
 // ===============================================================================
-const char* canvas_m_vp_source = R"(#version 400
-layout (location = 0) in vec4 in_position;
-layout (location = 1) in vec4 in_color;
-uniform mat4 screen2viewport;
-uniform mat4 viewport2clip;
-uniform mat4 screen2clip;
-uniform mat4 visrange2clip;
-out vec4 color;
+// Positions are relative to the origin of their chunk of vertices,
+// chunk_translation holds (origin - visrange center) * scale of each chunk.
+const char* canvas_gr_w_vp_source = R"(#version 400
+layout (location = 0) in vec2 in_position;
+uniform samplerBuffer chunk_translation;
+uniform int chunk_size;
+uniform vec2 visrange_scale;
 void main() {
-    gl_Position = visrange2clip * in_position;
-    color = in_color;
+    vec2 translation = texelFetch(chunk_translation, gl_VertexID / chunk_size).xy;
+    gl_Position = vec4(in_position * visrange_scale + translation, 0.0f, 1.0f);
 }
 )";
-const char* canvas_m_fp_source = R"(#version 400
-in vec4 color;
+const char* canvas_gr_w_fp_source = R"(#version 400
+uniform vec4 drawcolor;
 layout(location = 0) out vec4 out_color;
 void main() {
-    out_color = color;
+    out_color = drawcolor;
+}
+)";
+// ===============================================================================
+const char* canvas_gr_m_vp_source = R"(#version 400
+layout (location = 0) in vec2 in_position;
+uniform samplerBuffer chunk_translation;
+uniform int chunk_size;
+uniform vec2 visrange_scale;
+uniform float marker_size;
+void main() {
+    vec2 translation = texelFetch(chunk_translation, gl_VertexID / chunk_size).xy;
+    gl_Position = vec4(in_position * visrange_scale + translation, 0.0f, 1.0f);
+    gl_PointSize = marker_size;
+}
+)";
+const char* canvas_gr_m_fp_source = R"(#version 400
+uniform vec4 drawcolor;
+layout(location = 0) out vec4 out_color;
+void main() {
+    out_color = drawcolor;
+}
+)";
+// ===============================================================================
+// Histograms have no vertex attributes. Each bin is expanded either into the
+// left edge, the center and the right edge of its step, or into its center
+// for the markers. bin_transform holds the x of the left edge of bin_ref and
+// the bin width in clip space, y_transform the scale and the translation of
+// the bin values into clip space.
+const char* canvas_h_vp_source = R"(#version 400
+uniform samplerBuffer bin_values;
+uniform int vertices_per_bin;
+uniform int bin_ref;
+uniform vec2 bin_transform;
+uniform vec2 y_transform;
+uniform float marker_size;
+void main() {
+    int bin = gl_VertexID / vertices_per_bin;
+    float edge = (vertices_per_bin == 1) ? 0.5f : 0.5f * float(gl_VertexID % vertices_per_bin);
+    float x = bin_transform.x + (float(bin - bin_ref) + edge) * bin_transform.y;
+    float y = texelFetch(bin_values, bin).r * y_transform.x + y_transform.y;
+    gl_Position = vec4(x, y, 0.0f, 1.0f);
+    gl_PointSize = marker_size;
+}
+)";
+const char* canvas_h_fp_source = R"(#version 400
+uniform vec4 drawcolor;
+layout(location = 0) out vec4 out_color;
+void main() {
+    out_color = drawcolor;
+}
+)";
+// ===============================================================================
+// 2D histograms are drawn as one quad, the visible part of the binning range.
+// rect holds its corners in clip space, uv_rect the same corners in texture
+// coordinates.
+const char* canvas_h2_vp_source = R"(#version 400
+uniform vec4 rect;
+uniform vec4 uv_rect;
+out vec2 uv;
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    uv = mix(uv_rect.xy, uv_rect.zw, corner);
+    gl_Position = vec4(mix(rect.xy, rect.zw, corner), 0.0f, 1.0f);
+}
+)";
+const char* canvas_h2_fp_source = R"(#version 400
+in vec2 uv;
+uniform sampler2D bin_values;
+uniform sampler1D colormap;
+uniform float value_scale;
+layout(location = 0) out vec4 out_color;
+void main() {
+    float value = texture(bin_values, uv).r;
+    if (value <= 0.0f) discard; // Empty bins are transparent
+    out_color = texture(colormap, clamp(value * value_scale, 0.0f, 1.0f));
+}
+)";
+// ===============================================================================
+// Density maps of scatter graphs. The points are counted per pixel by drawing
+// them with additive blending into a float texture, see Canvas::DensityCache.
+// Both passes below draw the whole viewport as one quad.
+const char* canvas_d_vp_source = R"(#version 400
+out vec2 uv;
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    uv = corner;
+    gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+// Maximum of each 8x8 block of the source
+const char* canvas_d_reduce_fp_source = R"(#version 400
+uniform sampler2D src;
+layout(location = 0) out vec4 out_value;
+void main() {
+    ivec2 size = textureSize(src, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * 8;
+    float m = 0.0f;
+    for (int j = 0; j < 8; j++) {
+        for (int i = 0; i < 8; i++) {
+            ivec2 p = base + ivec2(i, j);
+            if (p.x < size.x && p.y < size.y) m = max(m, texelFetch(src, p, 0).r);
+        }
+    }
+    out_value = vec4(m);
+}
+)";
+// Logarithmic colormap lookup of the counts, relative to the maximum count
+const char* canvas_d_resolve_fp_source = R"(#version 400
+in vec2 uv;
+uniform sampler2D density;
+uniform sampler2D density_max;
+uniform sampler1D colormap;
+layout(location = 0) out vec4 out_color;
+void main() {
+    float value = texture(density, uv).r;
+    if (value <= 0.0f) discard;
+    float m = texelFetch(density_max, ivec2(0, 0), 0).r;
+    out_color = texture(colormap, log(1.0f + value) / log(1.0f + max(m, 1.0f)));
+}
+)";
+// ===============================================================================
+// Static layer of a window, see Canvas::UpdateStaticLayer(). Drawn with
+// canvas_d_vp_source over the whole window, each pixel is copied as is.
+const char* canvas_static_fp_source = R"(#version 400
+uniform sampler2D layer;
+layout(location = 0) out vec4 out_color;
+void main() {
+    out_color = texelFetch(layer, ivec2(gl_FragCoord.xy), 0);
+}
+)";
+// ===============================================================================
+// Procedural grid, see Canvas::SetProceduralGrid(). Drawn with canvas_d_vp_source
+// over the frame. Everything is in window pixels, computed on the CPU in double
+// precision, so that the lines stay in place at any zoom. The line sets are the
+// vertical fine, vertical coarse, horizontal fine and horizontal coarse lines,
+// each one given by its first line, the step and the number of lines.
+const char* canvas_pg_fp_source = R"(#version 400
+uniform vec3 lines[4];
+uniform vec4 colors[4];
+uniform float widths[4];
+uniform vec4 extent;         // xmin, xmax, ymin, ymax of the lines
+uniform vec2 stipple_origin; // First pixel of the horizontal and of the vertical lines, modulo 8
+layout(location = 0) out vec4 out_color;
+bool OnLine(float p, int i) {
+    if (lines[i].z < 0.5f) return false;
+    float k = clamp(floor((p - lines[i].x) / lines[i].y + 0.5f), 0.0f, lines[i].z - 1.0f);
+    return abs(p - (lines[i].x + k * lines[i].y)) < 0.5f * max(widths[i], 1.0f);
+}
+// Same pattern as glLineStipple(1, 0x0101): one pixel out of 8
+bool OnDot(float p, float origin) {
+    return mod(floor(p) - origin, 8.0f) < 0.5f;
+}
+void main() {
+    vec2 p = gl_FragCoord.xy;
+    bool in_x = p.x >= extent.x && p.x <= extent.y;
+    bool in_y = p.y >= extent.z && p.y <= extent.w;
+    // The horizontal lines are drawn over the vertical ones, the coarse over the fine
+    if (in_x && OnLine(p.y, 3)) out_color = colors[3];
+    else if (in_x && OnLine(p.y, 2) && OnDot(p.x, stipple_origin.x)) out_color = colors[2];
+    else if (in_y && OnLine(p.x, 1)) out_color = colors[1];
+    else if (in_y && OnLine(p.x, 0) && OnDot(p.y, stipple_origin.y)) out_color = colors[0];
+    else discard;
 }
 )";
 // ===============================================================================
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tiny_graph_plot
+{
+
+/**
+    The viridis colormap of the 2D histograms and the density maps,
+    interpolated between 9 samples into 'p_n_colors' RGBA8 colors.
+    'p_n_colors' must be at least 2.
+*/
+inline std::vector<unsigned char> BuildViridisColormap(const unsigned int p_n_colors)
+{
+    constexpr unsigned int n_samples = 9u;
+    constexpr float samples[n_samples][3] = {
+        {  68.0f,   1.0f,  84.0f }, {  71.0f,  44.0f, 122.0f }, {  59.0f,  81.0f, 139.0f },
+        {  44.0f, 113.0f, 142.0f }, {  33.0f, 144.0f, 141.0f }, {  39.0f, 173.0f, 129.0f },
+        {  92.0f, 200.0f,  99.0f }, { 170.0f, 220.0f,  50.0f }, { 253.0f, 231.0f,  37.0f } };
+    std::vector<unsigned char> colors(4u * p_n_colors);
+    for (unsigned int i = 0u; i < p_n_colors; i++) {
+        const float t = (float)i / (float)(p_n_colors - 1u) * (float)(n_samples - 1u);
+        const unsigned int j = std::min((unsigned int)t, n_samples - 2u);
+        const float f = t - (float)j;
+        for (unsigned int c = 0u; c < 3u; c++) {
+            colors[4u * i + c] = (unsigned char)std::lround(
+                samples[j][c] + f * (samples[j + 1u][c] - samples[j][c]));
+        }
+        colors[4u * i + 3u] = 255u;
+    }
+    return colors;
+}
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+
+typedef unsigned int GLuint;
+
+namespace tiny_graph_plot
+{
+
+//! Measured stages of a frame, each one wraps the debug group of the same name
+enum class frame_pass_t
+{
+    FP_FRAME,        //!< The whole Canvas::Draw()
+    FP_SYNC,         //!< Uploads of the changed graphs and of the grid
+    FP_STATIC_LAYER, //!< Redraw of the static layer of a window, only when it has changed
+    FP_GRID,
+    FP_HISTOGRAMS2D,
+    FP_GRAPHS,
+    FP_HISTOGRAMS,
+    FP_TEXT,
+    FP_CURSOR,
+    FP_N
+};
+
+//! Times of one pass over the last frames in which it was drawn, in milliseconds
+struct PassStats {
+    const char* name_ = "";
+    unsigned int n_cpu_samples_ = 0u;
+    unsigned int n_gpu_samples_ = 0u; //!< 0 if there are no timer queries, e.g. offscreen
+    double cpu_p50_ms_ = 0.0;
+    double cpu_p99_ms_ = 0.0;
+    double gpu_p50_ms_ = 0.0;
+    double gpu_p99_ms_ = 0.0;
+};
+
+//! See Canvas::GetFrameStats()
+struct FrameStats {
+    unsigned long long n_frames_ = 0u;
+    PassStats passes_[(size_t)frame_pass_t::FP_N];
+    const PassStats& Get(const frame_pass_t p_pass) const noexcept { return passes_[(size_t)p_pass]; }
+};
+
+/**
+    CPU and GPU times of the passes of a frame. The CPU time is taken
+    between Begin() and End(). The GPU time is measured with a pair of
+    GL_TIMESTAMP queries, so that the passes can be nested, which
+    GL_TIME_ELAPSED queries can not be. There are two sets of queries:
+    BeginFrame() reads the set of the frame before the previous one and
+    drops its results if they are still not available, so it never waits
+    for the GPU. Each pass keeps its last n_samples_ times.
+
+    The methods which issue or read the queries must be called from the
+    thread of the OpenGL context in which Init() has been called.
+*/
+class FrameProfiler
+{
+public:
+    explicit FrameProfiler() = default;
+    ~FrameProfiler() = default; //!< Call Release() before
+    FrameProfiler(const FrameProfiler& other) = delete;
+    FrameProfiler(FrameProfiler&& other) = delete;
+    FrameProfiler& operator=(const FrameProfiler& other) = delete;
+    FrameProfiler& operator=(FrameProfiler&& other) = delete;
+public:
+    //! Create the queries, the context must be current. Without it only the CPU is timed.
+    void Init();
+    //! Delete the queries, the context must be current
+    void Release();
+    void BeginFrame();
+    void Begin(const frame_pass_t p_pass);
+    void End(const frame_pass_t p_pass);
+    unsigned long long GetNframes() const noexcept { return n_frames_; }
+    FrameStats GetStats() const;
+    static const char* GetPassName(const frame_pass_t p_pass) noexcept;
+private:
+    static constexpr size_t n_passes_ = (size_t)frame_pass_t::FP_N;
+    static constexpr size_t n_sets_ = 2u;
+    static constexpr size_t n_samples_ = 128u;
+    //! Ring of the last n_samples_ values
+    struct Samples {
+        double values_[n_samples_] = {};
+        size_t n_ = 0u;
+        size_t next_ = 0u;
+        void Push(const double p_value) noexcept;
+        void GetPercentiles(double& o_p50, double& o_p99) const;
+    };
+private:
+    GLuint queries_[n_sets_][n_passes_][2] = {}; //!< Begin and end timestamps
+    bool issued_[n_sets_][n_passes_] = {};
+    size_t set_ = 0u;
+    std::chrono::steady_clock::time_point cpu_start_[n_passes_];
+    Samples cpu_[n_passes_];
+    Samples gpu_[n_passes_];
+    unsigned long long n_frames_ = 0u;
+};
+
+} // end of namespace tiny_graph_plot
@@ -8,8 +8,13 @@
 namespace tiny_graph_plot
 {
 
-void init_glew() {
+void init_glew(const bool offscreen = false) {
     GLenum err = glewInit();
+    // Without a window system GLEW loads the OpenGL functions and only then
+    // fails to find an X display for GLX, which the offscreen canvases do not use
+    if (offscreen && err == GLEW_ERROR_NO_GLX_DISPLAY) {
+        err = GLEW_OK;
+    }
     if (GLEW_OK != err) {
         fprintf(stderr, "GLEW: error: failed to initialize: %s\nAborting.\n",
             glewGetErrorString(err));
@@ -2,9 +2,14 @@
 
 //#include <cmath> // included through xy_range.h
 //#include <limits>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <type_traits>
+#include <vector>
 
 #include "drawable.h"
+#include "spsc_queue.h"
 
 namespace tiny_graph_plot
 {
@@ -23,7 +28,11 @@ private:
     explicit Graph()
     :   Drawable<T>(),
         n_points_(0u),
-        shared_points_(false) {}
+        capacity_(0u),
+        shared_points_(false),
+        x_sorted_(false),
+        range_valid_(false),
+        data_generation_(0u) {}
     virtual ~Graph() {
         if (this->points_ != nullptr && !shared_points_) {
             free(this->points_);
@@ -41,18 +50,191 @@ public:
         for further visualization.
     */
     void SetSharedBuffer(const unsigned int p_size, Vec2<T>* const p_xy) {
+        if (this->points_ != nullptr && !shared_points_) {
+            free(this->points_);
+        }
         n_points_ = p_size;
-        this->size_info_ = SizeInfo(p_size, p_size, p_size - 1u, 0u);
+        capacity_ = p_size;
         shared_points_ = true;
         this->points_ = p_xy;
         this->CalculateRanges();
+        this->DetectSortedness(0u);
+        this->UpdateSearchIndex(0u);
+        this->BuildLevels();
+        this->UpdateSizeInfo();
+        data_generation_++;
+    }
+    /**
+        Same as above for data whose ranges and ordering are already known,
+        e.g. stored in a file header, so that the data is not scanned to
+        find them. 'p_range' must not have the degenerate cases fixed.
+    */
+    void SetSharedBuffer(const unsigned int p_size, Vec2<T>* const p_xy,
+                         const XYrange<T>& p_range, const bool p_x_sorted) {
+        if (this->points_ != nullptr && !shared_points_) {
+            free(this->points_);
+        }
+        n_points_ = p_size;
+        capacity_ = p_size;
+        shared_points_ = true;
+        this->points_ = p_xy;
+        data_range_ = p_range;
+        range_valid_ = (p_size > 0u);
+        this->xy_range_ = data_range_;
+        this->xy_range_.FixDegenerateCases();
+        x_sorted_ = p_x_sorted;
+        this->UpdateSearchIndex(0u);
+        this->BuildLevels();
+        this->UpdateSizeInfo();
+        data_generation_++;
     }
+    /**
+        Append 'p_n' points to the end of the graph. The graph switches to its
+        own growable storage (copying the shared buffer, if any, once), so the
+        input collection can be reused right after the call. The ranges and
+        the level-of-detail pyramid are updated only for the new points.
+    */
+    void Append(const Vec2<T>* const p_xy, const unsigned int p_n);
+    //! Make sure there is space for at least 'p_capacity' points without reallocation
+    bool Reserve(const unsigned int p_capacity);
+public: // feeding from another thread
+    /**
+        The graph, like the canvas, may only be changed from the thread which
+        draws it. Another thread, e.g. an acquisition loop, can instead feed
+        it through Push(): the points go into a queue of 'p_capacity' points
+        (see SpscQueue), which the event loop of the canvas manager drains
+        before the frames, see GraphManager::DrainQueues(). Call this on the
+        drawing thread before the producer starts. Returns false on failure.
+    */
+    bool EnableQueue(const unsigned int p_capacity);
+    bool HasQueue() const noexcept { return queue_.IsInitialized(); }
+    /**
+        Producer thread, one at a time. Queue as many of the 'p_n' points as
+        fit, the rest are left to the caller and counted, see GetNdropped().
+        Never allocates and never waits for the drawing thread or for OpenGL.
+        Returns the number of queued points.
+    */
+    unsigned int Push(const Vec2<T>* const p_xy, const unsigned int p_n) noexcept {
+        const unsigned int n = static_cast<unsigned int>(queue_.Push(p_xy, p_n));
+        if (n < p_n) {
+            n_dropped_.fetch_add(p_n - n, std::memory_order_relaxed);
+        }
+        return n;
+    }
+    bool Push(const Vec2<T>& p_xy) noexcept { return this->Push(&p_xy, 1u) == 1u; }
+    //! Points passed to Push() so far which did not fit into the queue, retried ones included
+    unsigned long long GetNdropped() const noexcept { return n_dropped_.load(std::memory_order_relaxed); }
+    bool HasQueuedPoints() const noexcept { return queue_.GetSize() != 0u; }
+    //! Drawing thread. Append() the queued points, returns their number.
+    unsigned int DrainQueue();
+    /**
+        Linear interpolation between the points of the graph.
+        Returns NaN outside of the range of the graph. For graphs with
+        non-decreasing x the search takes O(log n) time.
+    */
     T Evaluate(const T x) const;
+    //! Same as Evaluate() for each of the 'n' values in 'xs', the results are written to 'ys'
+    void EvaluateMany(const T* const xs, T* const ys, const size_t n) const;
+    unsigned int GetNpoints() const noexcept { return n_points_; }
+    unsigned int GetCapacity() const noexcept { return capacity_; }
+    bool IsXsorted() const noexcept { return x_sorted_; }
+    //! Incremented each time the whole data of the graph is replaced
+    unsigned int GetDataGeneration() const noexcept { return data_generation_; }
+public: // visual parameters
+    /**
+        Draw the points as a density map instead of markers and lines: the
+        points are counted per pixel of the visible range and the counts are
+        colored with a colormap. Meant for large unordered scatter data.
+    */
+    void SetDensityMode(const bool density) noexcept { density_mode_ = density; }
+    bool GetDensityMode() const noexcept { return density_mode_; }
+public: // level-of-detail pyramid
+    /**
+        Level 0 is the original data. Each next level is built from the
+        previous one and keeps, for every bucket of samples, the first,
+        the minimum, the maximum and the last point in their original order.
+        The buckets do not follow the pixel columns of a view, so a level is
+        not drawn as it is: the levels are a min/max tree from which
+        DecimateToColumns() picks the points of each column of the view.
+        The pyramid is built only for graphs with non-decreasing x.
+        The vertices of the graph (see GetSizeInfo()) reserve space for all
+        the levels which may exist once the capacity of the graph is filled.
+    */
+    unsigned int GetNlevels() const noexcept {
+        return 1u + static_cast<unsigned int>(lod_levels_.size());
+    }
+    const Vec2<T>* GetLevelData(const unsigned int i_level, unsigned int& o_n) const noexcept;
+    //! Offset of the first point of the level within the vertices of the graph
+    unsigned int GetLevelOffset(const unsigned int i_level) const noexcept;
+    /**
+        Each level starts at a multiple of this number of vertices, hence
+        the vertices of the graph are always a whole number of chunks.
+        The canvas stores the vertices of each chunk relative to its own
+        origin to keep the precision of graphs far away from zero.
+    */
+    static constexpr unsigned int GetVertexChunkSize() noexcept { return vertex_chunk_size_; }
+    //! Number of leading points of the level which will not change on Append()
+    unsigned int GetLevelNfinal(const unsigned int i_level) const noexcept;
+    //! The span of the level points needed to draw the [xlow;xhigh] interval
+    void GetVisibleSpan(const unsigned int i_level, const T xlow, const T xhigh,
+        unsigned int& o_first, unsigned int& o_n) const noexcept;
+    /**
+        Vertices (indices within all the levels, see GetLevelOffset()) of a
+        polyline which has the same vertical extent as the full data in each
+        of 'n_columns' pixel columns of width 'pixel_dx' starting at 'xlow':
+        for each column the first, the lowest, the highest and the last point
+        in their original order, plus the points just outside of the columns.
+        Only the shading of antialiased edges may differ from the full data.
+        A non-finite point is kept as it is and splits its column into parts
+        reduced separately, so the breaks of the line stay where they are.
+        Each column costs O(log n) through the levels. Returns false, leaving
+        'o_vertices' empty, if the graph is not sorted along x or if the
+        columns hold too few points to be worth it; then draw the visible
+        span of level 0 instead.
+    */
+    bool DecimateToColumns(const double xlow, const double pixel_dx, const unsigned int n_columns,
+        std::vector<unsigned int>& o_vertices) const;
+    //! The point of a vertex returned by DecimateToColumns()
+    const Vec2<T>& GetVertex(const unsigned int i_vertex) const noexcept;
 private:
-    void CalculateRanges() const;
+    unsigned int FindSegment(const T x) const noexcept;
+    T Interpolate(const unsigned int idxl, const T x) const noexcept;
+    void CalculateRanges();
+    void IncludeInRanges(const unsigned int p_first);
+    void DetectSortedness(const unsigned int p_first);
+    void UpdateSearchIndex(const unsigned int p_first);
+    void BuildLevels();
+    void UpdateLevels(const unsigned int p_first);
+    unsigned int GetNlevelsReserved() const noexcept;
+    unsigned int GetLevelCapacity(const unsigned int i_level) const noexcept;
+    void UpdateSizeInfo();
 private:
+    static constexpr unsigned int lod_first_bucket_size_ = 16u; //!< Samples per bucket of level 1
+    static constexpr unsigned int lod_next_bucket_size_ = 8u; //!< Level points per bucket of the next levels
+    static constexpr unsigned int lod_min_level_size_ = 1024u; //!< Do not build smaller levels
+    static constexpr unsigned int decimation_min_points_ = 8u; //!< Per column on average, see DecimateToColumns()
+    static constexpr unsigned int min_capacity_ = 1024u;
+    //! The vertices of all the levels, about 1.5 times the capacity, are indexed by unsigned int
+    static constexpr unsigned int max_capacity_ = 0xA0000000u;
+    static constexpr unsigned int vertex_chunk_size_ = 4096u;
+    static constexpr size_t parallel_min_points_ = 1u << 20; //!< Smaller ranges are reduced by one thread
+    static constexpr unsigned int index_stride_ = 64u; //!< Points per entry of x_index_
+    static constexpr unsigned int max_interpolation_steps_ = 4u;
+    static constexpr unsigned int eval_lanes_ = 8u; //!< Queries searched simultaneously in EvaluateMany()
     unsigned int n_points_; //!< Number of points
+    unsigned int capacity_; //!< Number of points which fit into the current storage
     bool shared_points_;
+    bool x_sorted_; //!< x coordinates are non-decreasing
+    bool range_valid_; //!< At least one finite point has been included into data_range_
+    unsigned int data_generation_;
+    bool density_mode_ = false;
+    XYrange<T> data_range_; //!< Same as xy_range_ but without the degenerate cases fixed
+    std::vector<T> x_index_; //!< x of every index_stride_-th point of a sorted graph
+    std::vector<std::vector<Vec2<T>>> lod_levels_; //!< Levels starting from level 1
+    std::vector<std::vector<unsigned char>> lod_non_finite_; //!< Buckets of each level with non-finite points
+    std::vector<unsigned int> level_offsets_{0u, 0u}; //!< Of each reserved level and the end, see UpdateSizeInfo()
+    SpscQueue<Vec2<T>> queue_; //!< See EnableQueue()
+    std::atomic<unsigned long long> n_dropped_{0u};
 };
 
 template class Graph<float>;
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "graph.h"
+#include "mapped_file.h"
+
+namespace tiny_graph_plot
+{
+
+/**
+    Header of a binary graph file. All the values are little-endian.
+
+    offset  size  content
+         0     8  magic "TGPGRAPH"
+         8     4  format version, 1
+        12     4  size of one coordinate in bytes: 4 (float) or 8 (double)
+        16     4  layout: 0 - interleaved x0 y0 x1 y1 ..., 1 - all x then all y
+        20     4  flags: bit 0 - x is non-decreasing, bit 1 - the range is valid
+        24     8  number of points
+        32    32  x min, x max, y min, y max of the finite points, as doubles
+        64        the coordinates
+*/
+struct GraphFileHeader
+{
+    char magic_[8];
+    uint32_t version_;
+    uint32_t value_size_;
+    uint32_t layout_;
+    uint32_t flags_;
+    uint64_t n_points_;
+    double x_min_;
+    double x_max_;
+    double y_min_;
+    double y_max_;
+};
+static_assert(sizeof(GraphFileHeader) == 64u, "");
+
+/**
+    Loader of binary graph files, see GraphFileHeader.
+
+    The file is mapped into memory instead of being read. When the file
+    holds interleaved coordinates of the same type as the graph, the graph
+    works directly on the mapped pages (zero copy), so only the pages which
+    are actually used get loaded. The ranges and the ordering are taken from
+    the header, thus the only pass over the whole data is the building of
+    the level-of-detail pyramid, done in parallel with sequential access
+    hints. Other files are converted into a buffer owned by the loader.
+
+    The loader owns the data, so it has to outlive the graph's use of it,
+    just like the buffer passed to Graph::SetSharedBuffer().
+*/
+template<typename T>
+class GraphFile
+{
+    static_assert(std::is_same<T, float>::value
+               || std::is_same<T, double>::value, "");
+public:
+    explicit GraphFile() = default;
+    ~GraphFile() = default;
+    GraphFile(const GraphFile& other) = delete;
+    GraphFile(GraphFile&& other) = delete;
+    GraphFile& operator=(const GraphFile& other) = delete;
+    GraphFile& operator=(GraphFile&& other) = delete;
+public:
+    static constexpr uint32_t layout_interleaved_ = 0u;
+    static constexpr uint32_t layout_columns_ = 1u;
+    //! Map the file and check its header. Returns false and prints the reason on failure.
+    bool Open(const char* const p_path);
+    //! Set the points of the file as the data of the graph
+    void AttachTo(Graph<T>& p_graph);
+    unsigned int GetNpoints() const noexcept {
+        return static_cast<unsigned int>(header_.n_points_);
+    }
+    //! The data is used by the graph without copying
+    bool IsZeroCopy() const noexcept {
+        return header_.value_size_ == sizeof(T) && header_.layout_ == layout_interleaved_;
+    }
+    //! Write the points into a file readable by Open(). Returns false on failure.
+    static bool Write(const char* const p_path, const Vec2<T>* const p_xy,
+        const unsigned int p_n, const uint32_t p_layout = layout_interleaved_);
+private:
+    template<typename U>
+    void Convert(const U* const p_values);
+private:
+    MappedFile file_;
+    GraphFileHeader header_ = {};
+    std::vector<Vec2<T>> converted_; //!< Unless the data is zero copy
+};
+
+template class GraphFile<float>;
+template class GraphFile<double>;
+
+} // end of namespace tiny_graph_plot
+
+#include "graph_file_inline.h"
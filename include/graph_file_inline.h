@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+static constexpr char graph_file_magic[8] = { 'T', 'G', 'P', 'G', 'R', 'A', 'P', 'H' };
+static constexpr uint32_t graph_file_version = 1u;
+static constexpr uint32_t graph_file_flag_x_sorted = 1u << 0;
+static constexpr uint32_t graph_file_flag_range_valid = 1u << 1;
+
+template<typename T>
+inline bool GraphFile<T>::Open(const char* const p_path)
+{
+    converted_.clear();
+    header_ = GraphFileHeader{};
+    if (!file_.Open(p_path)) return false;
+    if (file_.GetSize() < sizeof(GraphFileHeader)) {
+        fprintf(stderr, "ERROR: '%s' is too small to be a graph file.\n", p_path);
+        file_.Close();
+        return false;
+    }
+    GraphFileHeader header;
+    memcpy(&header, file_.GetData(), sizeof(GraphFileHeader));
+    if (memcmp(header.magic_, graph_file_magic, sizeof(graph_file_magic)) != 0 ||
+        header.version_ != graph_file_version) {
+        fprintf(stderr, "ERROR: '%s' is not a graph file of version %u.\n",
+            p_path, graph_file_version);
+        file_.Close();
+        return false;
+    }
+    if ((header.value_size_ != 4u && header.value_size_ != 8u) ||
+        (header.layout_ != layout_interleaved_ && header.layout_ != layout_columns_)) {
+        fprintf(stderr, "ERROR: '%s' has an unknown value size or layout.\n", p_path);
+        file_.Close();
+        return false;
+    }
+    if (header.n_points_ > std::numeric_limits<unsigned int>::max() ||
+        (file_.GetSize() - sizeof(GraphFileHeader)) / (2u * header.value_size_) < header.n_points_) {
+        fprintf(stderr, "ERROR: '%s' is truncated or has too many points.\n", p_path);
+        file_.Close();
+        return false;
+    }
+    header_ = header;
+    return true;
+}
+
+template<typename T>
+template<typename U>
+inline void GraphFile<T>::Convert(const U* const p_values)
+{
+    const size_t n = static_cast<size_t>(header_.n_points_);
+    converted_.resize(n);
+    const bool columns = (header_.layout_ == layout_columns_);
+    Vec2<T>* const out = converted_.data();
+    const auto convert = [&](const size_t p_first, const size_t p_last) {
+        for (size_t i = p_first; i < p_last; i++) {
+            const U x = columns ? p_values[i] : p_values[2u * i];
+            const U y = columns ? p_values[n + i] : p_values[2u * i + 1u];
+            out[i] = Vec2<T>(static_cast<T>(x), static_cast<T>(y));
+        }
+    };
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const unsigned int n_chunks = 4u * pool.GetNthreads();
+    pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+        convert(n * i / n_chunks, n * (i + 1u) / n_chunks);
+    });
+}
+
+template<typename T>
+inline void GraphFile<T>::AttachTo(Graph<T>& p_graph)
+{
+    const unsigned int n = this->GetNpoints();
+    const void* const values = static_cast<const char*>(file_.GetData()) + sizeof(GraphFileHeader);
+    file_.AdviseSequential();
+    Vec2<T>* points;
+    if (this->IsZeroCopy()) {
+        points = static_cast<Vec2<T>*>(const_cast<void*>(values));
+    } else {
+        if (header_.value_size_ == sizeof(float)) {
+            this->Convert(static_cast<const float*>(values));
+        } else {
+            this->Convert(static_cast<const double*>(values));
+        }
+        points = converted_.data();
+    }
+    if (header_.flags_ & graph_file_flag_range_valid) {
+        const XYrange<T> range(
+            static_cast<T>(header_.x_min_), static_cast<T>(header_.x_max_ - header_.x_min_),
+            static_cast<T>(header_.y_min_), static_cast<T>(header_.y_max_ - header_.y_min_));
+        p_graph.SetSharedBuffer(n, points, range,
+            (header_.flags_ & graph_file_flag_x_sorted) != 0u);
+    } else {
+        p_graph.SetSharedBuffer(n, points);
+    }
+    file_.AdviseNormal();
+}
+
+template<typename T>
+inline bool GraphFile<T>::Write(const char* const p_path, const Vec2<T>* const p_xy,
+    const unsigned int p_n, const uint32_t p_layout)
+{
+    GraphFileHeader header = {};
+    memcpy(header.magic_, graph_file_magic, sizeof(graph_file_magic));
+    header.version_ = graph_file_version;
+    header.value_size_ = sizeof(T);
+    header.layout_ = p_layout;
+    header.n_points_ = p_n;
+    // The header describes the finite points, the same way Graph does
+    bool x_sorted = true;
+    bool range_valid = false;
+    for (unsigned int i = 0u; i < p_n; i++) {
+        if (i > 0u && !(p_xy[i - 1u].x() <= p_xy[i].x())) x_sorted = false;
+        const double x = static_cast<double>(p_xy[i].x());
+        const double y = static_cast<double>(p_xy[i].y());
+        if (!std::isfinite(x) || !std::isfinite(y)) continue;
+        if (!range_valid) {
+            header.x_min_ = header.x_max_ = x;
+            header.y_min_ = header.y_max_ = y;
+            range_valid = true;
+            continue;
+        }
+        header.x_min_ = std::fmin(header.x_min_, x);
+        header.x_max_ = std::fmax(header.x_max_, x);
+        header.y_min_ = std::fmin(header.y_min_, y);
+        header.y_max_ = std::fmax(header.y_max_, y);
+    }
+    header.flags_ = (x_sorted ? graph_file_flag_x_sorted : 0u) |
+                    (range_valid ? graph_file_flag_range_valid : 0u);
+
+    FILE* const f = fopen(p_path, "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "ERROR: failed to create '%s'.\n", p_path);
+        return false;
+    }
+    bool ok = (fwrite(&header, sizeof(GraphFileHeader), 1u, f) == 1u);
+    if (p_layout == layout_columns_) {
+        for (unsigned int c = 0u; c < 2u && ok; c++) {
+            for (unsigned int i = 0u; i < p_n && ok; i++) {
+                const T value = p_xy[i][c];
+                ok = (fwrite(&value, sizeof(T), 1u, f) == 1u);
+            }
+        }
+    } else if (p_n > 0u) {
+        ok = ok && (fwrite(p_xy, sizeof(Vec2<T>), p_n, f) == p_n);
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: failed to write '%s'.\n", p_path);
+    }
+    return ok;
+}
+
+} // end of namespace tiny_graph_plot
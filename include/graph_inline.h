@@ -1,15 +1,28 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 
+#include "simd_minmax.h"
+#include "thread_pool.h"
+
 namespace tiny_graph_plot
 {
 
 template<typename T>
 inline T Graph<T>::Evaluate(const T x) const
 {
+    if (n_points_ == 0u) return std::numeric_limits<T>::quiet_NaN();
     if (!this->xy_range_.IncludesX(x)) return std::numeric_limits<T>::quiet_NaN();
 
+    if (x_sorted_) {
+        const T xmin = this->points_[0].x();
+        const T xmax = this->points_[n_points_ - 1].x();
+        if (!(x >= xmin && x <= xmax)) return std::numeric_limits<T>::quiet_NaN();
+        if (x == xmax) return this->points_[n_points_ - 1].y();
+        return this->Interpolate(this->FindSegment(x), x);
+    }
+
     const T xmin = this->points_[0].x();
     const T xmax = this->points_[n_points_ - 1].x();
     if (x == xmin) return this->points_[0].y();
@@ -26,45 +39,645 @@ inline T Graph<T>::Evaluate(const T x) const
         }
         if (idxl < 0 || idxl >(int)n_points_ - 1) return std::numeric_limits<T>::quiet_NaN();
     }
-    const T p = (x - this->points_[idxl].x()) / (this->points_[idxl + 1].x() - this->points_[idxl].x());
-    const T y = p * (this->points_[idxl + 1].y() - this->points_[idxl].y()) + this->points_[idxl].y();
-    return y;
+    return this->Interpolate(static_cast<unsigned int>(idxl), x);
 }
 
 template<typename T>
-inline void Graph<T>::CalculateRanges() const
+inline void Graph<T>::EvaluateMany(const T* const xs, T* const ys, const size_t n) const
 {
-    unsigned int start_i = 0;
-    bool start_i_found = false;
-    for (start_i = 0; start_i < n_points_; start_i++) {
-        if (std::isfinite(this->points_[start_i].x()) &&
-            std::isfinite(this->points_[start_i].y())) {
-            start_i_found = true;
-            break;
+    if (!x_sorted_ || n_points_ < 2u) {
+        for (size_t i = 0; i < n; i++) {
+            ys[i] = this->Evaluate(xs[i]);
         }
+        return;
     }
-    unsigned int start_j = 0;
-    bool start_j_found = false;
-    for (start_j = 0; start_j < n_points_; start_j++) {
-        if (std::isfinite(this->points_[start_j].x()) &&
-            std::isfinite(this->points_[start_j].y())) {
-            start_j_found = true;
-            break;
+
+    // The queries are processed in groups of eval_lanes_. All the searches of
+    // a group advance in lockstep without branches, so the loops over the
+    // lanes can be vectorized and the cache misses of the lanes overlap.
+    const Vec2<T>* const p = this->points_;
+    const T* const xi = x_index_.data();
+    const unsigned int n_index = static_cast<unsigned int>(x_index_.size());
+    const T xmin = p[0].x();
+    const T xmax = p[n_points_ - 1].x();
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    for (size_t start = 0; start < n; start += eval_lanes_) {
+        const unsigned int n_lanes = static_cast<unsigned int>(
+            std::min(static_cast<size_t>(eval_lanes_), n - start));
+        T x[eval_lanes_];
+        unsigned int base[eval_lanes_];
+        for (unsigned int k = 0; k < eval_lanes_; k++) {
+            // Unused lanes repeat the first query
+            x[k] = xs[start + ((k < n_lanes) ? k : 0u)];
+            base[k] = 0u;
+        }
+        // The block of the index
+        unsigned int len = n_index;
+        while (len > 1u) {
+            const unsigned int half = len / 2u;
+            for (unsigned int k = 0; k < eval_lanes_; k++) {
+                base[k] = (xi[base[k] + half] <= x[k]) ? base[k] + half : base[k];
+            }
+            len -= half;
+        }
+        // The segment within the block
+        const unsigned int last = n_points_ - 2u;
+        for (unsigned int k = 0; k < eval_lanes_; k++) {
+            base[k] *= index_stride_;
+        }
+        len = index_stride_;
+        while (len > 1u) {
+            const unsigned int half = len / 2u;
+            for (unsigned int k = 0; k < eval_lanes_; k++) {
+                const unsigned int i = std::min(base[k] + half, last);
+                base[k] = (p[i].x() <= x[k]) ? i : base[k];
+            }
+            len -= half;
+        }
+        T y[eval_lanes_];
+        for (unsigned int k = 0; k < eval_lanes_; k++) {
+            const unsigned int i = std::min(base[k], last);
+            const Vec2<T>& p0 = p[i];
+            const Vec2<T>& p1 = p[i + 1u];
+            const T t = (x[k] - p0.x()) / (p1.x() - p0.x());
+            const T yk = t * (p1.y() - p0.y()) + p0.y();
+            // Same conventions as in Evaluate()
+            y[k] = (x[k] == xmax) ? p[n_points_ - 1].y() : yk;
+            y[k] = (x[k] >= xmin && x[k] <= xmax &&
+                    this->xy_range_.IncludesX(x[k])) ? y[k] : nan;
+        }
+        for (unsigned int k = 0; k < n_lanes; k++) {
+            ys[start + k] = y[k];
         }
     }
+}
 
-    if (!start_i_found || !start_j_found) {
-        fprintf(stderr, "ERROR: something is definitely wrong with the input data.\n");
+/**
+    Binary search (with a few steps of interpolation search in front of it)
+    for the largest 'lo' within [p_lo; p_hi) such that p_x[lo * p_stride] <= x,
+    given that p_x[p_lo * p_stride] <= x < p_x[p_hi * p_stride].
+*/
+template<typename T>
+static inline unsigned int SearchSorted(const T* const p_x, const size_t p_stride,
+    unsigned int p_lo, unsigned int p_hi, const unsigned int p_n_interp, const T x) noexcept
+{
+    for (unsigned int step = 0u; step < p_n_interp && p_hi - p_lo > 1u; step++) {
+        const T t = (x - p_x[p_lo * p_stride]) / (p_x[p_hi * p_stride] - p_x[p_lo * p_stride]);
+        if (!(t >= T(0.0) && t < T(1.0))) break; // Infinite coordinates
+        unsigned int mid = p_lo + static_cast<unsigned int>(t * static_cast<T>(p_hi - p_lo));
+        mid = std::min(std::max(mid, p_lo + 1u), p_hi - 1u);
+        if (p_x[mid * p_stride] <= x) {
+            p_lo = mid;
+        } else {
+            p_hi = mid;
+        }
+    }
+    while (p_hi - p_lo > 1u) {
+        const unsigned int mid = p_lo + (p_hi - p_lo) / 2u;
+        if (p_x[mid * p_stride] <= x) {
+            p_lo = mid;
+        } else {
+            p_hi = mid;
+        }
+    }
+    return p_lo;
+}
+
+/**
+    For the points sorted along x and xmin <= x < xmax find the segment
+    [idxl; idxl + 1] such that points_[idxl].x() <= x < points_[idxl + 1].x().
+    The block is first found in the compact x_index_ which stays in cache,
+    then only index_stride_ neighbouring points of the graph are touched.
+*/
+template<typename T>
+inline unsigned int Graph<T>::FindSegment(const T x) const noexcept
+{
+    const unsigned int n_index = static_cast<unsigned int>(x_index_.size());
+    // The past-the-end block boundary is xmax
+    unsigned int i_block = 0u;
+    if (n_index > 1u) {
+        if (x >= x_index_[n_index - 1u]) {
+            i_block = n_index - 1u;
+        } else {
+            i_block = SearchSorted(x_index_.data(), 1u, 0u, n_index - 1u,
+                max_interpolation_steps_, x);
+        }
+    }
+    const unsigned int lo = i_block * index_stride_;
+    const unsigned int hi = std::min(lo + index_stride_, n_points_ - 1u);
+    // Vec2 stores x and y next to each other
+    static_assert(sizeof(Vec2<T>) == 2u * sizeof(T), "");
+    return SearchSorted(this->points_[0].GetData(), 2u, lo, hi, 0u, x);
+}
+
+/**
+    Keep every index_stride_-th x coordinate of the sorted graph
+    starting from point 'p_first'.
+*/
+template<typename T>
+inline void Graph<T>::UpdateSearchIndex(const unsigned int p_first)
+{
+    if (!x_sorted_) {
+        x_index_.clear();
+        return;
+    }
+    const unsigned int n_index = (n_points_ + index_stride_ - 1u) / index_stride_;
+    x_index_.resize(n_index);
+    for (unsigned int i = p_first / index_stride_; i < n_index; i++) {
+        x_index_[i] = this->points_[i * index_stride_].x();
+    }
+}
+
+template<typename T>
+inline T Graph<T>::Interpolate(const unsigned int idxl, const T x) const noexcept
+{
+    const Vec2<T>& p0 = this->points_[idxl];
+    const Vec2<T>& p1 = this->points_[idxl + 1];
+    const T p = (x - p0.x()) / (p1.x() - p0.x());
+    return p * (p1.y() - p0.y()) + p0.y();
+}
+
+template<typename T>
+inline bool Graph<T>::Reserve(const unsigned int p_capacity)
+{
+    if (!shared_points_ && p_capacity <= capacity_) return true;
+    if (p_capacity > max_capacity_) {
+        fprintf(stderr, "ERROR: a graph can not hold %u points, at most %u.\n", p_capacity, max_capacity_);
+        return false;
+    }
+    const unsigned int capacity = std::max(std::max(p_capacity, n_points_), min_capacity_);
+    Vec2<T>* points;
+    if (shared_points_ || this->points_ == nullptr) {
+        // The shared buffer belongs to the user - copy it into our own storage
+        points = static_cast<Vec2<T>*>(malloc(capacity * sizeof(Vec2<T>)));
+        if (points != nullptr && n_points_ > 0u) {
+            std::copy(this->points_, this->points_ + n_points_, points);
+        }
+    } else {
+        points = static_cast<Vec2<T>*>(realloc(this->points_, capacity * sizeof(Vec2<T>)));
+    }
+    if (points == nullptr) {
+        fprintf(stderr, "ERROR: failed to allocate memory for %u points.\n", capacity);
+        return false;
+    }
+    this->points_ = points;
+    shared_points_ = false;
+    capacity_ = capacity;
+    this->UpdateSizeInfo();
+    return true;
+}
+
+template<typename T>
+inline void Graph<T>::Append(const Vec2<T>* const p_xy, const unsigned int p_n)
+{
+    if (p_n == 0u) return;
+    const unsigned int old_n = n_points_;
+    // In 64 bits, neither the sum nor the doubling may wrap
+    const unsigned long long n_needed = static_cast<unsigned long long>(old_n) + p_n;
+    if (n_needed > max_capacity_) {
+        fprintf(stderr, "ERROR: a graph can not hold %llu points, at most %u.\n", n_needed, max_capacity_);
         return;
     }
+    if (shared_points_ || n_needed > capacity_) {
+        // Grow geometrically so that appending is amortized O(1) per point
+        const unsigned long long capacity = std::min(std::max(n_needed, 2ull * capacity_),
+            static_cast<unsigned long long>(max_capacity_));
+        if (!this->Reserve(static_cast<unsigned int>(capacity))) return;
+    }
+    std::copy(p_xy, p_xy + p_n, this->points_ + old_n);
+    n_points_ += p_n;
+    this->IncludeInRanges(old_n);
+    this->DetectSortedness(old_n);
+    this->UpdateSearchIndex(old_n);
+    if (x_sorted_) {
+        this->UpdateLevels(old_n);
+    } else {
+        lod_levels_.clear();
+        lod_non_finite_.clear();
+    }
+    this->UpdateSizeInfo();
+}
+
+template<typename T>
+inline bool Graph<T>::EnableQueue(const unsigned int p_capacity)
+{
+    if (queue_.IsInitialized()) {
+        fprintf(stderr, "ERROR: the queue of the graph is already enabled.\n");
+        return false;
+    }
+    return queue_.Init(p_capacity);
+}
+
+template<typename T>
+inline unsigned int Graph<T>::DrainQueue()
+{
+    if (!queue_.IsInitialized()) return 0u;
+    const size_t n = queue_.Drain([this](const Vec2<T>* const p_xy, const size_t p_n) {
+        this->Append(p_xy, static_cast<unsigned int>(p_n));
+    });
+    return static_cast<unsigned int>(n);
+}
+
+template<typename T>
+inline void Graph<T>::CalculateRanges()
+{
+    range_valid_ = false;
+    this->IncludeInRanges(0u);
+    if (!range_valid_) {
+        fprintf(stderr, "ERROR: something is definitely wrong with the input data.\n");
+    }
+}
+
+template<typename T>
+inline void Graph<T>::IncludeInRanges(const unsigned int p_first)
+{
+    if (p_first >= n_points_) return;
+    const size_t n = n_points_ - p_first;
+    static_assert(sizeof(Vec2<T>) == 2u * sizeof(T), "");
+    const T* const xy = this->points_[p_first].GetData();
+
+    T lo[2];
+    T hi[2];
+    if (n < parallel_min_points_) {
+        MinMaxFinitePoints(xy, n, lo, hi);
+    } else {
+        // Each chunk is reduced separately, then the results are merged
+        ThreadPool& pool = ThreadPool::GetGlobal();
+        const unsigned int n_chunks = 4u * pool.GetNthreads();
+        std::vector<T> chunk_lo(2u * n_chunks);
+        std::vector<T> chunk_hi(2u * n_chunks);
+        pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+            const size_t first = n * i / n_chunks;
+            const size_t last = n * (i + 1u) / n_chunks;
+            MinMaxFinitePoints(xy + 2u * first, last - first,
+                &chunk_lo[2u * i], &chunk_hi[2u * i]);
+        });
+        lo[0] = lo[1] = std::numeric_limits<T>::infinity();
+        hi[0] = hi[1] = -std::numeric_limits<T>::infinity();
+        for (unsigned int i = 0u; i < n_chunks; i++) {
+            lo[0] = std::min(lo[0], chunk_lo[2u * i + 0u]);
+            lo[1] = std::min(lo[1], chunk_lo[2u * i + 1u]);
+            hi[0] = std::max(hi[0], chunk_hi[2u * i + 0u]);
+            hi[1] = std::max(hi[1], chunk_hi[2u * i + 1u]);
+        }
+    }
+    if (!(lo[0] <= hi[0])) return; // No finite points
 
-    this->xy_range_ = XYrange<T>(
-        this->points_[start_i].x(), this->points_[start_j].x() - this->points_[start_i].x(),
-        this->points_[start_i].y(), this->points_[start_j].y() - this->points_[start_i].y());
-    for (unsigned int i = 0; i < n_points_; i++) {
-        this->xy_range_.Include(this->points_[i]);
+    const XYrange<T> new_range(lo[0], hi[0] - lo[0], lo[1], hi[1] - lo[1]);
+    if (range_valid_) {
+        data_range_.Include(new_range);
+    } else {
+        data_range_ = new_range;
+        range_valid_ = true;
     }
+    this->xy_range_ = data_range_;
     this->xy_range_.FixDegenerateCases();
 }
 
+template<typename T>
+inline void Graph<T>::DetectSortedness(const unsigned int p_first)
+{
+    if (p_first == 0u) x_sorted_ = true;
+    if (!x_sorted_) return;
+    for (unsigned int i = std::max(p_first, 1u); i < n_points_; i++) {
+        // Written such that NaNs also break the sortedness
+        if (!(this->points_[i - 1].x() <= this->points_[i].x())) {
+            x_sorted_ = false;
+            break;
+        }
+    }
+}
+
+/**
+    Reduce each window of 'n' consecutive points starting at 'p_in' into four
+    points: first, minimum, maximum and last, written in their original order.
+    Non-finite y values are ignored when searching for the extrema.
+    Returns true if there are such values.
+*/
+template<typename T>
+static inline bool ReduceM4(const Vec2<T>* const p_in, const unsigned int n, Vec2<T>* const o_out)
+{
+    unsigned int imin = 0u;
+    unsigned int imax = 0u;
+    bool found = false;
+    bool non_finite = false;
+    for (unsigned int i = 0u; i < n; i++) {
+        const T y = p_in[i].y();
+        if (!std::isfinite(y)) {
+            non_finite = true;
+            continue;
+        }
+        if (!found) {
+            imin = imax = i;
+            found = true;
+            continue;
+        }
+        if (y < p_in[imin].y()) imin = i;
+        if (y > p_in[imax].y()) imax = i;
+    }
+    o_out[0] = p_in[0];
+    o_out[1] = p_in[std::min(imin, imax)];
+    o_out[2] = p_in[std::max(imin, imax)];
+    o_out[3] = p_in[n - 1u];
+    return non_finite;
+}
+
+template<typename T>
+inline void Graph<T>::BuildLevels()
+{
+    lod_levels_.clear();
+    lod_non_finite_.clear();
+    if (!x_sorted_) return;
+    this->UpdateLevels(0u);
+}
+
+/**
+    Rebuild the buckets of all the levels which depend on the points
+    starting from 'p_first'. Levels which become large enough are created.
+*/
+template<typename T>
+inline void Graph<T>::UpdateLevels(const unsigned int p_first)
+{
+    unsigned int changed = p_first; // First changed point of the source level
+    unsigned int src_n = n_points_;
+    unsigned int bucket = lod_first_bucket_size_;
+    for (size_t i_level = 0u; ; i_level++) {
+        const unsigned int n_buckets = (src_n + bucket - 1u) / bucket;
+        if (4u * n_buckets < lod_min_level_size_) break;
+        if (i_level == lod_levels_.size()) {
+            // A new level - build it completely
+            lod_levels_.emplace_back();
+            lod_non_finite_.emplace_back();
+            changed = 0u;
+        }
+        const Vec2<T>* const src = (i_level == 0u) ?
+            this->points_ : lod_levels_[i_level - 1u].data();
+        // The non-finite points of a bucket are not necessarily among its four points
+        const unsigned char* const src_non_finite = (i_level == 0u) ?
+            nullptr : lod_non_finite_[i_level - 1u].data();
+        std::vector<Vec2<T>>& level = lod_levels_[i_level];
+        std::vector<unsigned char>& non_finite = lod_non_finite_[i_level];
+        level.resize(4u * n_buckets);
+        non_finite.resize(n_buckets);
+        const auto reduce_buckets = [&](const unsigned int i_first, const unsigned int i_last) {
+            for (unsigned int i = i_first; i < i_last; i++) {
+                const unsigned int first = i * bucket;
+                const unsigned int n = std::min(bucket, src_n - first);
+                bool has_non_finite = ReduceM4(src + first, n, level.data() + 4u * i);
+                if (src_non_finite != nullptr) {
+                    for (unsigned int j = first / 4u; j < (first + n) / 4u; j++) {
+                        has_non_finite = has_non_finite || (src_non_finite[j] != 0u);
+                    }
+                }
+                non_finite[i] = has_non_finite ? 1u : 0u;
+            }
+        };
+        const unsigned int first_bucket = changed / bucket;
+        const unsigned int n_changed = n_buckets - first_bucket;
+        if (static_cast<size_t>(n_changed) * bucket < parallel_min_points_) {
+            reduce_buckets(first_bucket, n_buckets);
+        } else {
+            // The buckets are independent, each chunk of them is reduced by one task
+            ThreadPool& pool = ThreadPool::GetGlobal();
+            const unsigned int n_chunks = 4u * pool.GetNthreads();
+            pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+                const unsigned int i_first = first_bucket +
+                    static_cast<unsigned int>(static_cast<size_t>(n_changed) * i / n_chunks);
+                const unsigned int i_last = first_bucket +
+                    static_cast<unsigned int>(static_cast<size_t>(n_changed) * (i + 1u) / n_chunks);
+                reduce_buckets(i_first, i_last);
+            });
+        }
+        // Next levels - merge groups of buckets of the previous level
+        changed = 4u * (changed / bucket);
+        src_n = 4u * n_buckets;
+        bucket = lod_next_bucket_size_;
+    }
+}
+
+template<typename T>
+inline unsigned int Graph<T>::GetNlevelsReserved() const noexcept
+{
+    if (!x_sorted_) return 1u;
+    unsigned int n_levels = 1u;
+    while (this->GetLevelCapacity(n_levels) >= lod_min_level_size_) {
+        n_levels++;
+    }
+    return n_levels;
+}
+
+template<typename T>
+inline unsigned int Graph<T>::GetLevelCapacity(const unsigned int i_level) const noexcept
+{
+    unsigned int capacity = capacity_;
+    unsigned int bucket = lod_first_bucket_size_;
+    for (unsigned int l = 1u; l <= i_level; l++) {
+        capacity = 4u * ((capacity + bucket - 1u) / bucket);
+        bucket = lod_next_bucket_size_;
+    }
+    return capacity;
+}
+
+template<typename T>
+inline unsigned int Graph<T>::GetLevelOffset(const unsigned int i_level) const noexcept
+{
+    return level_offsets_[i_level];
+}
+
+template<typename T>
+inline unsigned int Graph<T>::GetLevelNfinal(const unsigned int i_level) const noexcept
+{
+    // Only complete buckets built from final points of the previous level are final
+    unsigned int n_final = n_points_;
+    unsigned int bucket = lod_first_bucket_size_;
+    for (unsigned int l = 1u; l <= i_level; l++) {
+        n_final = 4u * (n_final / bucket);
+        bucket = lod_next_bucket_size_;
+    }
+    return n_final;
+}
+
+template<typename T>
+inline void Graph<T>::UpdateSizeInfo()
+{
+    // The offsets only depend on the capacity and are looked up per vertex, see GetVertex()
+    const unsigned int n_levels = this->GetNlevelsReserved();
+    level_offsets_.resize(n_levels + 1u);
+    level_offsets_[0] = 0u;
+    for (unsigned int l = 0u; l < n_levels; l++) {
+        const unsigned int n_chunks =
+            (this->GetLevelCapacity(l) + vertex_chunk_size_ - 1u) / vertex_chunk_size_;
+        level_offsets_[l + 1u] = level_offsets_[l] + n_chunks * vertex_chunk_size_;
+    }
+    const unsigned int n_v = level_offsets_[n_levels];
+    this->size_info_ = SizeInfo(n_v, n_v, (n_v > 0u) ? n_v - 1u : 0u, 0u);
+}
+
+template<typename T>
+inline const Vec2<T>* Graph<T>::GetLevelData(const unsigned int i_level, unsigned int& o_n) const noexcept
+{
+    if (i_level == 0u) {
+        o_n = n_points_;
+        return this->points_;
+    }
+    const std::vector<Vec2<T>>& level = lod_levels_[i_level - 1u];
+    o_n = static_cast<unsigned int>(level.size());
+    return level.data();
+}
+
+/**
+    First, lowest, highest and last point of a part of a pixel column, see
+    Graph::DecimateToColumns(). The key of a vertex orders it as the original
+    point: 4 * the first sample of its bucket + its place in the bucket.
+*/
+template<typename T>
+struct ColumnM4 {
+    struct Vertex {
+        unsigned int v_;
+        unsigned long long key_;
+        T y_;
+    };
+    Vertex first_;
+    Vertex min_;
+    Vertex max_;
+    Vertex last_;
+    bool empty_ = true;
+    void Add(const unsigned int p_v, const unsigned long long p_key, const T p_y) noexcept {
+        const Vertex vertex{ p_v, p_key, p_y };
+        if (empty_) {
+            first_ = min_ = max_ = vertex;
+            empty_ = false;
+        } else {
+            if (p_y < min_.y_) min_ = vertex;
+            if (p_y > max_.y_) max_ = vertex;
+        }
+        last_ = vertex;
+    }
+    void Flush(std::vector<unsigned int>& o_vertices) {
+        if (empty_) return;
+        const bool min_first = (min_.key_ <= max_.key_);
+        const unsigned int vertices[4] = { first_.v_,
+            min_first ? min_.v_ : max_.v_, min_first ? max_.v_ : min_.v_, last_.v_ };
+        for (const unsigned int v : vertices) {
+            if (o_vertices.empty() || o_vertices.back() != v) o_vertices.push_back(v);
+        }
+        empty_ = true;
+    }
+};
+
+template<typename T>
+inline bool Graph<T>::DecimateToColumns(const double xlow, const double pixel_dx, const unsigned int n_columns,
+    std::vector<unsigned int>& o_vertices) const
+{
+    o_vertices.clear();
+    if (!x_sorted_ || n_points_ == 0u || n_columns == 0u || !(pixel_dx > 0.0)) return false;
+    const Vec2<T>* const points = this->points_;
+    // The same rounding for all the points, so that the columns do not overlap
+    const auto column_of = [xlow, pixel_dx](const T x) {
+        return std::floor((static_cast<double>(x) - xlow) / pixel_dx);
+    };
+    // The first point in [p_from; p_to) past column 'c', the block is found in the compact x_index_
+    const auto column_end = [&](const unsigned int p_from, const unsigned int p_to, const double c) {
+        const T* const xi = x_index_.data();
+        const unsigned int n_index = static_cast<unsigned int>(x_index_.size());
+        const unsigned int i_block = static_cast<unsigned int>(std::partition_point(
+            xi + std::min(p_from / index_stride_ + 1u, n_index), xi + n_index,
+            [&](const T x) { return column_of(x) <= c; }) - xi);
+        const unsigned int hi = std::min(p_to, i_block * index_stride_);
+        const unsigned int lo = std::min(std::max(p_from, (i_block - 1u) * index_stride_), hi);
+        return static_cast<unsigned int>(std::partition_point(points + lo, points + hi,
+            [&](const Vec2<T>& p) { return column_of(p.x()) <= c; }) - points);
+    };
+    const unsigned int first = column_end(0u, n_points_, -1.0);
+    const unsigned int last = column_end(first, n_points_, static_cast<double>(n_columns) - 1.0);
+    if (static_cast<unsigned long long>(last - first) <=
+        static_cast<unsigned long long>(decimation_min_points_) * n_columns) return false;
+
+    // Samples per bucket of each level
+    const unsigned int n_levels = this->GetNlevels();
+    std::vector<size_t> bucket_size(n_levels, 1u);
+    for (unsigned int l = 1u; l < n_levels; l++) {
+        bucket_size[l] = bucket_size[l - 1u] * ((l == 1u) ? lod_first_bucket_size_ : lod_next_bucket_size_ / 4u);
+    }
+    static_assert(lod_next_bucket_size_ % 4u == 0u, "A bucket has to merge whole buckets");
+
+    ColumnM4<T> column;
+    unsigned int a = 0u; // Samples [a; b) of the current column
+    unsigned int b = 0u;
+    // Whole buckets without non-finite points are taken from the levels, the rest is split
+    const auto visit = [&](const auto& self, const unsigned int l, const size_t i) -> void {
+        const size_t s = i * bucket_size[l];
+        const size_t e = std::min(s + bucket_size[l], static_cast<size_t>(n_points_));
+        if (e <= a || s >= b) return;
+        if (l == 0u) {
+            const T y = points[s].y();
+            if (std::isfinite(y)) {
+                column.Add(static_cast<unsigned int>(s), 4ull * s, y);
+            } else {
+                column.Flush(o_vertices);
+                o_vertices.push_back(static_cast<unsigned int>(s));
+            }
+        } else if (a <= s && e <= b && lod_non_finite_[l - 1u][i] == 0u) {
+            const Vec2<T>* const bucket = lod_levels_[l - 1u].data() + 4u * i;
+            for (unsigned int k = 0u; k < 4u; k++) {
+                column.Add(level_offsets_[l] + static_cast<unsigned int>(4u * i) + k, 4ull * s + k, bucket[k].y());
+            }
+        } else {
+            const size_t n_children = bucket_size[l] / bucket_size[l - 1u];
+            const size_t first_child = i * n_children;
+            const size_t last_child = std::min(first_child + n_children,
+                (e + bucket_size[l - 1u] - 1u) / bucket_size[l - 1u]);
+            for (size_t child = first_child; child < last_child; child++) {
+                self(self, l - 1u, child);
+            }
+        }
+    };
+
+    // One more point on each side so that the lines leaving the columns are drawn
+    if (first > 0u) o_vertices.push_back(first - 1u);
+    const unsigned int top = n_levels - 1u;
+    for (a = first; a < last; a = b) {
+        b = column_end(a, last, column_of(points[a].x()));
+        for (size_t i = a / bucket_size[top]; i * bucket_size[top] < b; i++) {
+            visit(visit, top, i);
+        }
+        column.Flush(o_vertices);
+    }
+    if (last < n_points_) o_vertices.push_back(last);
+    return true;
+}
+
+template<typename T>
+inline const Vec2<T>& Graph<T>::GetVertex(const unsigned int i_vertex) const noexcept
+{
+    // The last level starting at or before the vertex
+    const auto level_end = level_offsets_.begin() + this->GetNlevels();
+    const unsigned int i_level = static_cast<unsigned int>(
+        std::upper_bound(level_offsets_.begin() + 1, level_end, i_vertex) - level_offsets_.begin()) - 1u;
+    unsigned int n;
+    return this->GetLevelData(i_level, n)[i_vertex - level_offsets_[i_level]];
+}
+
+template<typename T>
+inline void Graph<T>::GetVisibleSpan(const unsigned int i_level, const T xlow, const T xhigh,
+    unsigned int& o_first, unsigned int& o_n) const noexcept
+{
+    unsigned int n;
+    const Vec2<T>* const data = this->GetLevelData(i_level, n);
+    if (!x_sorted_ || n == 0u) {
+        o_first = 0u;
+        o_n = n;
+        return;
+    }
+    auto less_x = [](const Vec2<T>& p, const T x) { return p.x() < x; };
+    auto greater_x = [](const T x, const Vec2<T>& p) { return x < p.x(); };
+    const Vec2<T>* const lo = std::lower_bound(data, data + n, xlow, less_x);
+    const Vec2<T>* const hi = std::upper_bound(lo, data + n, xhigh, greater_x);
+    // One more point on each side so that the lines leaving the range are drawn
+    const unsigned int first = static_cast<unsigned int>(lo - data);
+    const unsigned int last = static_cast<unsigned int>(hi - data);
+    o_first = (first > 0u) ? first - 1u : 0u;
+    o_n = std::min(last + 1u, n) - o_first;
+}
+
 } // end of namespace tiny_graph_plot
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "graph.h"
 #include "histogram1d.h"
+#include "histogram2d.h"
 
 namespace tiny_graph_plot
 {
@@ -22,6 +23,9 @@ public:
 		for (Histogram1d<T, unsigned long>* h : histograms_) {
 			delete h;
 		}
+		for (Histogram2d<T, unsigned long>* h : histograms2d_) {
+			delete h;
+		}
 	}
     GraphManager(const GraphManager& other) = delete;
     GraphManager(GraphManager&& other) = delete;
@@ -38,9 +42,31 @@ public:
 		histograms_.push_back(new_histo);
 		return *new_histo;
 	}
+	Histogram2d<T, unsigned long>& CreateHistogram2d() {
+		Histogram2d<T, unsigned long>* new_histo = new Histogram2d<T, unsigned long>();
+		histograms2d_.push_back(new_histo);
+		return *new_histo;
+	}
+	/**
+		Append the points pushed from other threads to the graphs, see
+		Graph::Push(). The event loop of the canvas manager does this once
+		per iteration, call it yourself when drawing without that loop.
+		Drawing thread. Returns true if some graph has a queue.
+	*/
+	bool DrainQueues() {
+		bool queues = false;
+		for (Graph<T>* gr : graphs_) {
+			if (gr->HasQueue()) {
+				gr->DrainQueue();
+				queues = true;
+			}
+		}
+		return queues;
+	}
 private:
 	std::vector<Graph<T>*> graphs_;
 	std::vector<Histogram1d<T, unsigned long>*> histograms_;
+	std::vector<Histogram2d<T, unsigned long>*> histograms2d_;
 };
 
 template class GraphManager<float>;
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "graph.h"
+#include "mapped_file.h"
+
+namespace tiny_graph_plot
+{
+
+/**
+    Loader of text files with one point per line, such as CSV exports.
+
+    The fields of a line are separated by a comma, a semicolon or by
+    whitespace, spaces around a comma or a semicolon are allowed. Any two
+    columns may be chosen as x and y. Lines whose chosen fields are not
+    numbers, like a header, comments or empty lines, are skipped.
+
+    The file is mapped into memory and split into chunks at line boundaries.
+    The chunks are parsed in parallel directly into the buffer of points.
+    The loader owns the points, so it has to outlive the graph's use of them,
+    just like the buffer passed to Graph::SetSharedBuffer().
+*/
+template<typename T>
+class GraphTextFile
+{
+    static_assert(std::is_same<T, float>::value
+               || std::is_same<T, double>::value, "");
+public:
+    explicit GraphTextFile() = default;
+    ~GraphTextFile() {
+        if (points_ != nullptr) free(points_);
+    }
+    GraphTextFile(const GraphTextFile& other) = delete;
+    GraphTextFile(GraphTextFile&& other) = delete;
+    GraphTextFile& operator=(const GraphTextFile& other) = delete;
+    GraphTextFile& operator=(GraphTextFile&& other) = delete;
+public:
+    //! Columns are counted from 0. Returns false and prints the reason on failure.
+    bool Load(const char* const p_path,
+              const unsigned int p_x_column = 0u, const unsigned int p_y_column = 1u);
+    //! Set the loaded points as the data of the graph
+    void AttachTo(Graph<T>& p_graph);
+    unsigned int GetNpoints() const noexcept { return n_points_; }
+    //! Number of lines, including the empty ones, which did not contain a point
+    size_t GetNskippedLines() const noexcept { return n_skipped_lines_; }
+private:
+    static bool ParseLine(const char* p_begin, const char* const p_end,
+        const unsigned int p_x_column, const unsigned int p_y_column, Vec2<T>& o_point);
+private:
+    static constexpr size_t chunk_min_size_ = 1u << 20; //!< Smaller files are parsed by one thread
+    Vec2<T>* points_ = nullptr; //!< Not initialized before parsing, hence malloc
+    unsigned int n_points_ = 0u;
+    size_t n_skipped_lines_ = 0u;
+};
+
+template class GraphTextFile<float>;
+template class GraphTextFile<double>;
+
+} // end of namespace tiny_graph_plot
+
+#include "graph_text_file_inline.h"
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+static inline bool IsFieldSpace(const char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool IsFieldEnd(const char c) noexcept
+{
+    return c == ',' || c == ';' || IsFieldSpace(c);
+}
+
+template<typename T>
+inline bool GraphTextFile<T>::ParseLine(const char* p_begin, const char* const p_end,
+    const unsigned int p_x_column, const unsigned int p_y_column, Vec2<T>& o_point)
+{
+    const unsigned int last_column = std::max(p_x_column, p_y_column);
+    T x = T(0.0);
+    T y = T(0.0);
+    const char* p = p_begin;
+    for (unsigned int column = 0u; column <= last_column; column++) {
+        while (p < p_end && IsFieldSpace(*p)) p++;
+        const char* field_end = p;
+        while (field_end < p_end && !IsFieldEnd(*field_end)) field_end++;
+        if (column == p_x_column || column == p_y_column) {
+            // from_chars() does not accept the plus sign
+            const char* const first = (p < field_end && *p == '+') ? p + 1 : p;
+            T value;
+            const std::from_chars_result res = std::from_chars(first, field_end, value);
+            if (res.ec != std::errc() || res.ptr != field_end) return false;
+            if (column == p_x_column) x = value;
+            if (column == p_y_column) y = value;
+        }
+        // Skip the separator: whitespace and at most one comma or semicolon
+        p = field_end;
+        while (p < p_end && IsFieldSpace(*p)) p++;
+        if (p < p_end && (*p == ',' || *p == ';')) p++;
+    }
+    o_point = Vec2<T>(x, y);
+    return true;
+}
+
+template<typename T>
+inline bool GraphTextFile<T>::Load(const char* const p_path,
+    const unsigned int p_x_column, const unsigned int p_y_column)
+{
+    if (points_ != nullptr) free(points_);
+    points_ = nullptr;
+    n_points_ = 0u;
+    n_skipped_lines_ = 0u;
+    MappedFile file;
+    if (!file.Open(p_path)) return false;
+    file.AdviseSequential();
+    const char* const text = static_cast<const char*>(file.GetData());
+    const char* const end = text + file.GetSize();
+    const auto line_end = [end](const char* const p) {
+        const void* const eol = memchr(p, '\n', static_cast<size_t>(end - p));
+        return (eol != nullptr) ? static_cast<const char*>(eol) : end;
+    };
+
+    // The lines before the first point, e.g. a header, are skipped here,
+    // so that normally each chunk is parsed right into its final place.
+    const char* begin = text;
+    while (begin < end) {
+        const char* const eol = line_end(begin);
+        Vec2<T> point;
+        if (ParseLine(begin, eol, p_x_column, p_y_column, point)) break;
+        n_skipped_lines_++;
+        begin = (eol < end) ? eol + 1 : end;
+    }
+
+    // Split the rest into chunks of whole lines
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const size_t size = static_cast<size_t>(end - begin);
+    const unsigned int n_chunks = static_cast<unsigned int>(std::max(size_t(1u),
+        std::min(size_t(4u * pool.GetNthreads()), size / chunk_min_size_)));
+    std::vector<const char*> bounds(n_chunks + 1u);
+    bounds[0] = begin;
+    bounds[n_chunks] = end;
+    for (unsigned int i = 1u; i < n_chunks; i++) {
+        const char* const p = std::max(begin + size * i / n_chunks, bounds[i - 1u]);
+        const char* const eol = line_end(p);
+        bounds[i] = (eol < end) ? eol + 1 : end;
+    }
+
+    // 1. Count the lines, each line may hold a point
+    std::vector<size_t> n_lines(n_chunks);
+    pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+        const char* const first = bounds[i];
+        const char* const last = bounds[i + 1u];
+        n_lines[i] = static_cast<size_t>(std::count(first, last, '\n'));
+        if (last > first && *(last - 1) != '\n') n_lines[i]++; // No newline at the end
+    });
+    std::vector<size_t> line_offset(n_chunks + 1u, 0u);
+    for (unsigned int i = 0u; i < n_chunks; i++) {
+        line_offset[i + 1u] = line_offset[i] + n_lines[i];
+    }
+    if (line_offset[n_chunks] > std::numeric_limits<unsigned int>::max()) {
+        fprintf(stderr, "ERROR: '%s' has too many lines.\n", p_path);
+        return false;
+    }
+
+    // 2. Parse the chunks, the points of each chunk start at its first line
+    points_ = static_cast<Vec2<T>*>(malloc(std::max(line_offset[n_chunks], size_t(1u)) * sizeof(Vec2<T>)));
+    if (points_ == nullptr) {
+        fprintf(stderr, "ERROR: failed to allocate memory for %zu points.\n", line_offset[n_chunks]);
+        return false;
+    }
+    std::vector<size_t> n_parsed(n_chunks, 0u);
+    pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+        Vec2<T>* const out = points_ + line_offset[i];
+        size_t n = 0u;
+        const char* p = bounds[i];
+        const char* const last = bounds[i + 1u];
+        while (p < last) {
+            const char* const eol = line_end(p);
+            if (ParseLine(p, eol, p_x_column, p_y_column, out[n])) n++;
+            p = (eol < last) ? eol + 1 : last;
+        }
+        n_parsed[i] = n;
+    });
+
+    // 3. Close the gaps left by the skipped lines, if any
+    size_t n_points = 0u;
+    for (unsigned int i = 0u; i < n_chunks; i++) {
+        if (n_points != line_offset[i]) {
+            std::copy(points_ + line_offset[i], points_ + line_offset[i] + n_parsed[i],
+                      points_ + n_points);
+        }
+        n_points += n_parsed[i];
+        n_skipped_lines_ += n_lines[i] - n_parsed[i];
+    }
+    n_points_ = static_cast<unsigned int>(n_points);
+    if (n_points == 0u) {
+        fprintf(stderr, "ERROR: no points found in '%s'.\n", p_path);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+inline void GraphTextFile<T>::AttachTo(Graph<T>& p_graph)
+{
+    p_graph.SetSharedBuffer(n_points_, points_);
+}
+
+} // end of namespace tiny_graph_plot
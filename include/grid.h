@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include "tiny_gl_text_renderer/data_types.h"
 #include "xy_range.h"
 
@@ -31,7 +33,14 @@ public:
     Grid& operator=(Grid&& other) = delete;
 public:
     int CalculateStep(XYrange<T> visrange, const T vw, const T vh);
+    /**
+        The vertices are relative to the center of 'visrange', see
+        Canvas::_visrange_to_clip_rtc, so the grid is built again for each
+        visible range. Returns 1 if nothing changed since the previous call.
+    */
     int BuildGrid(XYrange<T> visrange, XYrange<T> totalrange);
+    //! Force the next BuildGrid() call to rebuild the grid, e.g. when the total range changed
+    void Invalidate() noexcept { n_vertices_ = 0u; }
     const vertex_colored_t* GetVerticesData(unsigned int& o_n) const noexcept {
         o_n = n_vertices_;
         return vertices_;
@@ -50,6 +59,14 @@ public:
     T GetFineYstep()   const noexcept { return fine_step_y_; }
     T GetCoarseXstep() const noexcept { return coarse_step_x_; }
     T GetCoarseYstep() const noexcept { return coarse_step_y_; }
+    /**
+        Lines at the multiples of 'p_step' within [p_min; p_max], as placed by
+        BuildGrid(), without building them. Returns their number, 'o_first' is
+        the lowest one. Used by the procedural grid, see Canvas::SetProceduralGrid().
+    */
+    static unsigned int CountLines(const T p_min, const T p_max, const T p_step, T& o_first) noexcept;
+    //! Text of the value of a line at a multiple of 'p_step', with as many digits as the step needs
+    static void FormatValue(const double p_value, const double p_step, char* const o_buf, const size_t p_size) noexcept;
 private:
     static constexpr unsigned int coarse_grid_factor_ = 5u;
     static constexpr unsigned int cell_size_in_pix_min_ = 20u;
@@ -60,6 +77,8 @@ private:
     T fine_step_y_ = T(0.2);
     T coarse_step_x_ = T(1.0); //!< fine_step_x_ * coarse_grid_factor_
     T coarse_step_y_ = T(1.0); //!< fine_step_y_ * coarse_grid_factor_
+    XYrange<T> visrange_;   //!< Of the previous BuildGrid() call
+    XYrange<T> totalrange_; //!< Of the previous BuildGrid() call
     unsigned int n_vertices_       = 0u;
     unsigned int n_wires_fine_x_   = 0u; //!< Number of vertical wires of the fine grid along X direction
     unsigned int n_wires_fine_y_   = 0u; //!< Number of horizontal wires of the fine grid along Y direction
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
 namespace tiny_graph_plot
 {
 
@@ -59,34 +63,27 @@ inline int Grid<T>::CalculateStep(XYrange<T> visrange, const T vw, const T vh)
 template<typename T>
 inline int Grid<T>::BuildGrid(XYrange<T> visrange, XYrange<T> totalrange)
 {
+    if (n_vertices_ != 0u && visrange == visrange_ && totalrange == totalrange_) {
+        // The grid should not be changed
+        return 1;
+    }
+    visrange_ = visrange;
+    totalrange_ = totalrange;
+
     const T& xmin = std::fmax(visrange.lowx(),  totalrange.lowx());
     const T& xmax = std::fmin(visrange.highx(), totalrange.highx());
     const T& ymin = std::fmax(visrange.lowy(),  totalrange.lowy());
     const T& ymax = std::fmin(visrange.highy(), totalrange.highy());
 
     // Looking at some region outside of the graphs area. Nothing to draw.
-    if (xmin >= xmax || ymin >= ymax) return 1;
-
-    // Fine - lowest
-    const T   xmin_fine_scaled = xmin / fine_step_x_;
-    const int xlow_fine_scaled = static_cast<int>(std::ceil(xmin_fine_scaled));
-    const T   ymin_fine_scaled = ymin / fine_step_y_;
-    const int ylow_fine_scaled = static_cast<int>(std::ceil(ymin_fine_scaled));
-    // Fine - highest
-    const T   xmax_fine_scaled = xmax / fine_step_x_;
-    const int xhig_fine_scaled = static_cast<int>(std::floor(xmax_fine_scaled));
-    const T   ymax_fine_scaled = ymax / fine_step_y_;
-    const int yhig_fine_scaled = static_cast<int>(std::floor(ymax_fine_scaled));
-
-    const unsigned int n_grid_lines_x = xhig_fine_scaled - xlow_fine_scaled + 1u;
-    const unsigned int n_grid_lines_y = yhig_fine_scaled - ylow_fine_scaled + 1u;
-    const unsigned int new_n_vertices = 2u * (n_grid_lines_x + n_grid_lines_y);
+    const bool empty = !(xmin < xmax) || !(ymin < ymax);
 
-    if (n_vertices_ == new_n_vertices) {
-        // The grid should not be changed
-        //TODO check
-        return 1;
-    }
+    // Fine - lowest and their number
+    T x_start = xmin;
+    T y_start = ymin;
+    const unsigned int n_grid_lines_x = empty ? 0u : CountLines(xmin, xmax, fine_step_x_, x_start);
+    const unsigned int n_grid_lines_y = empty ? 0u : CountLines(ymin, ymax, fine_step_y_, y_start);
+    const unsigned int new_n_vertices = 2u * (n_grid_lines_x + n_grid_lines_y);
 
     // Vertices --------------------------------------------------------------
     {
@@ -103,36 +100,30 @@ inline int Grid<T>::BuildGrid(XYrange<T> visrange, XYrange<T> totalrange)
         // stores the old array size
         n_vertices_ = new_n_vertices;
 
-        const T x_start = static_cast<T>(xlow_fine_scaled) * fine_step_x_;
-        const T y_start = static_cast<T>(ylow_fine_scaled) * fine_step_y_;
+        // The differences to the center are taken in double, so that the
+        // lines stay in place far from zero.
+        const double xm = static_cast<double>(visrange.xm());
+        const double ym = static_cast<double>(visrange.ym());
+        const float x_low  = static_cast<float>(static_cast<double>(totalrange.lowx())  - xm);
+        const float x_high = static_cast<float>(static_cast<double>(totalrange.highx()) - xm);
+        const float y_low  = static_cast<float>(static_cast<double>(totalrange.lowy())  - ym);
+        const float y_high = static_cast<float>(static_cast<double>(totalrange.highy()) - ym);
 
         unsigned int vertex_offset = 0u;
         for (unsigned int i = 0u; i < n_grid_lines_x; i++) {
-            vertices_[vertex_offset + i * 2 + 0].coords_ =
-                point_t(
-                    static_cast<float>(x_start + i * fine_step_x_),
-                    static_cast<float>(totalrange.lowy()),
-                    0.0f, 1.0f);
-            vertices_[vertex_offset + i * 2 + 1].coords_ =
-                point_t(
-                    static_cast<float>(x_start + i * fine_step_x_),
-                    static_cast<float>(totalrange.highy()),
-                    0.0f, 1.0f);
+            const float x = static_cast<float>(static_cast<double>(x_start)
+                + static_cast<double>(i) * static_cast<double>(fine_step_x_) - xm);
+            vertices_[vertex_offset + i * 2 + 0].coords_ = point_t(x, y_low,  0.0f, 1.0f);
+            vertices_[vertex_offset + i * 2 + 1].coords_ = point_t(x, y_high, 0.0f, 1.0f);
             vertices_[vertex_offset + i * 2 + 0].color_ = vgrid_fine_line_color_;
             vertices_[vertex_offset + i * 2 + 1].color_ = vgrid_fine_line_color_;
         }
         vertex_offset = 2 * n_grid_lines_x;
         for (unsigned int i = 0u; i < n_grid_lines_y; i++) {
-            vertices_[vertex_offset + i * 2 + 0].coords_ =
-                point_t(
-                    static_cast<float>(totalrange.lowx()),
-                    static_cast<float>(y_start + i * fine_step_y_),
-                    0.0f, 1.0f);
-            vertices_[vertex_offset + i * 2 + 1].coords_ =
-                point_t(
-                    static_cast<float>(totalrange.highx()),
-                    static_cast<float>(y_start + i * fine_step_y_),
-                    0.0f, 1.0f);
+            const float y = static_cast<float>(static_cast<double>(y_start)
+                + static_cast<double>(i) * static_cast<double>(fine_step_y_) - ym);
+            vertices_[vertex_offset + i * 2 + 0].coords_ = point_t(x_low,  y, 0.0f, 1.0f);
+            vertices_[vertex_offset + i * 2 + 1].coords_ = point_t(x_high, y, 0.0f, 1.0f);
             vertices_[vertex_offset + i * 2 + 0].color_ = hgrid_fine_line_color_;
             vertices_[vertex_offset + i * 2 + 1].color_ = hgrid_fine_line_color_;
         }
@@ -162,22 +153,26 @@ inline int Grid<T>::BuildGrid(XYrange<T> visrange, XYrange<T> totalrange)
 
     // Wires coarse ----------------------------------------------------------
     {
-        // Coarse - lowest
-        const T   xmin_coarse_scaled = xmin / coarse_step_x_;
-        const int xlow_coarse_scaled = static_cast<int>(std::ceil(xmin_coarse_scaled));
-        const T   ymin_coarse_scaled = ymin / coarse_step_y_;
-        const int ylow_coarse_scaled = static_cast<int>(std::ceil(ymin_coarse_scaled));
-        // Coarse - highest
-        const T   xmax_coarse_scaled = xmax / coarse_step_x_;
-        const int xhig_coarse_scaled = static_cast<int>(std::floor(xmax_coarse_scaled));
-        const T   ymax_coarse_scaled = ymax / coarse_step_y_;
-        const int yhig_coarse_scaled = static_cast<int>(std::floor(ymax_coarse_scaled));
-
-        const int offset_x = xlow_coarse_scaled * coarse_grid_factor_ - xlow_fine_scaled;
-        const int offset_y = ylow_coarse_scaled * coarse_grid_factor_ - ylow_fine_scaled;
-
-        n_wires_coarse_x_ = xhig_coarse_scaled - xlow_coarse_scaled + 1;
-        n_wires_coarse_y_ = yhig_coarse_scaled - ylow_coarse_scaled + 1;
+        // Coarse - every coarse_grid_factor_-th fine line, starting at 'offset'
+        T x_coarse = xmin;
+        T y_coarse = ymin;
+        n_wires_coarse_x_ = empty ? 0u : CountLines(xmin, xmax, coarse_step_x_, x_coarse);
+        n_wires_coarse_y_ = empty ? 0u : CountLines(ymin, ymax, coarse_step_y_, y_coarse);
+        const auto first_fine = [](const T p_coarse, const T p_start, const T p_step,
+            const unsigned int p_n_fine, unsigned int& io_n_coarse) {
+            const long offset = std::lround((p_coarse - p_start) / p_step);
+            // Rounding at the ends of the range must not put a coarse line past the fine ones
+            if (offset < 0 || (unsigned long)offset >= p_n_fine) {
+                io_n_coarse = 0u;
+                return 0u;
+            }
+            io_n_coarse = std::min(io_n_coarse,
+                (p_n_fine - 1u - (unsigned int)offset) / coarse_grid_factor_ + 1u);
+            return (unsigned int)offset;
+        };
+        const unsigned int offset_x = first_fine(x_coarse, x_start, fine_step_x_, n_grid_lines_x, n_wires_coarse_x_);
+        const unsigned int offset_y = first_fine(y_coarse, y_start, fine_step_y_, n_grid_lines_y, n_wires_coarse_y_);
+
         if (wires_coarse_ == nullptr) {
             wires_coarse_ = new wire_t[n_wires_coarse_x_ + n_wires_coarse_y_];
         } else {
@@ -205,4 +200,31 @@ inline int Grid<T>::BuildGrid(XYrange<T> visrange, XYrange<T> totalrange)
     return 0;
 }
 
+template<typename T>
+inline unsigned int Grid<T>::CountLines(const T p_min, const T p_max, const T p_step, T& o_first) noexcept
+{
+    o_first = p_min;
+    if (!(p_min <= p_max) || !(p_step > T(0))) return 0u;
+    // Kept in T rather than int, far from zero the line indices can be large
+    const T low = std::ceil(p_min / p_step);
+    const T high = std::floor(p_max / p_step);
+    if (high < low) return 0u;
+    o_first = low * p_step;
+    return static_cast<unsigned int>(high - low) + 1u;
+}
+
+template<typename T>
+inline void Grid<T>::FormatValue(const double p_value, const double p_step,
+    char* const o_buf, const size_t p_size) noexcept
+{
+    // Snapped to the step, so that rounding noise such as 1e-17 is printed as 0.
+    // Far from zero more significant digits than the 6 of %g may be needed
+    // to tell the neighbouring lines apart.
+    const double value = std::round(p_value / p_step) * p_step;
+    const double magnitude = std::fmax(std::fabs(value), p_step);
+    const int digits = static_cast<int>(std::floor(std::log10(magnitude) + 1.0e-6))
+                     - static_cast<int>(std::floor(std::log10(p_step) + 1.0e-6)) + 1;
+    snprintf(o_buf, p_size, "%.*g", std::min(std::max(digits, 1), 17), value);
+}
+
 } // end of namespace tiny_graph_plot
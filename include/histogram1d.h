@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include "drawable.h"
+#include "simd_binning.h"
 
 namespace tiny_graph_plot
 {
@@ -23,24 +24,26 @@ private:
     :   Drawable<T>(),
         n_bins_(0u),
         x_min_(T(0.0)),
-        x_max_(T(0.0)) {}
-    virtual ~Histogram1d() {
-        if (this->points_ != nullptr) {
-            delete[] this->points_;
-        }
-    }
+        x_max_(T(0.0)),
+        bin_width_(T(0.0)),
+        binning_{ T(0.0), T(0.0), T(0.0), 0u },
+        data_generation_(0u) {}
+    virtual ~Histogram1d() {}
     Histogram1d(const Histogram1d& other) = delete;
     Histogram1d(Histogram1d&& other) = delete;
     Histogram1d& operator=(const Histogram1d& other) = delete;
     Histogram1d& operator=(Histogram1d&& other) = delete;
 public:
     void Init(const unsigned int nbins, const T xmin, const T xmax) {
+        assert(nbins > 0u && nbins < 0x7FFFFFFFu && xmin < xmax);
         n_bins_ = nbins;
         x_min_ = xmin;
         x_max_ = xmax;
-        this->size_info_ = SizeInfo(3u * n_bins_, 3u * n_bins_, 3u * n_bins_ - 1u, 0); //TODO
-        bins_.resize(1u + n_bins_ + 1u); // underflow, data, overflow
-        this->points_ = new Vec2<T>[3u * n_bins_];
+        bin_width_ = (x_max_ - x_min_) / T(n_bins_);
+        binning_ = UniformBinning<T>{ x_min_, x_max_, T(n_bins_) / (x_max_ - x_min_), n_bins_ };
+        bins_.assign(1u + n_bins_ + 1u, VALUETYPE(0)); // underflow, data, overflow
+        this->UpdateRange();
+        data_generation_++;
     }
     void SetUnderflowValue(const VALUETYPE value) noexcept {
         bins_[0u] = value;
@@ -49,23 +52,55 @@ public:
         bins_[n_bins_ + 1u] = value;
     }
     void SetBinValue(const unsigned int iBin, const VALUETYPE value) {
-        assert(iBin < bins_.size());
+        assert(iBin < n_bins_);
         bins_[iBin + 1u] = value;
-        const T bin_width = (x_max_ - x_min_) / T(n_bins_);
-        const T x = x_min_ + (T(iBin) + T(0.5)) * bin_width;
-        const T y = static_cast<T>(value);
-        this->points_[iBin * 3u + 0u] = Vec2<T>(x - T(0.5) * bin_width, y);
-        this->points_[iBin * 3u + 1u] = Vec2<T>(x,                      y);
-        this->points_[iBin * 3u + 2u] = Vec2<T>(x + T(0.5) * bin_width, y);
+        this->xy_range_.Include(Vec2<T>(x_min_, static_cast<T>(value)));
+        data_generation_++;
+    }
+    VALUETYPE GetUnderflowValue() const noexcept { return bins_[0u]; }
+    VALUETYPE GetOverflowValue() const noexcept { return bins_[n_bins_ + 1u]; }
+    VALUETYPE GetBinValue(const unsigned int iBin) const {
+        assert(iBin < n_bins_);
+        return bins_[iBin + 1u];
     }
+    /**
+        Add one entry, or 'w' entries, at 'x'. Values below x_min go to the
+        underflow bin, values from x_max on and NaNs go to the overflow bin.
+    */
+    void Fill(const T x) { this->Fill(x, VALUETYPE(1)); }
+    void Fill(const T x, const VALUETYPE w);
+    /**
+        Add one entry for each of the 'n' values. The bin indices are computed
+        with SIMD in blocks. Large inputs are split between the threads of the
+        global pool, each thread fills its own copy of the bins and the copies
+        are summed up at the end.
+    */
+    void FillN(const T* const xs, const size_t n);
+    unsigned int GetNbins() const noexcept { return n_bins_; }
+    T GetXmin() const noexcept { return x_min_; }
+    T GetXmax() const noexcept { return x_max_; }
+    //! The n_bins values without the underflow and the overflow bins
+    const VALUETYPE* GetBinValues() const noexcept { return bins_.data() + 1u; }
+    //! Incremented on every change of the bin values
+    unsigned int GetDataGeneration() const noexcept { return data_generation_; }
     //std::vector<VALUETYPE>& GetBinsToModify() { return bins_; }
     void GenGauss(
         const unsigned int nbins, const T xmin, const T xmax, const T a, const T b, const T c);
 private:
+    //! The y range is recalculated from the bin values, the x range is the binning range
+    void UpdateRange();
+    //! Add the entries of 'xs' into 'o_bins' of size n_bins_ + 2
+    void FillBins(const T* const xs, const size_t n, VALUETYPE* const o_bins) const;
+private:
+    static constexpr size_t fill_block_size_ = 1024u; //!< Bin indices computed at once
+    static constexpr size_t parallel_min_entries_ = 1u << 20; //!< Fewer entries are filled by one thread
     unsigned int n_bins_; //!< Number of bins not including the underflow and the overflow bins
     T x_min_;
     T x_max_;
+    T bin_width_;
+    UniformBinning<T> binning_;
     std::vector<VALUETYPE> bins_; // [1+n_bins_+1]
+    unsigned int data_generation_;
 };
 
 template class Histogram1d<float, unsigned long>;
@@ -1,42 +1,95 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "thread_pool.h"
 
 namespace tiny_graph_plot
 {
 
 template<typename T, typename VALUETYPE>
-inline void Histogram1d<T, VALUETYPE>::GenGauss(
-    const unsigned int nbins, const T xmin, const T xmax, const T a, const T b, const T c)\
+inline void Histogram1d<T, VALUETYPE>::Fill(const T x, const VALUETYPE w)
 {
-    n_bins_ = nbins;
-    x_min_ = xmin;
-    x_max_ = xmax;
-    bins_.resize(1u + n_bins_ + 1u); // underflow, data, overflow
-    //this->points_.resize(3u * n_bins_);
-    this->points_ = new Vec2<T>[3u * n_bins_];
-    bins_[0] = 0; // underflow
-    for (unsigned int iBin = 0u; iBin < n_bins_; iBin++) {
-        bins_[iBin + 1] = 0; // data
+    const uint32_t iBin = binning_.Index(x);
+    bins_[iBin] += w;
+    if (iBin >= 1u && iBin <= n_bins_) {
+        this->xy_range_.Include(Vec2<T>(x_min_, static_cast<T>(bins_[iBin])));
     }
-    bins_[n_bins_ + 1] = 0; // overflow
-    const T bin_width = (x_max_ - x_min_) / T(n_bins_);
-    const T k = -T(0.5) / (c * c);
+    data_generation_++;
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram1d<T, VALUETYPE>::FillBins(const T* const xs, const size_t n,
+    VALUETYPE* const o_bins) const
+{
+    uint32_t idx[fill_block_size_];
+    for (size_t first = 0u; first < n; first += fill_block_size_) {
+        const size_t n_block = std::min(fill_block_size_, n - first);
+        BinIndices(binning_, xs + first, n_block, idx);
+        for (size_t i = 0u; i < n_block; i++) {
+            o_bins[idx[i]]++;
+        }
+    }
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram1d<T, VALUETYPE>::FillN(const T* const xs, const size_t n)
+{
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const unsigned int n_chunks = pool.GetNthreads();
+    const size_t n_bins_total = bins_.size();
+    // The copies of the bins should be small compared to the input
+    if (n < parallel_min_entries_ || n_chunks < 2u ||
+        n_bins_total * n_chunks > n / 4u) {
+        this->FillBins(xs, n, bins_.data());
+    } else {
+        std::vector<std::vector<VALUETYPE>> local_bins(n_chunks);
+        pool.ParallelFor(n_chunks, [&](const unsigned int i) {
+            local_bins[i].assign(n_bins_total, VALUETYPE(0));
+            const size_t first = n * i / n_chunks;
+            const size_t last = n * (i + 1u) / n_chunks;
+            this->FillBins(xs + first, last - first, local_bins[i].data());
+        });
+        for (const std::vector<VALUETYPE>& local : local_bins) {
+            for (size_t iBin = 0u; iBin < n_bins_total; iBin++) {
+                bins_[iBin] += local[iBin];
+            }
+        }
+    }
+    this->UpdateRange();
+    data_generation_++;
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram1d<T, VALUETYPE>::UpdateRange()
+{
     T y_min = std::numeric_limits<T>::max();
     T y_max = std::numeric_limits<T>::lowest();
+    for (unsigned int iBin = 1u; iBin <= n_bins_; iBin++) {
+        const T y = static_cast<T>(bins_[iBin]);
+        y_min = std::min(y_min, y);
+        y_max = std::max(y_max, y);
+    }
+    this->xy_range_ = XYrange<T>(x_min_, x_max_ - x_min_, y_min, y_max - y_min);
+    this->xy_range_.FixDegenerateCases();
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram1d<T, VALUETYPE>::GenGauss(
+    const unsigned int nbins, const T xmin, const T xmax, const T a, const T b, const T c)
+{
+    this->Init(nbins, xmin, xmax);
+    const T k = -T(0.5) / (c * c);
     for (unsigned int iBin = 0; iBin < n_bins_; iBin++) {
-        const T x = x_min_ + (T(iBin) + T(0.5)) * bin_width;
+        const T x = x_min_ + (T(iBin) + T(0.5)) * bin_width_;
         const T y = a * exp(k * (x - b) * (x - b));
-        const VALUETYPE val = static_cast<VALUETYPE>(floor(y));
-        bins_[iBin + 1] = val;
-        this->points_[iBin*3+0] = Vec2<T>(x - T(0.5) * bin_width, y);
-        this->points_[iBin*3+1] = Vec2<T>(x,                      y);
-        this->points_[iBin*3+2] = Vec2<T>(x + T(0.5) * bin_width, y);
-        y_min = std::min(y_min, std::floor(y));
-        y_max = std::max(y_max, std::floor(y));
+        bins_[iBin + 1] = static_cast<VALUETYPE>(floor(y));
     }
-    this->size_info_ = SizeInfo(3u * n_bins_, 3u * n_bins_, 3u * n_bins_ - 1u, 0); //TODO
-    this->xy_range_ = XYrange<T>(x_min_, x_max_ - x_min_, y_min, y_max - y_min);
+    this->UpdateRange();
+    data_generation_++;
 }
 
-} // end of namespace tiny_graph_plot
\ No newline at end of file
+} // end of namespace tiny_graph_plot
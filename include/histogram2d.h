@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+#include <type_traits>
+
+#include "drawable.h"
+#include "simd_binning.h"
+
+namespace tiny_graph_plot
+{
+
+template<typename T> class GraphManager;
+
+/**
+    Two-dimensional histogram with uniform binning, such as an occupancy map.
+
+    The canvas keeps the bins in a single-channel texture and colors them with
+    a colormap in the fragment shader, so the cost of drawing does not depend
+    on the number of bins. Each row of bins remembers the data generation of
+    its last change, so a canvas only re-sends the rows changed since its
+    previous upload.
+
+    Entries outside of the binning range are not kept in bins, they are only
+    counted, see GetNoutside().
+*/
+template<typename T, typename VALUETYPE>
+class Histogram2d : public Drawable<T>
+{
+    static_assert(std::is_same<T, float>::value
+               || std::is_same<T, double>::value, "");
+    friend class GraphManager<T>;
+private:
+    explicit Histogram2d()
+    :   Drawable<T>(),
+        n_bins_x_(0u),
+        n_bins_y_(0u),
+        binning_x_{ T(0.0), T(0.0), T(0.0), 0u },
+        binning_y_{ T(0.0), T(0.0), T(0.0), 0u },
+        n_outside_(VALUETYPE(0)),
+        max_value_(VALUETYPE(0)),
+        data_generation_(0u) {}
+    virtual ~Histogram2d() {}
+    Histogram2d(const Histogram2d& other) = delete;
+    Histogram2d(Histogram2d&& other) = delete;
+    Histogram2d& operator=(const Histogram2d& other) = delete;
+    Histogram2d& operator=(Histogram2d&& other) = delete;
+public:
+    void Init(const unsigned int nbinsx, const T xmin, const T xmax,
+              const unsigned int nbinsy, const T ymin, const T ymax);
+    void SetBinValue(const unsigned int iBinX, const unsigned int iBinY, const VALUETYPE value);
+    VALUETYPE GetBinValue(const unsigned int iBinX, const unsigned int iBinY) const {
+        assert(iBinX < n_bins_x_ && iBinY < n_bins_y_);
+        return bins_[static_cast<size_t>(iBinY) * n_bins_x_ + iBinX];
+    }
+    //! Add one entry, or 'w' entries, at (x, y)
+    void Fill(const T x, const T y) { this->Fill(x, y, VALUETYPE(1)); }
+    void Fill(const T x, const T y, const VALUETYPE w);
+    /**
+        Add one entry for each of the 'n' points (xs[i], ys[i]). The bin indices
+        are computed with SIMD in blocks. Large inputs are split between the
+        threads of the global pool. When the bins are small compared to the
+        input each thread fills its own copy of the bins, otherwise the entries
+        are first sorted by bands of rows and each band is filled by one thread.
+    */
+    void FillN(const T* const xs, const T* const ys, const size_t n);
+    unsigned int GetNbinsX() const noexcept { return n_bins_x_; }
+    unsigned int GetNbinsY() const noexcept { return n_bins_y_; }
+    //! Row by row, n_bins_x values per row
+    const VALUETYPE* GetBinValues() const noexcept { return bins_.data(); }
+    VALUETYPE GetMaxValue() const noexcept { return max_value_; }
+    VALUETYPE GetNoutside() const noexcept { return n_outside_; }
+    //! Incremented on every change of the bin values
+    unsigned int GetDataGeneration() const noexcept { return data_generation_; }
+    //! Data generation of the last change of the row
+    unsigned int GetRowGeneration(const unsigned int iBinY) const {
+        assert(iBinY < n_bins_y_);
+        return row_generation_[iBinY];
+    }
+private:
+    //! Flat bin index for each of the 'n' points, out of range points get n_bins_x * n_bins_y
+    void BinIndices2d(const T* const xs, const T* const ys, const size_t n, uint32_t* const o_idx) const;
+    void UpdateMaxValue();
+private:
+    static constexpr size_t fill_block_size_ = 1024u; //!< Bin indices computed at once
+    static constexpr size_t parallel_min_entries_ = 1u << 20; //!< Fewer entries are filled by one thread
+    unsigned int n_bins_x_;
+    unsigned int n_bins_y_;
+    UniformBinning<T> binning_x_;
+    UniformBinning<T> binning_y_;
+    std::vector<VALUETYPE> bins_; // [n_bins_y_][n_bins_x_]
+    std::vector<unsigned int> row_generation_; // [n_bins_y_]
+    VALUETYPE n_outside_;
+    VALUETYPE max_value_;
+    unsigned int data_generation_;
+};
+
+template class Histogram2d<float, unsigned long>;
+template class Histogram2d<double, unsigned long>;
+
+using Histogram2dF = Histogram2d<float, unsigned long>;
+using Histogram2dD = Histogram2d<double, unsigned long>;
+
+} // end of namespace tiny_graph_plot
+
+#include "histogram2d_inline.h"
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::Init(
+    const unsigned int nbinsx, const T xmin, const T xmax,
+    const unsigned int nbinsy, const T ymin, const T ymax)
+{
+    assert(nbinsx > 0u && nbinsy > 0u && xmin < xmax && ymin < ymax);
+    assert(static_cast<uint64_t>(nbinsx) * nbinsy < 0xFFFFFFFFull);
+    n_bins_x_ = nbinsx;
+    n_bins_y_ = nbinsy;
+    binning_x_ = UniformBinning<T>{ xmin, xmax, T(nbinsx) / (xmax - xmin), nbinsx };
+    binning_y_ = UniformBinning<T>{ ymin, ymax, T(nbinsy) / (ymax - ymin), nbinsy };
+    data_generation_++;
+    bins_.assign(static_cast<size_t>(n_bins_x_) * n_bins_y_, VALUETYPE(0));
+    row_generation_.assign(n_bins_y_, data_generation_);
+    n_outside_ = VALUETYPE(0);
+    max_value_ = VALUETYPE(0);
+    this->xy_range_ = XYrange<T>(xmin, xmax - xmin, ymin, ymax - ymin);
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::SetBinValue(
+    const unsigned int iBinX, const unsigned int iBinY, const VALUETYPE value)
+{
+    assert(iBinX < n_bins_x_ && iBinY < n_bins_y_);
+    VALUETYPE& bin = bins_[static_cast<size_t>(iBinY) * n_bins_x_ + iBinX];
+    const VALUETYPE old_value = bin;
+    bin = value;
+    data_generation_++;
+    row_generation_[iBinY] = data_generation_;
+    if (value >= max_value_) {
+        max_value_ = value;
+    } else if (old_value == max_value_) {
+        this->UpdateMaxValue();
+    }
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::Fill(const T x, const T y, const VALUETYPE w)
+{
+    const uint32_t iBinX = binning_x_.Index(x) - 1u; // The underflow bin wraps around
+    const uint32_t iBinY = binning_y_.Index(y) - 1u;
+    data_generation_++;
+    if (iBinX >= n_bins_x_ || iBinY >= n_bins_y_) {
+        n_outside_ += w;
+        return;
+    }
+    VALUETYPE& bin = bins_[static_cast<size_t>(iBinY) * n_bins_x_ + iBinX];
+    bin += w;
+    max_value_ = std::max(max_value_, bin);
+    row_generation_[iBinY] = data_generation_;
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::BinIndices2d(const T* const xs, const T* const ys,
+    const size_t n, uint32_t* const o_idx) const
+{
+    const uint32_t n_bins = n_bins_x_ * n_bins_y_;
+    uint32_t idx_y[fill_block_size_];
+    for (size_t first = 0u; first < n; first += fill_block_size_) {
+        const size_t n_block = std::min(fill_block_size_, n - first);
+        uint32_t* const idx_x = o_idx + first;
+        BinIndices(binning_x_, xs + first, n_block, idx_x);
+        BinIndices(binning_y_, ys + first, n_block, idx_y);
+        for (size_t i = 0u; i < n_block; i++) {
+            const uint32_t ix = idx_x[i] - 1u; // The underflow bin wraps around
+            const uint32_t iy = idx_y[i] - 1u;
+            idx_x[i] = (ix < n_bins_x_ && iy < n_bins_y_) ? iy * n_bins_x_ + ix : n_bins;
+        }
+    }
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::FillN(const T* const xs, const T* const ys, const size_t n)
+{
+    const uint32_t n_bins = n_bins_x_ * n_bins_y_;
+    // Fills 'o_bins' and flags the changed rows, returns the number of entries out of range
+    const auto fill = [this, n_bins](const T* const p_xs, const T* const p_ys, const size_t p_n,
+        VALUETYPE* const o_bins, uint8_t* const o_rows, VALUETYPE& o_max) {
+        VALUETYPE n_outside = VALUETYPE(0);
+        uint32_t idx[fill_block_size_];
+        for (size_t first = 0u; first < p_n; first += fill_block_size_) {
+            const size_t n_block = std::min(fill_block_size_, p_n - first);
+            this->BinIndices2d(p_xs + first, p_ys + first, n_block, idx);
+            for (size_t i = 0u; i < n_block; i++) {
+                if (idx[i] == n_bins) {
+                    n_outside++;
+                    continue;
+                }
+                const VALUETYPE value = ++o_bins[idx[i]];
+                o_max = std::max(o_max, value);
+                o_rows[idx[i] / n_bins_x_] = 1u;
+            }
+        }
+        return n_outside;
+    };
+
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const unsigned int n_threads = pool.GetNthreads();
+    std::vector<uint8_t> rows(n_bins_y_, 0u);
+    if (n < parallel_min_entries_ || n_threads < 2u) {
+        n_outside_ += fill(xs, ys, n, bins_.data(), rows.data(), max_value_);
+    } else if (static_cast<size_t>(n_bins) * n_threads <= n / 4u) {
+        // Each thread fills its own copy of the bins
+        std::vector<std::vector<VALUETYPE>> local_bins(n_threads);
+        std::vector<std::vector<uint8_t>> local_rows(n_threads);
+        std::vector<VALUETYPE> local_outside(n_threads, VALUETYPE(0));
+        pool.ParallelFor(n_threads, [&](const unsigned int i) {
+            local_bins[i].assign(n_bins, VALUETYPE(0));
+            local_rows[i].assign(n_bins_y_, 0u);
+            const size_t first = n * i / n_threads;
+            const size_t last = n * (i + 1u) / n_threads;
+            VALUETYPE local_max = VALUETYPE(0);
+            local_outside[i] = fill(xs + first, ys + first, last - first,
+                local_bins[i].data(), local_rows[i].data(), local_max);
+        });
+        for (unsigned int i = 0u; i < n_threads; i++) {
+            n_outside_ += local_outside[i];
+            for (unsigned int iy = 0u; iy < n_bins_y_; iy++) {
+                rows[iy] |= local_rows[i][iy];
+            }
+        }
+        pool.ParallelFor(n_bins_y_, [&](const unsigned int iy) {
+            if (!rows[iy]) return;
+            VALUETYPE* const row = bins_.data() + static_cast<size_t>(iy) * n_bins_x_;
+            for (unsigned int i = 0u; i < n_threads; i++) {
+                const VALUETYPE* const local_row = local_bins[i].data() + static_cast<size_t>(iy) * n_bins_x_;
+                for (unsigned int ix = 0u; ix < n_bins_x_; ix++) {
+                    row[ix] += local_row[ix];
+                }
+            }
+        });
+        this->UpdateMaxValue();
+    } else {
+        // The bins are too many to be copied. The entries are sorted by bands
+        // of rows instead, then each band is filled by one thread. The input is
+        // processed in parts to limit the memory taken by the indices.
+        const unsigned int n_bands = std::min(4u * n_threads, n_bins_y_);
+        std::vector<uint32_t> band_of_row(n_bins_y_);
+        for (unsigned int iy = 0u; iy < n_bins_y_; iy++) {
+            band_of_row[iy] = static_cast<uint32_t>(static_cast<uint64_t>(iy) * n_bands / n_bins_y_);
+        }
+        const size_t part_size = std::min(n, size_t(16u) << 20);
+        std::vector<uint32_t> idx(part_size);
+        std::vector<uint32_t> sorted(part_size);
+        std::vector<size_t> band_offset(static_cast<size_t>(n_threads) * (n_bands + 1u));
+        std::vector<std::vector<uint8_t>> local_rows(n_threads, std::vector<uint8_t>(n_bins_y_, 0u));
+        std::vector<VALUETYPE> band_max(n_bands, max_value_);
+        for (size_t part = 0u; part < n; part += part_size) {
+            const size_t n_part = std::min(part_size, n - part);
+            pool.ParallelFor(n_threads, [&](const unsigned int i) {
+                const size_t first = n_part * i / n_threads;
+                const size_t last = n_part * (i + 1u) / n_threads;
+                uint32_t* const chunk_idx = idx.data() + first;
+                this->BinIndices2d(xs + part + first, ys + part + first, last - first, chunk_idx);
+                // Counting sort of the chunk by band, the entries out of range are left out
+                size_t* const offset = band_offset.data() + static_cast<size_t>(i) * (n_bands + 1u);
+                std::fill(offset, offset + n_bands + 1u, size_t(0u));
+                for (size_t j = 0u; j < last - first; j++) {
+                    if (chunk_idx[j] == n_bins) continue;
+                    const uint32_t iy = chunk_idx[j] / n_bins_x_;
+                    local_rows[i][iy] = 1u;
+                    offset[band_of_row[iy] + 1u]++;
+                }
+                offset[0] = first;
+                for (unsigned int b = 0u; b < n_bands; b++) {
+                    offset[b + 1u] += offset[b];
+                }
+                std::vector<size_t> pos(offset, offset + n_bands);
+                for (size_t j = 0u; j < last - first; j++) {
+                    if (chunk_idx[j] == n_bins) continue;
+                    sorted[pos[band_of_row[chunk_idx[j] / n_bins_x_]]++] = chunk_idx[j];
+                }
+            });
+            pool.ParallelFor(n_bands, [&](const unsigned int b) {
+                VALUETYPE max_value = band_max[b];
+                for (unsigned int i = 0u; i < n_threads; i++) {
+                    const size_t* const offset = band_offset.data() + static_cast<size_t>(i) * (n_bands + 1u);
+                    for (size_t j = offset[b]; j < offset[b + 1u]; j++) {
+                        max_value = std::max(max_value, ++bins_[sorted[j]]);
+                    }
+                }
+                band_max[b] = max_value;
+            });
+            for (unsigned int i = 0u; i < n_threads; i++) {
+                const size_t* const offset = band_offset.data() + static_cast<size_t>(i) * (n_bands + 1u);
+                const size_t first = n_part * i / n_threads;
+                const size_t last = n_part * (i + 1u) / n_threads;
+                n_outside_ += static_cast<VALUETYPE>((last - first) - (offset[n_bands] - offset[0]));
+            }
+        }
+        for (unsigned int i = 0u; i < n_threads; i++) {
+            for (unsigned int iy = 0u; iy < n_bins_y_; iy++) {
+                rows[iy] |= local_rows[i][iy];
+            }
+        }
+        max_value_ = *std::max_element(band_max.begin(), band_max.end());
+    }
+
+    data_generation_++;
+    for (unsigned int iy = 0u; iy < n_bins_y_; iy++) {
+        if (rows[iy]) row_generation_[iy] = data_generation_;
+    }
+}
+
+template<typename T, typename VALUETYPE>
+inline void Histogram2d<T, VALUETYPE>::UpdateMaxValue()
+{
+    max_value_ = bins_.empty() ? VALUETYPE(0) : *std::max_element(bins_.begin(), bins_.end());
+}
+
+} // end of namespace tiny_graph_plot
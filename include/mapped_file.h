@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace tiny_graph_plot
+{
+
+/**
+    A whole file mapped into memory. The pages are read from the file on
+    first access, so opening even a huge file is fast. The mapping is
+    private: the pages may be written to, but the changes never reach the
+    file.
+*/
+class MappedFile
+{
+public:
+    explicit MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    MappedFile& operator=(MappedFile&& other) = delete;
+public:
+    //! Returns false and prints the reason if the file could not be mapped
+    bool Open(const char* const p_path);
+    void Close();
+    //! Hint that the data is going to be read from the beginning to the end
+    void AdviseSequential() const;
+    //! Hint that the data is going to be read in no particular order
+    void AdviseNormal() const;
+    void* GetData() const noexcept { return data_; }
+    size_t GetSize() const noexcept { return size_; }
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0u;
+#ifdef _WIN32
+    void* file_ = nullptr;    //!< HANDLE
+    void* mapping_ = nullptr; //!< HANDLE
+#endif
+};
+
+} // end of namespace tiny_graph_plot
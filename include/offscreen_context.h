@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+namespace tiny_graph_plot
+{
+
+/**
+    OpenGL context without a window, used by the offscreen canvases.
+
+    Depending on TINY_GRAPH_PLOT_OFFSCREEN in CMake it is an EGL context,
+    on the Mesa surfaceless platform when it is available, or an OSMesa
+    context. Both work without X11 and with a software renderer such as
+    llvmpipe. The canvases render into their own framebuffer objects, so
+    the default framebuffer of the context is not used.
+*/
+class OffscreenContext
+{
+public:
+    explicit OffscreenContext() = default;
+    ~OffscreenContext() { this->Destroy(); }
+    OffscreenContext(const OffscreenContext& other) = delete;
+    OffscreenContext(OffscreenContext&& other) = delete;
+    OffscreenContext& operator=(const OffscreenContext& other) = delete;
+    OffscreenContext& operator=(OffscreenContext&& other) = delete;
+public:
+    //! Returns false if the context can not be created or no backend has been compiled in
+    bool Create();
+    void Destroy();
+    bool MakeCurrent() const;
+    bool IsValid() const noexcept { return context_ != nullptr; }
+private:
+    void* display_ = nullptr; //!< EGLDisplay
+    void* surface_ = nullptr; //!< EGLSurface, only without EGL_KHR_surfaceless_context
+    void* context_ = nullptr; //!< EGLContext or OSMesaContext
+    std::vector<unsigned char> buffer_; //!< OSMesa can not make a context current without a buffer
+};
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+
+namespace tiny_graph_plot
+{
+
+/**
+    Writes framebuffers into PNG files without stalling the render thread.
+    Read() only queues the copy of the pixels into a pixel pack buffer and
+    puts a fence after it. Poll() takes the buffers whose fence has been
+    signaled and hands their pixels to a background thread, which flips
+    the rows, encodes and writes the file, then calls the callback.
+    A ring of n_slots_ buffers is used, so that several frames can be in
+    flight; when all of them are busy, Read() waits for the oldest one.
+
+    All the methods except the destructor must be called from the thread
+    of the OpenGL context in which Read() has been called.
+*/
+class PngExporter
+{
+public:
+    //! Called on the encoder thread once the file is written or has failed
+    using Callback = std::function<void(const std::string& path, const bool ok)>;
+public:
+    explicit PngExporter() = default;
+    ~PngExporter(); //!< Writes the files still queued, call Release() before
+    PngExporter(const PngExporter& other) = delete;
+    PngExporter(PngExporter&& other) = delete;
+    PngExporter& operator=(const PngExporter& other) = delete;
+    PngExporter& operator=(PngExporter&& other) = delete;
+public:
+    /**
+        Read the color buffer of the framebuffer 'p_fbo', its back buffer
+        for 0, into 'p_path'. The framebuffer bindings are changed.
+    */
+    void Read(const GLuint p_fbo, const int p_w, const int p_h,
+              const std::string& p_path, const Callback& p_callback = nullptr);
+    //! Pass the finished reads to the encoder, waiting for the GPU if 'p_wait'
+    void Poll(const bool p_wait = false);
+    //! Wait until all the queued files are written
+    void Finish();
+    //! There are reads which are not finished on the GPU, see Poll()
+    bool HasPendingReads() const noexcept;
+    //! Delete the OpenGL objects, the context must be current
+    void Release();
+private:
+    struct Slot {
+        GLuint pbo_ = 0u;
+        GLsync fence_ = nullptr;
+        size_t capacity_ = 0u; //!< Bytes allocated for pbo_
+        int w_ = 0;
+        int h_ = 0;
+        std::string path_;
+        Callback callback_;
+    };
+    struct Job {
+        int w_ = 0;
+        int h_ = 0;
+        std::string path_;
+        Callback callback_;
+        std::vector<unsigned char> rgba_; //!< Bottom row first, as read by OpenGL
+    };
+    static constexpr size_t n_slots_ = 3u;
+private:
+    //! Returns false if 'p_wait' is not set and the fence is not signaled yet
+    bool CompleteSlot(Slot& p_slot, const bool p_wait);
+    void EncoderLoop();
+    static bool Encode(const Job& p_job);
+private:
+    Slot slots_[n_slots_];
+    size_t next_ = 0u; //!< The slot for the next Read(), the oldest one in flight if busy
+    std::thread encoder_; //!< Started by the first Read()
+    std::mutex mutex_;
+    std::condition_variable cv_jobs_;
+    std::condition_variable cv_done_;
+    std::deque<Job> jobs_;
+    size_t n_encoding_ = 0u; //!< Queued or being encoded
+    bool stop_ = false;
+};
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "tiny_gl_text_renderer/data_types.h"
+
+namespace tiny_graph_plot
+{
+
+using tiny_gl_text_renderer::color_t;
+
+/**
+    RGBA8 image in memory, stored line by line from top to bottom, with the
+    drawing primitives of the software canvas. Coordinates are in pixels,
+    the center of pixel (i, j) is at (i + 0.5, j + 0.5), y grows downwards.
+    Each primitive only touches the pixels inside the given clip rectangle,
+    hence disjoint rectangles of the same image can be drawn in parallel.
+*/
+class RasterImage
+{
+public:
+    //! Pixels [x0; x1) x [y0; y1)
+    struct ClipRect {
+        int x0 = 0;
+        int y0 = 0;
+        int x1 = 0;
+        int y1 = 0;
+        bool IsEmpty() const noexcept { return x0 >= x1 || y0 >= y1; }
+        ClipRect Intersect(const ClipRect& other) const noexcept;
+    };
+    //! Opaque RGB of a color and its alpha as the coverage in [0; 256]
+    struct Paint {
+        uint32_t rgba = 0xFF000000u;
+        uint32_t a = 256u;
+    };
+public:
+    explicit RasterImage() = default;
+    ~RasterImage() = default;
+    RasterImage(const RasterImage& other) = delete;
+    RasterImage(RasterImage&& other) = delete;
+    RasterImage& operator=(const RasterImage& other) = delete;
+    RasterImage& operator=(RasterImage&& other) = delete;
+public:
+    void Resize(const int p_w, const int p_h);
+    int GetWidth() const noexcept { return w_; }
+    int GetHeight() const noexcept { return h_; }
+    //! RGBA bytes, w * h * 4
+    const unsigned char* GetData() const noexcept {
+        return reinterpret_cast<const unsigned char*>(pixels_.data());
+    }
+    uint32_t* GetRow(const int p_y) noexcept { return pixels_.data() + (size_t)p_y * (size_t)w_; }
+    ClipRect GetFullRect() const noexcept;
+    static Paint MakePaint(const color_t& p_color) noexcept;
+    static uint32_t PackRGBA(const unsigned char* const p_rgba) noexcept;
+    //! Returns false if the file can not be written
+    bool WritePNG(const char* const p_path) const;
+public:
+    void FillRect(const int p_x0, const int p_y0, const int p_x1, const int p_y1,
+        const Paint& p_paint, const ClipRect& p_clip);
+    /**
+        Antialiased line of the given width. The line is cut into spans
+        across its major axis, one per pixel along it, and the pixels at the
+        ends of each span get their fractional coverage, as in Wu's
+        algorithm for width 1. Only the pixels with the center in [p0; p1)
+        along the major axis are drawn, so that the joints of a polyline
+        are not blended twice.
+    */
+    void DrawLine(float p_x0, float p_y0, float p_x1, float p_y1, const float p_width,
+        const Paint& p_paint, const ClipRect& p_clip);
+    //! Square marker, as the OpenGL points: the pixels with the center inside the square
+    void DrawMarker(const float p_x, const float p_y, const float p_size,
+        const Paint& p_paint, const ClipRect& p_clip);
+    /**
+        Text with the glyphs of font_table.h, placed as the labels of the
+        text renderer: (p_x, p_y) is the top-left corner of the text before
+        the rotation by 'p_angle' degrees counterclockwise around it.
+        Each pixel is sampled 4x4 times, so that scaled down text stays readable.
+    */
+    void DrawText(const char* const p_text, const float p_x, const float p_y,
+        const float p_scale, const float p_angle, const Paint& p_paint, const ClipRect& p_clip);
+private:
+    int w_ = 0;
+    int h_ = 0;
+    std::vector<uint32_t> pixels_;
+};
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace tiny_graph_plot
+{
+
+/**
+    Uniform binning of [x_min; x_max) into 'n_bins' bins of width 1/k.
+    The index of the bin including the underflow bin is written into
+    'o_idx' for each of the 'p_n' values:
+    0 for x < x_min, n_bins + 1 for x >= x_max and NaN, 1 + floor((x - x_min) * k)
+    otherwise, limited to n_bins against the rounding errors.
+    'n_bins' must be below 2^31 - 1.
+
+    The AVX2 version is used when the code is compiled with AVX2 enabled,
+    otherwise SSE2 on x86-64 and NEON on AArch64. The values left over by
+    the vector loop are processed by the scalar version.
+*/
+template<typename T>
+struct UniformBinning
+{
+    T x_min;
+    T x_max;
+    T k; //!< Inverse of the bin width
+    uint32_t n_bins;
+
+    uint32_t Index(const T x) const noexcept {
+        if (x < x_min) return 0u;
+        if (!(x < x_max)) return n_bins + 1u;
+        const T t = (x - x_min) * k;
+        return 1u + ((t < T(n_bins - 1u)) ? static_cast<uint32_t>(t) : n_bins - 1u);
+    }
+};
+
+inline void BinIndices(const UniformBinning<float>& p_b, const float* const p_x,
+    const size_t p_n, uint32_t* const o_idx) noexcept
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256 x_min = _mm256_set1_ps(p_b.x_min);
+        const __m256 x_max = _mm256_set1_ps(p_b.x_max);
+        const __m256 k = _mm256_set1_ps(p_b.k);
+        const __m256 t_max = _mm256_set1_ps(static_cast<float>(p_b.n_bins - 1u));
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i overflow = _mm256_set1_epi32(static_cast<int>(p_b.n_bins + 1u));
+        for (; i + 8 <= p_n; i += 8) {
+            const __m256 x = _mm256_loadu_ps(p_x + i);
+            const __m256 under = _mm256_cmp_ps(x, x_min, _CMP_LT_OQ);
+            const __m256 in = _mm256_and_ps(_mm256_cmp_ps(x, x_min, _CMP_GE_OQ),
+                                            _mm256_cmp_ps(x, x_max, _CMP_LT_OQ));
+            const __m256 t = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(x, x_min), k), t_max);
+            const __m256i idx = _mm256_add_epi32(_mm256_cvttps_epi32(t), one);
+            // in ? idx : (under ? 0 : overflow)
+            __m256i res = _mm256_andnot_si256(_mm256_castps_si256(under), overflow);
+            res = _mm256_blendv_epi8(res, idx, _mm256_castps_si256(in));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(o_idx + i), res);
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128 x_min = _mm_set1_ps(p_b.x_min);
+        const __m128 x_max = _mm_set1_ps(p_b.x_max);
+        const __m128 k = _mm_set1_ps(p_b.k);
+        const __m128 t_max = _mm_set1_ps(static_cast<float>(p_b.n_bins - 1u));
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i overflow = _mm_set1_epi32(static_cast<int>(p_b.n_bins + 1u));
+        for (; i + 4 <= p_n; i += 4) {
+            const __m128 x = _mm_loadu_ps(p_x + i);
+            const __m128i under = _mm_castps_si128(_mm_cmplt_ps(x, x_min));
+            const __m128i in = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(x, x_min),
+                                                           _mm_cmplt_ps(x, x_max)));
+            const __m128 t = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(x, x_min), k), t_max);
+            const __m128i idx = _mm_add_epi32(_mm_cvttps_epi32(t), one);
+            // in ? idx : (under ? 0 : overflow)
+            const __m128i res = _mm_or_si128(_mm_and_si128(in, idx),
+                _mm_andnot_si128(in, _mm_andnot_si128(under, overflow)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(o_idx + i), res);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const float32x4_t x_min = vdupq_n_f32(p_b.x_min);
+        const float32x4_t x_max = vdupq_n_f32(p_b.x_max);
+        const float32x4_t k = vdupq_n_f32(p_b.k);
+        const float32x4_t t_max = vdupq_n_f32(static_cast<float>(p_b.n_bins - 1u));
+        const uint32x4_t one = vdupq_n_u32(1u);
+        const uint32x4_t zero = vdupq_n_u32(0u);
+        const uint32x4_t overflow = vdupq_n_u32(p_b.n_bins + 1u);
+        for (; i + 4 <= p_n; i += 4) {
+            const float32x4_t x = vld1q_f32(p_x + i);
+            const uint32x4_t under = vcltq_f32(x, x_min);
+            const uint32x4_t in = vandq_u32(vcgeq_f32(x, x_min), vcltq_f32(x, x_max));
+            const float32x4_t t = vminq_f32(vmulq_f32(vsubq_f32(x, x_min), k), t_max);
+            const uint32x4_t idx = vaddq_u32(vcvtq_u32_f32(t), one);
+            vst1q_u32(o_idx + i, vbslq_u32(in, idx, vbslq_u32(under, zero, overflow)));
+        }
+    }
+#endif
+    for (; i < p_n; i++) {
+        o_idx[i] = p_b.Index(p_x[i]);
+    }
+}
+
+//! See the float version above
+inline void BinIndices(const UniformBinning<double>& p_b, const double* const p_x,
+    const size_t p_n, uint32_t* const o_idx) noexcept
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256d x_min = _mm256_set1_pd(p_b.x_min);
+        const __m256d x_max = _mm256_set1_pd(p_b.x_max);
+        const __m256d k = _mm256_set1_pd(p_b.k);
+        const __m256d t_max = _mm256_set1_pd(static_cast<double>(p_b.n_bins - 1u));
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i overflow = _mm_set1_epi32(static_cast<int>(p_b.n_bins + 1u));
+        // Takes the low halves of the 64-bit masks, to match the 32-bit indices
+        const __m256i narrow = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        for (; i + 4 <= p_n; i += 4) {
+            const __m256d x = _mm256_loadu_pd(p_x + i);
+            const __m256d under = _mm256_cmp_pd(x, x_min, _CMP_LT_OQ);
+            const __m256d in = _mm256_and_pd(_mm256_cmp_pd(x, x_min, _CMP_GE_OQ),
+                                             _mm256_cmp_pd(x, x_max, _CMP_LT_OQ));
+            const __m256d t = _mm256_min_pd(_mm256_mul_pd(_mm256_sub_pd(x, x_min), k), t_max);
+            const __m128i idx = _mm_add_epi32(_mm256_cvttpd_epi32(t), one);
+            const __m128i under32 = _mm256_castsi256_si128(
+                _mm256_permutevar8x32_epi32(_mm256_castpd_si256(under), narrow));
+            const __m128i in32 = _mm256_castsi256_si128(
+                _mm256_permutevar8x32_epi32(_mm256_castpd_si256(in), narrow));
+            // in ? idx : (under ? 0 : overflow)
+            const __m128i res = _mm_blendv_epi8(_mm_andnot_si128(under32, overflow), idx, in32);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(o_idx + i), res);
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128d x_min = _mm_set1_pd(p_b.x_min);
+        const __m128d x_max = _mm_set1_pd(p_b.x_max);
+        const __m128d k = _mm_set1_pd(p_b.k);
+        const __m128d t_max = _mm_set1_pd(static_cast<double>(p_b.n_bins - 1u));
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i overflow = _mm_set1_epi32(static_cast<int>(p_b.n_bins + 1u));
+        for (; i + 2 <= p_n; i += 2) {
+            const __m128d x = _mm_loadu_pd(p_x + i);
+            const __m128d under = _mm_cmplt_pd(x, x_min);
+            const __m128d in = _mm_and_pd(_mm_cmpge_pd(x, x_min), _mm_cmplt_pd(x, x_max));
+            const __m128d t = _mm_min_pd(_mm_mul_pd(_mm_sub_pd(x, x_min), k), t_max);
+            // The two indices are in the low half, so are the narrowed masks
+            const __m128i idx = _mm_add_epi32(_mm_cvttpd_epi32(t), one);
+            const __m128i under32 = _mm_shuffle_epi32(_mm_castpd_si128(under), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128i in32 = _mm_shuffle_epi32(_mm_castpd_si128(in), _MM_SHUFFLE(2, 0, 2, 0));
+            // in ? idx : (under ? 0 : overflow)
+            const __m128i res = _mm_or_si128(_mm_and_si128(in32, idx),
+                _mm_andnot_si128(in32, _mm_andnot_si128(under32, overflow)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(o_idx + i), res);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const float64x2_t x_min = vdupq_n_f64(p_b.x_min);
+        const float64x2_t x_max = vdupq_n_f64(p_b.x_max);
+        const float64x2_t k = vdupq_n_f64(p_b.k);
+        const float64x2_t t_max = vdupq_n_f64(static_cast<double>(p_b.n_bins - 1u));
+        const uint64x2_t one = vdupq_n_u64(1u);
+        const uint64x2_t zero = vdupq_n_u64(0u);
+        const uint64x2_t overflow = vdupq_n_u64(p_b.n_bins + 1u);
+        for (; i + 2 <= p_n; i += 2) {
+            const float64x2_t x = vld1q_f64(p_x + i);
+            const uint64x2_t under = vcltq_f64(x, x_min);
+            const uint64x2_t in = vandq_u64(vcgeq_f64(x, x_min), vcltq_f64(x, x_max));
+            const float64x2_t t = vminq_f64(vmulq_f64(vsubq_f64(x, x_min), k), t_max);
+            const uint64x2_t idx = vaddq_u64(vcvtq_u64_f64(t), one);
+            vst1_u32(o_idx + i, vmovn_u64(vbslq_u64(in, idx, vbslq_u64(under, zero, overflow))));
+        }
+    }
+#endif
+    for (; i < p_n; i++) {
+        o_idx[i] = p_b.Index(p_x[i]);
+    }
+}
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace tiny_graph_plot
+{
+
+namespace simd_minmax_details
+{
+
+template<typename T>
+inline void MinMaxScalar(const T* const p_xy, const size_t p_n,
+    T o_min[2], T o_max[2]) noexcept
+{
+    for (size_t i = 0; i < p_n; i++) {
+        const T x = p_xy[2 * i + 0];
+        const T y = p_xy[2 * i + 1];
+        if (!std::isfinite(x) || !std::isfinite(y)) continue;
+        o_min[0] = (x < o_min[0]) ? x : o_min[0];
+        o_max[0] = (x > o_max[0]) ? x : o_max[0];
+        o_min[1] = (y < o_min[1]) ? y : o_min[1];
+        o_max[1] = (y > o_max[1]) ? y : o_max[1];
+    }
+}
+
+//! Fold the even (x) and odd (y) lanes of the vector accumulators
+template<typename T>
+inline void MinMaxLanes(const T* const p_min, const T* const p_max, const size_t p_n_lanes,
+    T o_min[2], T o_max[2]) noexcept
+{
+    for (size_t i = 0; i < p_n_lanes; i++) {
+        o_min[i % 2] = (p_min[i] < o_min[i % 2]) ? p_min[i] : o_min[i % 2];
+        o_max[i % 2] = (p_max[i] > o_max[i % 2]) ? p_max[i] : o_max[i % 2];
+    }
+}
+
+} // end of namespace simd_minmax_details
+
+/**
+    Minimum and maximum of the x and y coordinates of 'p_n' points stored as
+    interleaved pairs x0 y0 x1 y1 ... Points with at least one non-finite
+    coordinate are ignored. If there are no finite points, the result is
+    o_min = +inf and o_max = -inf.
+
+    The AVX2 version is used when the code is compiled with AVX2 enabled,
+    otherwise SSE2 on x86-64 and NEON on AArch64. The points left over by
+    the vector loop are processed by the scalar version.
+
+    Note that x - x is zero for finite x and NaN for infinities and NaNs.
+    The lanes of the points which are not entirely finite are replaced by
+    +inf for the minimum and by -inf for the maximum.
+*/
+inline void MinMaxFinitePoints(const float* const p_xy, const size_t p_n,
+    float o_min[2], float o_max[2]) noexcept
+{
+    o_min[0] = o_min[1] = std::numeric_limits<float>::infinity();
+    o_max[0] = o_max[1] = -std::numeric_limits<float>::infinity();
+    size_t i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256 pinf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        const __m256 ninf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 vmin = pinf;
+        __m256 vmax = ninf;
+        for (; i + 4 <= p_n; i += 4) { // 4 points per vector
+            const __m256 v = _mm256_loadu_ps(p_xy + 2 * i);
+            __m256 fin = _mm256_cmp_ps(_mm256_sub_ps(v, v), zero, _CMP_EQ_OQ);
+            fin = _mm256_and_ps(fin, _mm256_permute_ps(fin, _MM_SHUFFLE(2, 3, 0, 1)));
+            vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(pinf, v, fin));
+            vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(ninf, v, fin));
+        }
+        alignas(32) float lmin[8];
+        alignas(32) float lmax[8];
+        _mm256_store_ps(lmin, vmin);
+        _mm256_store_ps(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 8, o_min, o_max);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128 pinf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        const __m128 ninf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vmin = pinf;
+        __m128 vmax = ninf;
+        for (; i + 2 <= p_n; i += 2) { // 2 points per vector
+            const __m128 v = _mm_loadu_ps(p_xy + 2 * i);
+            __m128 fin = _mm_cmpeq_ps(_mm_sub_ps(v, v), zero);
+            fin = _mm_and_ps(fin, _mm_shuffle_ps(fin, fin, _MM_SHUFFLE(2, 3, 0, 1)));
+            vmin = _mm_min_ps(vmin, _mm_or_ps(_mm_and_ps(fin, v), _mm_andnot_ps(fin, pinf)));
+            vmax = _mm_max_ps(vmax, _mm_or_ps(_mm_and_ps(fin, v), _mm_andnot_ps(fin, ninf)));
+        }
+        alignas(16) float lmin[4];
+        alignas(16) float lmax[4];
+        _mm_store_ps(lmin, vmin);
+        _mm_store_ps(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 4, o_min, o_max);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const float32x4_t pinf = vdupq_n_f32(std::numeric_limits<float>::infinity());
+        const float32x4_t ninf = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t vmin = pinf;
+        float32x4_t vmax = ninf;
+        for (; i + 2 <= p_n; i += 2) { // 2 points per vector
+            const float32x4_t v = vld1q_f32(p_xy + 2 * i);
+            uint32x4_t fin = vceqq_f32(vsubq_f32(v, v), zero);
+            fin = vandq_u32(fin, vrev64q_u32(fin));
+            vmin = vminq_f32(vmin, vbslq_f32(fin, v, pinf));
+            vmax = vmaxq_f32(vmax, vbslq_f32(fin, v, ninf));
+        }
+        float lmin[4];
+        float lmax[4];
+        vst1q_f32(lmin, vmin);
+        vst1q_f32(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 4, o_min, o_max);
+    }
+#endif
+    simd_minmax_details::MinMaxScalar(p_xy + 2 * i, p_n - i, o_min, o_max);
+}
+
+//! See the float version above
+inline void MinMaxFinitePoints(const double* const p_xy, const size_t p_n,
+    double o_min[2], double o_max[2]) noexcept
+{
+    o_min[0] = o_min[1] = std::numeric_limits<double>::infinity();
+    o_max[0] = o_max[1] = -std::numeric_limits<double>::infinity();
+    size_t i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256d pinf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        const __m256d ninf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        const __m256d zero = _mm256_setzero_pd();
+        __m256d vmin = pinf;
+        __m256d vmax = ninf;
+        for (; i + 2 <= p_n; i += 2) { // 2 points per vector
+            const __m256d v = _mm256_loadu_pd(p_xy + 2 * i);
+            __m256d fin = _mm256_cmp_pd(_mm256_sub_pd(v, v), zero, _CMP_EQ_OQ);
+            fin = _mm256_and_pd(fin, _mm256_permute_pd(fin, 0x5));
+            vmin = _mm256_min_pd(vmin, _mm256_blendv_pd(pinf, v, fin));
+            vmax = _mm256_max_pd(vmax, _mm256_blendv_pd(ninf, v, fin));
+        }
+        alignas(32) double lmin[4];
+        alignas(32) double lmax[4];
+        _mm256_store_pd(lmin, vmin);
+        _mm256_store_pd(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 4, o_min, o_max);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128d pinf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+        const __m128d ninf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+        const __m128d zero = _mm_setzero_pd();
+        __m128d vmin = pinf;
+        __m128d vmax = ninf;
+        for (; i < p_n; i++) { // 1 point per vector
+            const __m128d v = _mm_loadu_pd(p_xy + 2 * i);
+            __m128d fin = _mm_cmpeq_pd(_mm_sub_pd(v, v), zero);
+            fin = _mm_and_pd(fin, _mm_shuffle_pd(fin, fin, 0x1));
+            vmin = _mm_min_pd(vmin, _mm_or_pd(_mm_and_pd(fin, v), _mm_andnot_pd(fin, pinf)));
+            vmax = _mm_max_pd(vmax, _mm_or_pd(_mm_and_pd(fin, v), _mm_andnot_pd(fin, ninf)));
+        }
+        alignas(16) double lmin[2];
+        alignas(16) double lmax[2];
+        _mm_store_pd(lmin, vmin);
+        _mm_store_pd(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 2, o_min, o_max);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const float64x2_t pinf = vdupq_n_f64(std::numeric_limits<double>::infinity());
+        const float64x2_t ninf = vdupq_n_f64(-std::numeric_limits<double>::infinity());
+        const float64x2_t zero = vdupq_n_f64(0.0);
+        float64x2_t vmin = pinf;
+        float64x2_t vmax = ninf;
+        for (; i < p_n; i++) { // 1 point per vector
+            const float64x2_t v = vld1q_f64(p_xy + 2 * i);
+            uint64x2_t fin = vceqq_f64(vsubq_f64(v, v), zero);
+            fin = vandq_u64(fin, vextq_u64(fin, fin, 1));
+            vmin = vminq_f64(vmin, vbslq_f64(fin, v, pinf));
+            vmax = vmaxq_f64(vmax, vbslq_f64(fin, v, ninf));
+        }
+        double lmin[2];
+        double lmax[2];
+        vst1q_f64(lmin, vmin);
+        vst1q_f64(lmax, vmax);
+        simd_minmax_details::MinMaxLanes(lmin, lmax, 2, o_min, o_max);
+    }
+#endif
+    simd_minmax_details::MinMaxScalar(p_xy + 2 * i, p_n - i, o_min, o_max);
+}
+
+} // end of namespace tiny_graph_plot
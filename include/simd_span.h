@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace tiny_graph_plot
+{
+
+/**
+    Blend 'p_color' over the RGBA8 pixel 'p_dst' with the coverage 'p_a'
+    in [0; 256]: dst = (dst * (256 - a) + color * a) / 256 for each channel.
+    Red and blue, then green and alpha are blended in pairs, the products
+    of each pair do not overflow their 16 bits.
+*/
+inline uint32_t BlendPixel(const uint32_t p_dst, const uint32_t p_color, const uint32_t p_a) noexcept
+{
+    const uint32_t na = 256u - p_a;
+    const uint32_t rb = (((p_dst & 0x00FF00FFu) * na + (p_color & 0x00FF00FFu) * p_a) >> 8) & 0x00FF00FFu;
+    const uint32_t ga = (((p_dst >> 8) & 0x00FF00FFu) * na + ((p_color >> 8) & 0x00FF00FFu) * p_a) & 0xFF00FF00u;
+    return rb | ga;
+}
+
+/**
+    Set 'p_n' RGBA8 pixels to 'p_color'.
+
+    The AVX2 version is used when the code is compiled with AVX2 enabled,
+    otherwise SSE2 on x86-64 and NEON on AArch64. The pixels left over by
+    the vector loop are processed by the scalar version.
+*/
+inline void FillSpan(uint32_t* const p_dst, const size_t p_n, const uint32_t p_color) noexcept
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i c = _mm256_set1_epi32(static_cast<int>(p_color));
+    for (; i + 8 <= p_n; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_dst + i), c);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i c = _mm_set1_epi32(static_cast<int>(p_color));
+    for (; i + 4 <= p_n; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p_dst + i), c);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint32x4_t c = vdupq_n_u32(p_color);
+    for (; i + 4 <= p_n; i += 4) {
+        vst1q_u32(p_dst + i, c);
+    }
+#endif
+    for (; i < p_n; i++) {
+        p_dst[i] = p_color;
+    }
+}
+
+/**
+    Blend 'p_color' over 'p_n' RGBA8 pixels with the coverage 'p_a' in
+    [0; 256], see BlendPixel(). The pixels are widened to 16 bits per
+    channel, so that the same formula is exact in the vector versions.
+*/
+inline void BlendSpan(uint32_t* const p_dst, const size_t p_n,
+    const uint32_t p_color, const uint32_t p_a) noexcept
+{
+    if (p_a == 0u) return;
+    if (p_a >= 256u) {
+        FillSpan(p_dst, p_n, p_color);
+        return;
+    }
+    size_t i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i na = _mm256_set1_epi16(static_cast<short>(256u - p_a));
+        const __m256i ca = _mm256_mullo_epi16(
+            _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(p_color)), zero),
+            _mm256_set1_epi16(static_cast<short>(p_a)));
+        for (; i + 8 <= p_n; i += 8) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_dst + i));
+            const __m256i lo = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero), na), ca), 8);
+            const __m256i hi = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero), na), ca), 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_dst + i), _mm256_packus_epi16(lo, hi));
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i na = _mm_set1_epi16(static_cast<short>(256u - p_a));
+        const __m128i ca = _mm_mullo_epi16(
+            _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(p_color)), zero),
+            _mm_set1_epi16(static_cast<short>(p_a)));
+        for (; i + 4 <= p_n; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_dst + i));
+            const __m128i lo = _mm_srli_epi16(
+                _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), na), ca), 8);
+            const __m128i hi = _mm_srli_epi16(
+                _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), na), ca), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p_dst + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const uint16x8_t na = vdupq_n_u16(static_cast<uint16_t>(256u - p_a));
+        const uint16x8_t ca = vmulq_u16(
+            vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(p_color))),
+            vdupq_n_u16(static_cast<uint16_t>(p_a)));
+        for (; i + 4 <= p_n; i += 4) {
+            const uint8x16_t v = vreinterpretq_u8_u32(vld1q_u32(p_dst + i));
+            const uint16x8_t lo = vshrq_n_u16(vmlaq_u16(ca, vmovl_u8(vget_low_u8(v)), na), 8);
+            const uint16x8_t hi = vshrq_n_u16(vmlaq_u16(ca, vmovl_u8(vget_high_u8(v)), na), 8);
+            vst1q_u32(p_dst + i, vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))));
+        }
+    }
+#endif
+    for (; i < p_n; i++) {
+        p_dst[i] = BlendPixel(p_dst[i], p_color, p_a);
+    }
+}
+
+} // end of namespace tiny_graph_plot
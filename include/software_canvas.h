@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "tiny_gl_text_renderer/colors.h"
+#include "tiny_gl_text_renderer/vec.h"
+#include "grid.h"
+#include "raster_image.h"
+#include "xy_range.h"
+
+namespace tiny_graph_plot
+{
+
+using tiny_gl_text_renderer::color_t;
+using tiny_gl_text_renderer::Vec2f;
+
+template<typename T> class Graph;
+template<typename T, typename VALUETYPE> class Histogram1d;
+template<typename T, typename VALUETYPE> class Histogram2d;
+
+/**
+    Renders the picture of Canvas<T> into a RasterImage on the CPU, without
+    OpenGL, a window or a GPU. The grid, the axes, the reference line, the
+    frame, the drawables and the axis labels are drawn with the same visual
+    parameters; the cursor and the value readouts, which belong to the
+    interactive window, are not. The visible range is the total range of
+    the drawables, as after ResetCamera(), unless it is set explicitly.
+
+    The image is split into bands of rows which are rendered in parallel
+    on the global thread pool. Each band draws all the primitives clipped
+    to its rows, so that they are drawn in the same order as with OpenGL.
+    The points of the drawables are transformed into pixels once per
+    Draw(), in chunks which know the rows they touch, so that a band only
+    visits the chunks crossing it.
+*/
+template<typename T>
+class SoftwareCanvas
+{
+    static_assert(std::is_same<T, float>::value
+               || std::is_same<T, double>::value, "");
+public:
+    explicit SoftwareCanvas(const unsigned int w = 800u, const unsigned int h = 600u);
+    ~SoftwareCanvas() = default;
+    SoftwareCanvas(const SoftwareCanvas& other) = delete;
+    SoftwareCanvas(SoftwareCanvas&& other) = delete;
+    SoftwareCanvas& operator=(const SoftwareCanvas& other) = delete;
+    SoftwareCanvas& operator=(SoftwareCanvas&& other) = delete;
+public:
+    void AddGraph(const Graph<T>& p_graph);
+    void AddHistogram(const Histogram1d<T, unsigned long>& p_histo);
+    void AddHistogram2d(const Histogram2d<T, unsigned long>& p_histo);
+    void Draw();
+    const RasterImage& GetImage() const noexcept { return image_; }
+    //! Show the given range instead of the total range of the drawables
+    void SetVisibleRange(const double x_min, const double x_max, const double y_min, const double y_max) noexcept {
+        fixed_range_.Set1(x_min, x_max, y_min, y_max); fixed_range_.FixDegenerateCases(); use_fixed_range_ = true; }
+    void ResetVisibleRange() noexcept { use_fixed_range_ = false; }
+    //! Draw and write the image into dir/filename as PNG, returns false if it can not be written
+    bool ExportPNG(const char* const dir, const char* const filename);
+private:
+    //! Axis-aligned line, drawn without antialiasing like the OpenGL wide lines
+    struct Rule {
+        float x0_, y0_, x1_, y1_;
+        float width_;
+        RasterImage::Paint paint_;
+        bool dotted_; //!< One pixel of 8 from the first end, as glLineStipple(1, 0x0101)
+    };
+    struct TextLabel {
+        std::string text_;
+        float x_, y_;
+        float angle_;
+        RasterImage::Paint paint_;
+    };
+    /**
+        A drawable prepared for Draw(): points in pixels and, for each chunk
+        of chunk_size_ points, the range of rows touched by the chunk
+        including the segment to the first point of the next chunk.
+    */
+    struct Layer {
+        enum class Kind { LINES, DENSITY, HISTOGRAM2D };
+        Kind kind_ = Kind::LINES;
+        std::vector<Vec2f> points_;
+        std::vector<int> chunk_rows_; //!< First and last row of each chunk
+        RasterImage::Paint paint_;
+        float line_width_ = 0.0f;
+        float marker_size_ = 0.0f;
+        unsigned int marker_first_ = 0u; //!< Markers are drawn at every marker_step_-th point
+        unsigned int marker_step_ = 1u;
+        std::vector<uint32_t> counts_; //!< DENSITY: points per pixel of the frame
+        std::vector<Vec2f> band_points_; //!< DENSITY: points inside the frame, grouped by band
+        std::vector<size_t> band_first_; //!< DENSITY: first of band_points_ of each band and the end
+        std::vector<uint32_t> band_max_;
+        uint32_t max_count_ = 0u;
+        const Histogram2d<T, unsigned long>* histo2d_ = nullptr;
+        std::vector<int> bin_x_; //!< HISTOGRAM2D: bin of each column of the frame, -1 outside
+    };
+    static constexpr unsigned int chunk_size_ = 256u;
+    static constexpr int band_height_ = 32;
+private:
+    void UpdateTotalRange();
+    void PrepareRules();
+    void PrepareLabels();
+    void PrepareLayers();
+    Layer& NextLayer(const typename Layer::Kind p_kind);
+    void TransformPoints(const Vec2<T>* const p_points, const unsigned int p_n,
+                         const float p_margin, Layer& o_layer) const;
+    void BinByBand(Layer& p_layer, const unsigned int p_n_bands) const;
+    void CountDensity(Layer& p_layer, const RasterImage::ClipRect& p_clip, const size_t p_band);
+    void DrawRule(const Rule& p_rule, const RasterImage::ClipRect& p_clip);
+    void DrawLayer(const Layer& p_layer, const RasterImage::ClipRect& p_clip);
+    void DrawBand(const RasterImage::ClipRect& p_clip);
+private:
+    std::vector<const Graph<T>*> graphs_;
+    std::vector<const Histogram1d<T, unsigned long>*> histograms_;
+    std::vector<const Histogram2d<T, unsigned long>*> histograms2d_;
+    XYrange<double> total_xy_range_;
+    XYrange<double> visible_range_;
+    XYrange<double> fixed_range_; //!< See SetVisibleRange()
+    bool use_fixed_range_ = false;
+    Grid<double> grid_;
+    bool grid_valid_ = false; //!< The steps are set and the wires are built
+    RasterImage image_;
+    std::vector<uint32_t> colormap_; //!< See BuildViridisColormap()
+    // Prepared by Draw()
+    RasterImage::ClipRect frame_;
+    double scale_x_ = 1.0; //!< Visible range to pixels
+    double scale_y_ = 1.0;
+    std::vector<Rule> frame_rules_; //!< Grid, axes and the reference line, clipped to the frame
+    std::vector<Rule> window_rules_; //!< Frame
+    std::vector<TextLabel> labels_;
+    std::vector<Layer> layers_;
+    size_t n_layers_ = 0u; //!< Layers in use, the others keep their memory for the next Draw()
+    std::vector<unsigned int> decimated_vertices_; //!< See Graph::DecimateToColumns()
+    std::vector<Vec2<T>> decimated_points_;
+public: // visual parameters
+    void SetXaxisTitle(const char* title) { x_axis_title_ = std::string(title); }
+    void SetYaxisTitle(const char* title, const bool rotated = false) {
+        y_axis_title_ = std::string(title); y_axis_title_rotated_ = rotated; }
+    void EnableHgrid()  noexcept { enable_hgrid_ = true; }
+    void EnableVgrid()  noexcept { enable_vgrid_ = true; }
+    void EnableAxes()   noexcept { enable_axes_  = true; }
+    void EnableVref()   noexcept { enable_vref_  = true; }
+    void EnableFrame()  noexcept { enable_frame_ = true; }
+    void DisableHgrid() noexcept { enable_hgrid_ = false; }
+    void DisableVgrid() noexcept { enable_vgrid_ = false; }
+    void DisableAxes()  noexcept { enable_axes_  = false; }
+    void DisableVref()  noexcept { enable_vref_  = false; }
+    void DisableFrame() noexcept { enable_frame_ = false; }
+    // Color settings ------------------------------------------------------------
+    void SetDarkColorScheme();
+    void SetBrightColorScheme();
+    void SetBackgroundColor       (const color_t& color) noexcept { background_color_ = color; }
+    void SetInFrameBackgroundColor(const color_t& color) noexcept { in_frame_bg_color_ = color; }
+    void SetHGridFineColor  (const color_t& color) noexcept { grid_.SetHGridFineColor(color); }
+    void SetVGridFineColor  (const color_t& color) noexcept { grid_.SetVGridFineColor(color); }
+    void SetHGridCoarseColor(const color_t& color) noexcept { grid_.SetHGridCoarseColor(color); }
+    void SetVGridCoarseColor(const color_t& color) noexcept { grid_.SetVGridCoarseColor(color); }
+    void SetAxesColor       (const color_t& color) noexcept { axes_line_color_  = color; }
+    void SetVrefColor       (const color_t& color) noexcept { vref_line_color_  = color; }
+    void SetFrameColor      (const color_t& color) noexcept { frame_line_color_ = color; }
+    void SetTextColor       (const color_t& color) noexcept { gen_text_color_   = color; }
+    // ---------------------------------------------------------------------------
+    void SetHGridFineLineWidth  (const float width) noexcept { grid_.SetHGridFineLineWidth(width); }
+    void SetVGridFineLineWidth  (const float width) noexcept { grid_.SetVGridFineLineWidth(width); }
+    void SetHGridCoarseLineWidth(const float width) noexcept { grid_.SetHGridCoarseLineWidth(width); }
+    void SetVGridCoarseLineWidth(const float width) noexcept { grid_.SetVGridCoarseLineWidth(width); }
+    void SetAxesLineWidth       (const float width) noexcept { axes_line_width_ = width; }
+    void SetVrefLineWidth       (const float width) noexcept { vref_line_width_ = width; }
+    void SetFontSize(const float size) noexcept { font_size_ = size; }
+    void SetAllMargins(const unsigned int xl_in_pix, const unsigned int xr_in_pix,
+        const unsigned int yb_in_pix, const unsigned int yt_in_pix) noexcept {
+        margin_xl_pix_ = xl_in_pix; margin_xr_pix_ = xr_in_pix;
+        margin_yb_pix_ = yb_in_pix; margin_yt_pix_ = yt_in_pix;
+    }
+private: // visual parameters
+    std::string x_axis_title_ = "x axis";
+    std::string y_axis_title_ = "y axis";
+    bool y_axis_title_rotated_ = true;
+    bool enable_hgrid_ = true;
+    bool enable_vgrid_ = true;
+    bool enable_axes_  = true;
+    bool enable_vref_  = true;
+    bool enable_frame_ = true;
+    color_t background_color_  = tiny_gl_text_renderer::colors::gray1;
+    color_t in_frame_bg_color_ = tiny_gl_text_renderer::colors::gray05;
+    color_t axes_line_color_   = tiny_gl_text_renderer::colors::gray75;
+    color_t vref_line_color_   = tiny_gl_text_renderer::colors::olive;
+    color_t frame_line_color_  = tiny_gl_text_renderer::colors::gray5;
+    color_t gen_text_color_    = tiny_gl_text_renderer::colors::white;
+    float axes_line_width_ = 3.0f;
+    float vref_line_width_ = 3.0f;
+    float font_size_ = 1.0f;
+    unsigned int margin_xl_pix_ = 280u;
+    unsigned int margin_xr_pix_ = 22u;
+    unsigned int margin_yb_pix_ = 34u;
+    unsigned int margin_yt_pix_ = 22u;
+    static constexpr int _v_offset = 2;
+};
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace tiny_graph_plot
+{
+
+/**
+    Bounded lock-free queue between one producer thread and one consumer
+    thread. The storage is allocated once by Init(), after which Push() and
+    Drain() neither allocate nor wait for each other: each side writes only
+    its own index and reads the index of the other side. Elements which do
+    not fit are rejected instead of waited for. Init() must be called before
+    the two threads start using the queue.
+*/
+template<typename E>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable<E>::value, "");
+public:
+    explicit SpscQueue() = default;
+    ~SpscQueue() = default;
+    SpscQueue(const SpscQueue& other) = delete;
+    SpscQueue(SpscQueue&& other) = delete;
+    SpscQueue& operator=(const SpscQueue& other) = delete;
+    SpscQueue& operator=(SpscQueue&& other) = delete;
+public:
+    //! Space for at least 'p_capacity' elements, rounded up to a power of two. Returns false on failure.
+    bool Init(const size_t p_capacity);
+    bool IsInitialized() const noexcept { return capacity_ != 0u; }
+    size_t GetCapacity() const noexcept { return capacity_; }
+    //! Producer. Copy as many of the 'p_n' elements as fit, returns their number.
+    size_t Push(const E* const p_elements, const size_t p_n) noexcept;
+    /**
+        Consumer. Pass the queued elements to p_func(const E* elements, size_t n)
+        in at most two contiguous spans, then free their space.
+        Returns the number of elements.
+    */
+    template<typename F>
+    size_t Drain(F&& p_func);
+    //! Number of queued elements, from either thread it is only a snapshot
+    size_t GetSize() const noexcept;
+private:
+    static constexpr size_t cache_line_size_ = 64u;
+    std::vector<E> elements_;
+    size_t capacity_ = 0u;
+    size_t mask_ = 0u;
+    // The indices grow without wrapping around the storage, each on its own cache line
+    alignas(cache_line_size_) std::atomic<size_t> tail_{0u}; //!< Next free element, written by the producer
+    size_t head_cache_ = 0u; //!< Last head_ seen by the producer
+    alignas(cache_line_size_) std::atomic<size_t> head_{0u}; //!< Next queued element, written by the consumer
+};
+
+} // end of namespace tiny_graph_plot
+
+#include "spsc_queue_inline.h"
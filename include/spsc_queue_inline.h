@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+
+namespace tiny_graph_plot
+{
+
+template<typename E>
+inline bool SpscQueue<E>::Init(const size_t p_capacity)
+{
+    if (p_capacity == 0u) return false;
+    size_t capacity = 1u;
+    while (capacity < p_capacity) capacity <<= 1;
+    try {
+        elements_.resize(capacity);
+    } catch (const std::bad_alloc&) {
+        fprintf(stderr, "ERROR: failed to allocate a queue of %zu elements.\n", capacity);
+        return false;
+    }
+    capacity_ = capacity;
+    mask_ = capacity - 1u;
+    tail_.store(0u, std::memory_order_relaxed);
+    head_.store(0u, std::memory_order_relaxed);
+    head_cache_ = 0u;
+    return true;
+}
+
+template<typename E>
+inline size_t SpscQueue<E>::Push(const E* const p_elements, const size_t p_n) noexcept
+{
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t n_free = capacity_ - (tail - head_cache_);
+    if (n_free < p_n) {
+        // The consumer's cache line is only touched when the queue looks full
+        head_cache_ = head_.load(std::memory_order_acquire);
+        n_free = capacity_ - (tail - head_cache_);
+    }
+    const size_t n = std::min(p_n, n_free);
+    if (n == 0u) return 0u;
+    const size_t first = tail & mask_;
+    const size_t n1 = std::min(n, capacity_ - first);
+    std::copy(p_elements, p_elements + n1, elements_.data() + first);
+    std::copy(p_elements + n1, p_elements + n, elements_.data());
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+template<typename E>
+template<typename F>
+inline size_t SpscQueue<E>::Drain(F&& p_func)
+{
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t n = tail - head;
+    if (n == 0u) return 0u;
+    const size_t first = head & mask_;
+    const size_t n1 = std::min(n, capacity_ - first);
+    p_func(static_cast<const E*>(elements_.data() + first), n1);
+    if (n1 < n) {
+        p_func(static_cast<const E*>(elements_.data()), n - n1);
+    }
+    head_.store(tail, std::memory_order_release);
+    return n;
+}
+
+template<typename E>
+inline size_t SpscQueue<E>::GetSize() const noexcept
+{
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    // The head is loaded first, so it can not be past the tail
+    return tail - head;
+}
+
+} // end of namespace tiny_graph_plot
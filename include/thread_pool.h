@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tiny_graph_plot
+{
+
+/**
+    A minimal pool of worker threads for data-parallel loops.
+    The calling thread takes part in the work, so a pool with N threads
+    starts N - 1 workers. Calls from within a task are executed serially
+    by the calling thread, hence the tasks may safely use the pool again.
+*/
+class ThreadPool
+{
+public:
+    //! 'p_n_threads' = 0 means one thread per hardware thread
+    explicit ThreadPool(const unsigned int p_n_threads = 0u);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool(ThreadPool&& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+    ThreadPool& operator=(ThreadPool&& other) = delete;
+public:
+    //! The pool shared by the whole library
+    static ThreadPool& GetGlobal();
+    //! Number of threads which may execute tasks, including the caller
+    unsigned int GetNthreads() const noexcept {
+        return static_cast<unsigned int>(workers_.size()) + 1u;
+    }
+    /**
+        Call p_task(i) for each i in [0; p_n_tasks) and return when all the
+        calls are finished. The order of the calls is not specified.
+    */
+    void ParallelFor(const unsigned int p_n_tasks,
+                     const std::function<void(unsigned int)>& p_task);
+private:
+    void WorkerLoop();
+    void RunTasks();
+private:
+    std::vector<std::thread> workers_;
+    std::mutex call_mutex_; //!< One ParallelFor() at a time
+    std::mutex mutex_;
+    std::condition_variable cv_work_;
+    std::condition_variable cv_done_;
+    const std::function<void(unsigned int)>* task_ = nullptr;
+    unsigned int n_tasks_ = 0u;
+    std::atomic<unsigned int> next_task_{0u};
+    std::atomic<unsigned int> n_done_{0u};
+    unsigned int n_busy_ = 0u; //!< Workers inside RunTasks()
+    unsigned long generation_ = 0u; //!< Incremented for each ParallelFor()
+    bool stop_ = false;
+};
+
+} // end of namespace tiny_graph_plot
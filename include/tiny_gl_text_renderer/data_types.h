@@ -47,6 +47,28 @@ public:
     tex_coords_t tex_coords_;
 };
 
+//! A corner of a glyph quad, see TextRenderer
+class vertex_glyph_t
+{
+public:
+    explicit vertex_glyph_t() = default;
+    explicit vertex_glyph_t(
+        const float x, const float y, const float z, const float w,
+        const float u, const float v, const color_t& color) noexcept
+    :   coords_(x, y, z, w),
+        tex_coords_(u, v),
+        color_(color) {}
+    ~vertex_glyph_t() = default;
+    vertex_glyph_t(const vertex_glyph_t& other) = default;
+    vertex_glyph_t(vertex_glyph_t&& other) = default;
+    vertex_glyph_t& operator=(const vertex_glyph_t& other) = default;
+    vertex_glyph_t& operator=(vertex_glyph_t&& other) = default;
+public:
+    point_t coords_;
+    tex_coords_t tex_coords_;
+    color_t color_;
+};
+
 class marker_t
 {
 public:
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "texture_filler.h"
+
+namespace tiny_gl_text_renderer
+{
+
+/**
+    All the glyphs of font_table.h in one single-channel image, one byte
+    per pixel, rows from top to bottom. The image is built once and shared
+    by all the text renderers, each of which uploads it into a texture of
+    its own context. The glyphs are put on a grid of cells with a one-pixel
+    gap around them, so that sampling at the edge of a glyph never picks
+    up its neighbour.
+*/
+class GlyphAtlas
+{
+public:
+    static constexpr int cell_w_ = CHAR_WIDTH + 2;
+    static constexpr int cell_h_ = CHAR_HEIGHT + 2;
+    static constexpr int n_columns_ = 16;
+public:
+    static const GlyphAtlas& Get();
+    ~GlyphAtlas() = default;
+    GlyphAtlas(const GlyphAtlas& other) = delete;
+    GlyphAtlas(GlyphAtlas&& other) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas& other) = delete;
+    GlyphAtlas& operator=(GlyphAtlas&& other) = delete;
+public:
+    int GetW() const noexcept { return w_; }
+    int GetH() const noexcept { return h_; }
+    const unsigned char* GetData() const noexcept { return data_.data(); }
+    /**
+        Top-left pixel of the glyph of 'p_character' in the image.
+        Returns false for the characters which leave no trace:
+        the space and the ones not in the font table.
+    */
+    static bool GetGlyph(const char p_character, int& o_x, int& o_y) noexcept;
+private:
+    GlyphAtlas();
+private:
+    int w_;
+    int h_;
+    std::vector<unsigned char> data_;
+};
+
+} // end of namespace tiny_gl_text_renderer
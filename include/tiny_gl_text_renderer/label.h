@@ -2,7 +2,6 @@
 
 #include <string>
 #include <cmath>
-#include <utility>
 
 #include "mat3.h"
 #include "texture_filler.h"
@@ -10,46 +9,24 @@
 namespace tiny_gl_text_renderer
 {
 
-typedef unsigned int GLuint;
-
 class Label
 {
 public:
     explicit Label(const char* string, const int x, const int y,
         const color_t& color, const float scaling, const float angle = 0.0f)
     :   _string(string), _x(x), _y(y), _color(color),
-        _scaling(scaling), _angle(angle), _texture_data(nullptr) {
-        const size_t newSize = GetRequiredTextureSize(string,
-            _texture_w, _texture_h) * 4 * sizeof(float);
-        _texture_data = (float*)malloc(newSize);
-        tiny_gl_text_renderer::FillString(string, _texture_data, 4,
-            _texture_w, _texture_h, 0, 0, color.GetData(), 4);
-    }
-    ~Label(void) {
-        if (_texture_data != nullptr) free(_texture_data);
-    }
+        _scaling(scaling), _angle(angle) {}
+    ~Label(void) = default;
     Label(const Label& other) = delete;
-    Label(Label&& other) noexcept
-    :   _string(std::move(other._string)), _x(other._x), _y(other._y),
-        _color(std::move(other._color)), _scaling(other._scaling),
-        _angle(other._angle), _texture_w(other._texture_w),
-        _texture_h(other._texture_h),
-        _texture_data(std::exchange(other._texture_data, nullptr)),
-        tex_id_(other.tex_id_)
-    {}
+    Label(Label&& other) noexcept = default;
     Label& operator=(const Label& other) = delete;
     Label& operator=(Label&& other) = delete;
 public:
-    void UpdateString(const char* string) {
-        std::string new_string(string);
-        if (_string == new_string) return;
-        _string = new_string;
-        const size_t newSize = GetRequiredTextureSize(string,
-            _texture_w, _texture_h) * 4 * sizeof(float);
-        _texture_data = (float*)realloc(_texture_data, newSize);
-        if (_texture_data == nullptr) return; //ERROR
-        tiny_gl_text_renderer::FillString(string, _texture_data, 4,
-            _texture_w, _texture_h, 0, 0, _color.GetData(), 4);
+    //! Returns false if the string is the same
+    bool UpdateString(const char* string) {
+        if (_string == string) return false;
+        _string = string;
+        return true;
     }
     void UpdatePosition(const int x, const int y) noexcept { _x = x; _y = y; }
     void UpdatePositionX(const int x) noexcept { _x = x; }
@@ -71,9 +48,7 @@ public:
     int GetTexY() const noexcept { return _y; }
     float GetScaling() const noexcept { return _scaling; }
     float GetAngle() const noexcept { return _angle; }
-    size_t GetTexW() const noexcept { return _texture_w; }
-    size_t GetTexH() const noexcept { return _texture_h; }
-    const float* GetTexData() const noexcept { return _texture_data; }
+    const color_t& GetColor() const noexcept { return _color; }
 private:
     std::string _string;
     int _x;
@@ -81,11 +56,10 @@ private:
     color_t _color;
     float _scaling;
     float _angle;
-    size_t _texture_w;
-    size_t _texture_h;
-    float* _texture_data;
 public:
-    GLuint tex_id_ = 0; //TODO invent proper initialization
+    // The glyph quads of the label in the vertex buffer of TextRenderer
+    size_t first_glyph_ = 0u;
+    size_t n_glyph_slots_ = 0u;
 };
 
 } // end of namespace tiny_gl_text_renderer
@@ -6,20 +6,24 @@ namespace tiny_gl_text_renderer
 const char* text_rend_vp_source = R"(#version 400
 layout (location = 0) in vec4 in_position;
 layout (location = 1) in vec2 in_tex_coord;
+layout (location = 2) in vec4 in_color;
 uniform mat4 screen2clip;
 out vec2 v_tex_coord;
+out vec4 v_color;
 void main() {
     gl_Position = screen2clip * in_position;
     v_tex_coord = in_tex_coord;
+    v_color = in_color;
 }
 )";
 
 const char* text_rend_fp_source = R"(#version 400
 in vec2 v_tex_coord;
+in vec4 v_color;
 layout(location = 0) out vec4 f_color;
-uniform sampler2D textureSampler;
+uniform sampler2D textureSampler; // Glyph atlas, coverage in the red channel
 void main() {
-    f_color = texture(textureSampler, v_tex_coord);
+    f_color = v_color * texture(textureSampler, v_tex_coord).r;
 }
 )";
 
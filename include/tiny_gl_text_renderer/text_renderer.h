@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "data_types.h"
@@ -11,6 +12,15 @@
 namespace tiny_gl_text_renderer
 {
 
+/**
+    Draws all the labels with a single draw call. Each glyph is a quad
+    textured from the glyph atlas (see GlyphAtlas) and colored per vertex.
+    Each label owns a range of glyph slots in one vertex buffer; the slots
+    it does not use are empty quads. Changing a label rewrites only its
+    own slots, unless the new string does not fit: then the label is moved
+    to the slots released by another label or, if none are large enough,
+    to new slots at the end, and then the whole buffer is sent again.
+*/
 class TextRenderer
 {
 public:
@@ -36,23 +46,30 @@ public:
     void UpdatePositionY(const int y, const size_t i_label);
     void UpdateRotation(const float angle, const size_t i_label);
     void RecalculateVertices();
-    void SendToGPU() const;
-    void SendToGPUverticesSingle(const size_t i_label) const;
-    void SendToGPUtextureSingle(const size_t i_label) const;
+    void SendToGPU();
+    void SendToGPUverticesSingle(const size_t i_label);
 private:
-    void AllocateVerticesAndQuadsMemory();
+    //! Give the label enough released or new slots for 'n_glyphs'
+    void AllocateGlyphSlots(Label& label, const size_t n_glyphs);
+    //! The slots of the label become free for AllocateGlyphSlots()
+    void ReleaseGlyphSlots(const Label& label);
     void RecalculateVerticesSingle(const size_t i_label);
+    static size_t CountGlyphs(const std::string& string) noexcept;
 private:
-    unsigned int _w;
-    unsigned int _h;
-    tiny_graph_plot::BufferSet<vertex_textured_t> buf_set_text_; //TODO reorganize.
+    unsigned int _w = 0u;
+    unsigned int _h = 0u;
+    tiny_graph_plot::BufferSet<vertex_glyph_t> buf_set_text_; //TODO reorganize.
     tiny_graph_plot::ShaderProgram prog_text_; //TODO reorganize.
     Mat4f _screen_to_clip;
+    GLuint _atlas_tex_id = 0u;
 private:
     unsigned int _labels_counter = 0u;
     std::vector<Label> _labels;
-    std::vector<vertex_textured_t> _vertices;
+    std::vector<vertex_glyph_t> _vertices; //!< Four per glyph slot
     std::vector<quad_t> _quads;
+    size_t _n_glyph_slots = 0u;
+    std::vector<std::pair<size_t, size_t>> _free_glyph_slots; //!< First slot and size of the free ranges, sorted
+    size_t _n_glyph_slots_on_gpu = 0u; //!< Zero until the first SendToGPU()
 };
 
 } // end of namespace tiny_gl_text_renderer
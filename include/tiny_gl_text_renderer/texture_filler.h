@@ -33,7 +33,7 @@ constexpr int OFFSET = 2;
     if something can be printed, it will be printed.
     If the line does not fit, it will be cropped and 1 will be returned.
 */
-static
+inline
 int FillCharacter(
     const char character,
     float* texture,
@@ -66,7 +66,7 @@ int FillCharacter(
     return ret_val;
 }
 
-static
+inline
 int FillString(
     const char* line,
     float* texture,
@@ -108,7 +108,7 @@ int FillString(
     filled with the required width and height of the texture.
     In fact, the returned value is o_w*o_h;
 */
-static
+inline
 size_t GetRequiredTextureSize(const char* line, size_t& o_w, size_t& o_h)
 {
     o_h = 0u;
@@ -8,9 +8,13 @@
 #include "tiny_gl_text_renderer/vec.h"
 #include "tiny_gl_text_renderer/colors.h"
 #include "graph_manager.h"
+#include "graph_file.h"
+#include "graph_text_file.h"
 #include "canvas_manager.h"
+#include "software_canvas.h"
+#include "batch_renderer.h"
 
 tiny_graph_plot::GraphManager<float> global_graph_manager_float;
 tiny_graph_plot::GraphManager<double> global_graph_manager_double;
-tiny_graph_plot::CanvasManager<float> global_canvas_manager_float;
-tiny_graph_plot::CanvasManager<double> global_canvas_manager_double;
+tiny_graph_plot::CanvasManager<float> global_canvas_manager_float(&global_graph_manager_float);
+tiny_graph_plot::CanvasManager<double> global_canvas_manager_double(&global_graph_manager_double);
@@ -5,6 +5,8 @@ struct GLFWwindow;
 namespace tiny_graph_plot
 {
 
+class OffscreenContext;
+
 enum class action_t
 {
     ACT_NO_ACT,
@@ -19,12 +21,15 @@ enum class action_t
 class UserWindow
 {
 protected:
-    explicit UserWindow(GLFWwindow* window, const unsigned int w, const unsigned int h);
+    //! Without a window the offscreen context is used, there are no events then
+    explicit UserWindow(GLFWwindow* window, const unsigned int w, const unsigned int h,
+        const OffscreenContext* offscreen_context = nullptr);
     virtual ~UserWindow() {}
 private:
     void SetCallbacks() const;
 public:
     GLFWwindow* GetWindow() const { return _window; }
+    void MakeContextCurrent() const;
     void framebuffer_size_event(int width, int height);
     void window_pos_event(int xpos, int ypos);
     void window_iconify_event(int iconified);
@@ -35,6 +40,28 @@ public:
     void mouse_button_event(int button, int action, int mods);
     void mouse_pos_event(double xs, double ys_inv);
     void scroll_event(double xoffset, double yoffset);
+public: // frame scheduling
+    /**
+        The events only record the new state and request a frame, which is
+        drawn later by RenderFrameIfDue(), see CanvasManager::PollEvents().
+        Thus any number of events between two frames costs one frame, and
+        pan and zoom are applied once with the latest pointer position.
+    */
+    void RequestFrame() noexcept { _frame_requested = true; }
+    bool IsFrameRequested() const noexcept { return _frame_requested; }
+    //! Draw the requested frame unless the frame rate cap delays it, returns true if drawn
+    bool RenderFrameIfDue(const double p_now);
+    //! Seconds until the requested frame may be drawn, negative if none is requested
+    double GetTimeToNextFrame(const double p_now) const noexcept;
+    //! Frames per second at most, 0 - no limit besides the swap interval
+    void SetMaxFPS(const double fps) noexcept { _min_frame_interval = (fps > 0.0) ? 1.0 / fps : 0.0; }
+    //! Vertical blanks per buffer swap, see glfwSwapInterval(). 1 by default, 0 disables vsync.
+    void SetSwapInterval(const int interval);
+private:
+    //! What is drawn on top of the canvas
+    enum class overlay_t { OVL_NONE, OVL_CURSOR, OVL_SELECTION };
+    void RenderFrame();
+    void ApplyPendingView();
 protected:
     virtual void CenterView(const double xs,  const double ys) = 0;
     virtual void Pan       (const double xs,  const double ys) = 0;
@@ -53,6 +80,7 @@ protected:
                               double& o_xs, double& o_ys) const = 0;
     virtual void SaveStartState() = 0;
     virtual void ToggleGraphVisibility(const int iGraph) const = 0;
+    virtual void TogglePerfOverlay() = 0;
     virtual void Clear() const = 0;
     virtual void Reshape(int p_width, int p_height) = 0;
     virtual void Draw() /*const*/ = 0;
@@ -64,6 +92,7 @@ protected:
     virtual void UpdateTexTextRef(const double xs, const double ys) = 0;
 protected:
     GLFWwindow* _window = nullptr;
+    const OffscreenContext* _offscreen_context = nullptr; //!< Only without a window
     int _window_w;
     int _window_h;
     bool _mouse_moved = false;
@@ -72,6 +101,14 @@ protected:
     double _ys_prev; //!< At the previous position
     double _xs_start; //!< At mouse press
     double _ys_start; //!< At mouse press
+private: // frame scheduling
+    double _xs_cur = 0.0; //!< Latest pointer position
+    double _ys_cur = 0.0; //!< Latest pointer position
+    bool _view_pending = false; //!< _cur_action is to be applied at _xs_cur, _ys_cur
+    overlay_t _overlay = overlay_t::OVL_NONE;
+    bool _frame_requested = false;
+    double _min_frame_interval = 0.0;
+    double _last_frame_time = -1.0e30;
 };
 
 } // end of namespace tiny_graph_plot
@@ -24,6 +24,10 @@ public:
     XYrange& operator=(const XYrange& other) = default;
     XYrange& operator=(XYrange&& other) = default;
 public:
+    bool operator==(const XYrange& rhs) const noexcept {
+        return x_min_ == rhs.x_min_ && dx_ == rhs.dx_ && y_min_ == rhs.y_min_ && dy_ == rhs.dy_;
+    }
+    bool operator!=(const XYrange& rhs) const noexcept { return !(*this == rhs); }
     template<typename U>
     XYrange& operator=(const XYrange<U>& rhs) {
         x_min_ = static_cast<T>(rhs.lowx());
@@ -0,0 +1,51 @@
+// Command line front end of BatchRenderer:
+//     tiny_graph_plot_batch [-j threads] specs.txt [more_specs.txt ...]
+// Renders the plots of the spec files (see PlotSpec) into PNG images
+// and reports the throughput.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "batch_renderer.h"
+
+static void PrintUsage(const char* const p_name)
+{
+    fprintf(stderr, "Usage: %s [-j threads] specs.txt [more_specs.txt ...]\n"
+                    "    -j  number of plots rendered in parallel, all the hardware threads by default\n",
+                    p_name);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int n_threads = 0u;
+    std::vector<const char*> spec_files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            n_threads = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            spec_files.push_back(argv[i]);
+        }
+    }
+    if (spec_files.empty()) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    tiny_graph_plot::BatchRenderer renderer(n_threads);
+    for (const char* const path : spec_files) {
+        if (!renderer.LoadSpecs(path)) return EXIT_FAILURE;
+    }
+    const tiny_graph_plot::BatchStats stats = renderer.Run();
+    printf("%u plots in %.3f s on %u threads: %.1f plots/s",
+        stats.n_plots_, stats.seconds_, stats.n_threads_, stats.GetPlotsPerSecond());
+    if (stats.n_failed_ > 0u) {
+        printf(", %u failed", stats.n_failed_);
+    }
+    printf("\n");
+    return (stats.n_failed_ == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
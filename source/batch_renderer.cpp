@@ -0,0 +1,275 @@
+#include "batch_renderer.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+#include "graph_file.h"
+#include "graph_manager.h"
+#include "graph_text_file.h"
+#include "software_canvas.h"
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+static bool ParseDouble(const std::string& p_str, double& o_value)
+{
+    char* end = nullptr;
+    o_value = strtod(p_str.c_str(), &end);
+    return !p_str.empty() && *end == '\0';
+}
+
+static bool ParseUint(const std::string& p_str, unsigned int& o_value)
+{
+    char* end = nullptr;
+    const unsigned long value = strtoul(p_str.c_str(), &end, 10);
+    o_value = (unsigned int)value;
+    return !p_str.empty() && p_str[0] != '-' && *end == '\0';
+}
+
+//! "a<sep>b" into two doubles
+static bool ParsePair(const std::string& p_str, const char p_sep, double& o_a, double& o_b)
+{
+    const size_t pos = p_str.find(p_sep);
+    if (pos == std::string::npos) return false;
+    return ParseDouble(p_str.substr(0, pos), o_a) && ParseDouble(p_str.substr(pos + 1u), o_b);
+}
+
+static bool ParseColor(const std::string& p_str, color_t& o_color)
+{
+    namespace colors = tiny_gl_text_renderer::colors;
+    static const struct { const char* name_; const color_t* color_; } named[] = {
+        { "white", &colors::white }, { "black", &colors::black }, { "gray", &colors::gray5 },
+        { "red", &colors::red }, { "lime", &colors::lime }, { "blue", &colors::blue },
+        { "yellow", &colors::yellow }, { "cyan", &colors::cyan }, { "magenta", &colors::magenta },
+        { "silver", &colors::silver }, { "maroon", &colors::maroon }, { "olive", &colors::olive },
+        { "green", &colors::green }, { "purple", &colors::purple }, { "teal", &colors::teal },
+        { "navy", &colors::navy } };
+    for (const auto& entry : named) {
+        if (p_str == entry.name_) {
+            o_color = *entry.color_;
+            return true;
+        }
+    }
+    float c[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    size_t n = 0u;
+    size_t begin = 0u;
+    while (n < 4u) {
+        const size_t end = p_str.find(',', begin);
+        double value;
+        if (!ParseDouble(p_str.substr(begin, end - begin), value)) return false;
+        c[n++] = (float)value;
+        if (end == std::string::npos) break;
+        begin = end + 1u;
+    }
+    if (n < 3u) return false;
+    o_color = color_t(c[0], c[1], c[2], c[3]);
+    return true;
+}
+
+//! The magic of GraphFileHeader
+static bool IsGraphFile(const char* const p_path)
+{
+    FILE* const file = fopen(p_path, "rb");
+    if (file == nullptr) return false;
+    char magic[8] = {};
+    const bool res = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     memcmp(magic, "TGPGRAPH", sizeof(magic)) == 0;
+    fclose(file);
+    return res;
+}
+
+//! Prepend 'p_dir' unless the path is absolute
+static void ResolvePath(const std::string& p_dir, std::string& p_path)
+{
+    if (p_dir.empty() || p_path.empty()) return;
+    const bool absolute = p_path[0] == '/' || p_path[0] == '\\' ||
+        (p_path.size() > 1u && p_path[1] == ':');
+    if (!absolute) {
+        p_path = p_dir + "/" + p_path;
+    }
+}
+
+bool BatchRenderer::ParseSpec(const std::string& p_line, PlotSpec& o_spec)
+{
+    PlotSpec spec;
+    size_t pos = 0u;
+    const size_t len = p_line.size();
+    while (true) {
+        while (pos < len && isspace((unsigned char)p_line[pos])) pos++;
+        if (pos == len || p_line[pos] == '#') break;
+        const size_t eq = p_line.find('=', pos);
+        size_t key_end = pos;
+        while (key_end < len && !isspace((unsigned char)p_line[key_end])) key_end++;
+        if (eq == std::string::npos || eq >= key_end) {
+            fprintf(stderr, "ERROR: expected key=value instead of '%s'.\n",
+                p_line.substr(pos, key_end - pos).c_str());
+            return false;
+        }
+        const std::string key = p_line.substr(pos, eq - pos);
+        std::string value;
+        pos = eq + 1u;
+        if (pos < len && p_line[pos] == '"') {
+            const size_t quote = p_line.find('"', pos + 1u);
+            if (quote == std::string::npos) {
+                fprintf(stderr, "ERROR: unterminated quotes in the value of '%s'.\n", key.c_str());
+                return false;
+            }
+            value = p_line.substr(pos + 1u, quote - pos - 1u);
+            pos = quote + 1u;
+        } else {
+            const size_t begin = pos;
+            while (pos < len && !isspace((unsigned char)p_line[pos])) pos++;
+            value = p_line.substr(begin, pos - begin);
+        }
+
+        bool ok = true;
+        double a, b;
+        if (key == "data") {
+            spec.data_path_ = value;
+        } else if (key == "x") {
+            ok = ParseUint(value, spec.x_column_);
+        } else if (key == "y") {
+            ok = ParseUint(value, spec.y_column_);
+        } else if (key == "out") {
+            spec.out_path_ = value;
+        } else if (key == "size") {
+            ok = ParsePair(value, 'x', a, b) && a >= 1.0 && b >= 1.0;
+            spec.width_ = (unsigned int)a;
+            spec.height_ = (unsigned int)b;
+        } else if (key == "xrange") {
+            ok = ParsePair(value, ':', spec.x_min_, spec.x_max_) && spec.x_min_ < spec.x_max_;
+            spec.has_x_range_ = true;
+        } else if (key == "yrange") {
+            ok = ParsePair(value, ':', spec.y_min_, spec.y_max_) && spec.y_min_ < spec.y_max_;
+            spec.has_y_range_ = true;
+        } else if (key == "color") {
+            ok = ParseColor(value, spec.color_);
+        } else if (key == "line") {
+            ok = ParseDouble(value, a) && a >= 0.0;
+            spec.line_width_ = (float)a;
+        } else if (key == "marker") {
+            ok = ParseDouble(value, a) && a >= 0.0;
+            spec.marker_size_ = (float)a;
+        } else if (key == "density") {
+            ok = (value == "0" || value == "1");
+            spec.density_ = (value == "1");
+        } else if (key == "scheme") {
+            ok = (value == "dark" || value == "bright");
+            spec.bright_ = (value == "bright");
+        } else if (key == "xtitle") {
+            spec.x_title_ = value;
+        } else if (key == "ytitle") {
+            spec.y_title_ = value;
+        } else {
+            fprintf(stderr, "ERROR: unknown key '%s'.\n", key.c_str());
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "ERROR: invalid value '%s' of '%s'.\n", value.c_str(), key.c_str());
+            return false;
+        }
+    }
+    if (spec.data_path_.empty() || spec.out_path_.empty()) {
+        fprintf(stderr, "ERROR: 'data' and 'out' are required.\n");
+        return false;
+    }
+    o_spec = spec;
+    return true;
+}
+
+bool BatchRenderer::LoadSpecs(const char* const p_path)
+{
+    std::ifstream file(p_path);
+    if (!file) {
+        fprintf(stderr, "ERROR: failed to open %s.\n", p_path);
+        return false;
+    }
+    const std::string path(p_path);
+    const size_t slash = path.find_last_of("/\\");
+    const std::string dir = (slash == std::string::npos) ? std::string() : path.substr(0, slash);
+    std::vector<PlotSpec> specs;
+    std::string line;
+    unsigned int i_line = 0u;
+    while (std::getline(file, line)) {
+        i_line++;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        PlotSpec spec;
+        if (!BatchRenderer::ParseSpec(line, spec)) {
+            fprintf(stderr, "ERROR: in %s, line %u.\n", p_path, i_line);
+            return false;
+        }
+        ResolvePath(dir, spec.data_path_);
+        ResolvePath(dir, spec.out_path_);
+        specs.push_back(spec);
+    }
+    specs_.insert(specs_.end(), specs.begin(), specs.end());
+    return true;
+}
+
+BatchStats BatchRenderer::Run(void) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(n_threads_);
+    std::atomic<unsigned int> n_failed{0u};
+    pool.ParallelFor(static_cast<unsigned int>(specs_.size()), [&](const unsigned int i) {
+        if (!BatchRenderer::RenderPlot(specs_[i])) {
+            fprintf(stderr, "ERROR: failed to render %s.\n", specs_[i].out_path_.c_str());
+            n_failed++;
+        }
+    });
+    BatchStats stats;
+    stats.n_plots_ = static_cast<unsigned int>(specs_.size());
+    stats.n_failed_ = n_failed;
+    stats.n_threads_ = pool.GetNthreads();
+    stats.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+bool BatchRenderer::RenderPlot(const PlotSpec& p_spec)
+{
+    // Everything is local to the plot, so that the plots can be rendered concurrently
+    GraphManager<double> graph_manager;
+    Graph<double>& gr = graph_manager.CreateGraph();
+    GraphFile<double> binary_file;
+    GraphTextFile<double> text_file;
+    if (IsGraphFile(p_spec.data_path_.c_str())) {
+        if (!binary_file.Open(p_spec.data_path_.c_str())) return false;
+        binary_file.AttachTo(gr);
+    } else {
+        if (!text_file.Load(p_spec.data_path_.c_str(), p_spec.x_column_, p_spec.y_column_)) return false;
+        text_file.AttachTo(gr);
+    }
+    gr.SetColor(p_spec.color_);
+    gr.SetLineWidth(p_spec.line_width_);
+    gr.SetMarkerSize(p_spec.marker_size_);
+    gr.SetDensityMode(p_spec.density_);
+
+    SoftwareCanvas<double> canv(p_spec.width_, p_spec.height_);
+    if (p_spec.bright_) {
+        canv.SetBrightColorScheme();
+    }
+    // There are no cursor readouts on the left, only the axis values
+    canv.SetAllMargins(90u, 22u, 34u, 22u);
+    canv.SetXaxisTitle(p_spec.x_title_.c_str());
+    canv.SetYaxisTitle(p_spec.y_title_.c_str(), true);
+    canv.AddGraph(gr);
+    if (p_spec.has_x_range_ || p_spec.has_y_range_) {
+        const XYrange<double>& range = gr.GetXYrange();
+        canv.SetVisibleRange(
+            p_spec.has_x_range_ ? p_spec.x_min_ : range.lowx(),
+            p_spec.has_x_range_ ? p_spec.x_max_ : range.highx(),
+            p_spec.has_y_range_ ? p_spec.y_min_ : range.lowy(),
+            p_spec.has_y_range_ ? p_spec.y_max_ : range.highy());
+    }
+    canv.Draw();
+    return canv.GetImage().WritePNG(p_spec.out_path_.c_str());
+}
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,339 @@
+// Benchmarks of the stages of the library, from the data to headless frames:
+//     tiny_graph_plot_bench [-o results.json] [--min-points N] [--max-points N]
+//                           [--repeat R] [--filter name] [--no-gl]
+// The data sizes go from --min-points to --max-points by factors of 10,
+// 1e3 to 1e7 by default and up to 1e9, which needs about 12 GB of memory.
+// Each benchmark is run once to warm up, then R times (once from 1e8 points
+// on). The median and the minimum time and the throughput of each benchmark
+// and size are printed and written as JSON, so that the runs of different
+// releases can be compared. The headless frames are rendered by offscreen
+// canvases (see CanvasManager::CreateOffscreenCanvas()), --no-gl skips them.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GL/glew.h"
+#include "tiny_graph_plot.h"
+#include "grid.h"
+#include "thread_pool.h"
+#include "tiny_gl_text_renderer/texture_filler.h"
+
+using tiny_graph_plot::Vec2;
+using tiny_gl_text_renderer::Vec2f;
+using tiny_gl_text_renderer::Vec2d;
+
+struct BenchOptions {
+    std::string out_path_ = "tiny_graph_plot_bench.json";
+    unsigned long long min_points_ = 1000u;
+    unsigned long long max_points_ = 10000000u;
+    unsigned int repeat_ = 5u;
+    std::string filter_; //!< Only the benchmarks whose name contains it
+    bool gl_ = true;
+};
+
+struct BenchResult {
+    std::string name_;
+    unsigned long long n_ = 0u;       //!< Points of the data, 0 for the benchmarks without data
+    unsigned long long n_items_ = 0u; //!< Work items of one run: points, queries, strings, ...
+    unsigned int repeat_ = 0u;
+    double median_ms_ = 0.0;
+    double min_ms_ = 0.0;
+};
+
+/**
+    The same graph, histogram and canvas are used for all data sizes, so that
+    the managers, which own them, do not pile up the objects and their GPU
+    buffers. The canvas is created on the first headless frame.
+*/
+struct BenchObjects {
+    tiny_graph_plot::Graph<float>* graph_ = nullptr;
+    tiny_graph_plot::Histogram1d<float, unsigned long>* histo_ = nullptr;
+    tiny_graph_plot::Canvas<float>* canvas_ = nullptr;
+};
+
+//! Keeps the results of the benchmarks from being optimized away
+static volatile double g_sink = 0.0;
+
+static constexpr unsigned long long large_n = 100000000u; //!< Run once and without warm-up from here on
+
+static bool WriteJSON(const BenchOptions& p_options, const std::vector<BenchResult>& p_results)
+{
+    FILE* const file = fopen(p_options.out_path_.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "ERROR: failed to open %s.\n", p_options.out_path_.c_str());
+        return false;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"format\": 1,\n");
+    fprintf(file, "  \"time\": %lld,\n", (long long)time(nullptr));
+#if defined(_MSC_VER)
+    fprintf(file, "  \"compiler\": \"MSVC %d\",\n", _MSC_VER);
+#elif defined(__VERSION__)
+    fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+#if defined(NDEBUG)
+    fprintf(file, "  \"ndebug\": true,\n");
+#else
+    fprintf(file, "  \"ndebug\": false,\n");
+#endif
+#if defined(__AVX2__)
+    fprintf(file, "  \"avx2\": true,\n");
+#else
+    fprintf(file, "  \"avx2\": false,\n");
+#endif
+    fprintf(file, "  \"threads\": %u,\n", tiny_graph_plot::ThreadPool::GetGlobal().GetNthreads());
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0u; i < p_results.size(); i++) {
+        const BenchResult& r = p_results[i];
+        const double items_per_s = (r.median_ms_ > 0.0) ? (double)r.n_items_ * 1.0e3 / r.median_ms_ : 0.0;
+        fprintf(file, "    { \"name\": \"%s\", \"n\": %llu, \"items\": %llu, \"repeat\": %u, "
+                      "\"median_ms\": %.6f, \"min_ms\": %.6f, \"items_per_s\": %.6g }%s\n",
+            r.name_.c_str(), r.n_, r.n_items_, r.repeat_, r.median_ms_, r.min_ms_, items_per_s,
+            (i + 1u < p_results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    const bool ok = (ferror(file) == 0);
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "ERROR: failed to write %s.\n", p_options.out_path_.c_str());
+    }
+    return ok;
+}
+
+/**
+    Time 'p_body' and add the result. The file is rewritten after each
+    result, so that it is complete even if a later benchmark aborts,
+    e.g. when no offscreen context can be created.
+*/
+static void Run(const BenchOptions& p_options, std::vector<BenchResult>& io_results,
+    const char* const p_name, const unsigned long long p_n, const unsigned long long p_n_items,
+    const std::function<void()>& p_body, const bool p_warm_up = true)
+{
+    if (!p_options.filter_.empty() && strstr(p_name, p_options.filter_.c_str()) == nullptr) return;
+    const bool large = (p_n >= large_n);
+    if (p_warm_up && !large) {
+        p_body();
+    }
+    const unsigned int repeat = (large || !p_warm_up) ? 1u : p_options.repeat_;
+    std::vector<double> times_ms(repeat);
+    for (unsigned int i = 0u; i < repeat; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        p_body();
+        times_ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(times_ms.begin(), times_ms.end());
+    BenchResult result;
+    result.name_ = p_name;
+    result.n_ = p_n;
+    result.n_items_ = p_n_items;
+    result.repeat_ = repeat;
+    result.median_ms_ = times_ms[repeat / 2u];
+    result.min_ms_ = times_ms[0];
+    io_results.push_back(result);
+    const double items_per_s = (result.median_ms_ > 0.0) ? (double)p_n_items * 1.0e3 / result.median_ms_ : 0.0;
+    printf("%-26s %12llu %12.3f ms %12.3f ms %14.4g items/s\n",
+        p_name, p_n, result.median_ms_, result.min_ms_, items_per_s);
+    fflush(stdout);
+    WriteJSON(p_options, io_results);
+}
+
+//! Sorted along x, as acquired data usually is
+static void MakeData(const unsigned long long p_n, std::vector<Vec2<float>>& o_points, std::vector<float>& o_ys)
+{
+    o_points.resize((size_t)p_n);
+    o_ys.resize((size_t)p_n);
+    std::mt19937 rng(12345u);
+    std::normal_distribution<float> noise(0.0f, 0.1f);
+    const double dx = 1000.0 / (double)p_n;
+    for (size_t i = 0u; i < (size_t)p_n; i++) {
+        const double x = (double)i * dx;
+        const float y = (float)std::sin(x * 0.05) + noise(rng);
+        o_points[i] = Vec2<float>((float)x, y);
+        o_ys[i] = y;
+    }
+}
+
+static void RunDataBenchmarks(const BenchOptions& p_options, std::vector<BenchResult>& io_results,
+    const unsigned long long p_n, BenchObjects& io_objects)
+{
+    std::vector<Vec2<float>> points;
+    std::vector<float> ys;
+    MakeData(p_n, points, ys);
+    const unsigned int n = (unsigned int)p_n;
+
+    // Ranges, sortedness, search index and level-of-detail pyramid
+    tiny_graph_plot::Graph<float>& gr = *io_objects.graph_;
+    Run(p_options, io_results, "graph_set_shared_buffer", p_n, p_n, [&]() {
+        gr.SetSharedBuffer(n, points.data());
+    });
+
+    constexpr unsigned int max_queries = 1000000u;
+    const unsigned int n_queries = std::min(n, max_queries);
+    std::vector<float> xs(n_queries);
+    std::vector<float> results(n_queries);
+    {
+        std::mt19937 rng(54321u);
+        std::uniform_real_distribution<float> dist(points.front().x(), points.back().x());
+        for (float& x : xs) x = dist(rng);
+    }
+    Run(p_options, io_results, "graph_evaluate", p_n, n_queries, [&]() {
+        double sum = 0.0;
+        for (const float x : xs) sum += gr.Evaluate(x);
+        g_sink = sum;
+    });
+    Run(p_options, io_results, "graph_evaluate_many", p_n, n_queries, [&]() {
+        gr.EvaluateMany(xs.data(), results.data(), xs.size());
+        g_sink = results[n_queries / 2u];
+    });
+
+    tiny_graph_plot::Histogram1d<float, unsigned long>& histo = *io_objects.histo_;
+    Run(p_options, io_results, "histogram1d_fill", p_n, p_n, [&]() {
+        histo.Init(1000u, -2.0f, 2.0f);
+        for (const float y : ys) histo.Fill(y);
+        g_sink = (double)histo.GetBinValue(500u);
+    });
+    Run(p_options, io_results, "histogram1d_fill_n", p_n, p_n, [&]() {
+        histo.Init(1000u, -2.0f, 2.0f);
+        histo.FillN(ys.data(), ys.size());
+        g_sink = (double)histo.GetBinValue(500u);
+    });
+
+    // As in Canvas::SendVerticesToGPU(), in blocks to bound the memory of the largest sizes
+    constexpr unsigned int block_size = 1u << 24; // A multiple of the chunk size
+    const unsigned int chunk_size = tiny_graph_plot::Graph<float>::GetVertexChunkSize();
+    std::vector<Vec2f> vertices(std::min(n, block_size));
+    std::vector<Vec2d> origins((vertices.size() + chunk_size - 1u) / chunk_size);
+    Run(p_options, io_results, "pack_vertices", p_n, p_n, [&]() {
+        for (unsigned int first = 0u; first < n; first += block_size) {
+            tiny_graph_plot::Canvas<float>::PackVertices(points.data() + first,
+                std::min(block_size, n - first), vertices.data(), origins.data());
+        }
+        g_sink = vertices[0].x();
+    });
+
+    if (p_options.gl_) {
+        // Headless end-to-end, the GPU is waited for
+        if (io_objects.canvas_ == nullptr) {
+            io_objects.canvas_ = &global_canvas_manager_float.CreateOffscreenCanvas(1280u, 720u);
+            io_objects.canvas_->AddGraph(gr);
+        }
+        tiny_graph_plot::Canvas<float>& canv = *io_objects.canvas_;
+        Run(p_options, io_results, "offscreen_show", p_n, p_n, [&]() {
+            canv.Show();
+            glFinish();
+        }, false);
+        Run(p_options, io_results, "offscreen_frame", p_n, 1u, [&]() {
+            canv.Draw();
+            glFinish();
+        });
+    }
+
+    // The points are freed on return, the empty range needs no scan
+    gr.SetSharedBuffer(0u, nullptr, tiny_graph_plot::XYrange<float>(), true);
+}
+
+static void RunFixedBenchmarks(const BenchOptions& p_options, std::vector<BenchResult>& io_results)
+{
+    // Grid of each step of a zoom over six orders of magnitude
+    constexpr unsigned int n_grids = 1000u;
+    tiny_graph_plot::Grid<double> grid;
+    const tiny_graph_plot::XYrange<double> total_range(-1.0e6, 2.0e6, -1.0e6, 2.0e6);
+    Run(p_options, io_results, "grid_build", 0u, n_grids, [&]() {
+        for (unsigned int i = 0u; i < n_grids; i++) {
+            const double d = std::pow(10.0, 6.0 * (double)i / (double)n_grids);
+            const tiny_graph_plot::XYrange<double> visrange(0.1 * d, d, -0.3 * d, 0.7 * d);
+            grid.CalculateStep(visrange, 1280.0, 720.0);
+            grid.Invalidate();
+            grid.BuildGrid(visrange, total_range);
+        }
+        unsigned int n_vertices;
+        grid.GetVerticesData(n_vertices);
+        g_sink = (double)n_vertices;
+    });
+
+    // Labels of 32 characters into an RGBA float texture
+    constexpr unsigned int n_strings = 10000u;
+    constexpr size_t n_chars = 32u;
+    const size_t tex_w = n_chars * tiny_gl_text_renderer::CHAR_WIDTH;
+    const size_t tex_h = tiny_gl_text_renderer::CHAR_HEIGHT;
+    std::vector<float> texture(tex_w * tex_h * 4u);
+    const float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Run(p_options, io_results, "fill_string", 0u, n_strings, [&]() {
+        char line[n_chars + 1u];
+        for (unsigned int i = 0u; i < n_strings; i++) {
+            snprintf(line, sizeof(line), "y%u=% 0.6e % 0.6e", i % 10u, (double)i * 0.37, -(double)i);
+            std::fill(texture.begin(), texture.end(), 0.0f);
+            tiny_gl_text_renderer::FillString(line, texture.data(), 4u, tex_w, tex_h, 0u, 0u, color, 4u);
+        }
+        g_sink = texture[tex_w * 4u * 8u + 4u * 8u];
+    });
+}
+
+static void PrintUsage(const char* const p_name)
+{
+    fprintf(stderr, "Usage: %s [-o results.json] [--min-points N] [--max-points N] [--repeat R] [--filter name] [--no-gl]\n"
+                    "    -o            JSON output, tiny_graph_plot_bench.json by default\n"
+                    "    --min-points  smallest data size, 1e3 by default\n"
+                    "    --max-points  largest data size, 1e7 by default, at most 1e9\n"
+                    "    --repeat      timed runs of each benchmark, 5 by default\n"
+                    "    --filter      only the benchmarks whose name contains this string\n"
+                    "    --no-gl       skip the offscreen rendering\n",
+                    p_name);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "-o") == 0 && has_value) {
+            options.out_path_ = argv[++i];
+        } else if (strcmp(argv[i], "--min-points") == 0 && has_value) {
+            options.min_points_ = (unsigned long long)strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--max-points") == 0 && has_value) {
+            options.max_points_ = (unsigned long long)strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--repeat") == 0 && has_value) {
+            options.repeat_ = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            options.filter_ = argv[++i];
+        } else if (strcmp(argv[i], "--no-gl") == 0) {
+            options.gl_ = false;
+        } else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    // The graphs index their points with unsigned int
+    constexpr unsigned long long max_points = 1000000000u;
+    if (options.min_points_ == 0u || options.min_points_ > options.max_points_ ||
+        options.max_points_ > max_points || options.repeat_ == 0u) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%-26s %12s %15s %15s %22s\n", "benchmark", "points", "median", "min", "throughput");
+    std::vector<BenchResult> results;
+    RunFixedBenchmarks(options, results);
+    BenchObjects objects;
+    objects.graph_ = &global_graph_manager_float.CreateGraph();
+    objects.histo_ = &global_graph_manager_float.CreateHistogram1d();
+    for (unsigned long long n = options.min_points_; n <= options.max_points_; n *= 10u) {
+        try {
+            RunDataBenchmarks(options, results, n, objects);
+        } catch (const std::bad_alloc&) {
+            fprintf(stderr, "ERROR: not enough memory for %llu points.\n", n);
+            break;
+        }
+    }
+    return WriteJSON(options, results) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
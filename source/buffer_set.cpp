@@ -50,19 +50,22 @@ void BufferSet<tiny_gl_text_renderer::vertex_colored_t>::Allocate(
 }
 
 template<>
-void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::Allocate(
+void BufferSet<tiny_gl_text_renderer::vertex_glyph_t>::Allocate(
     const unsigned int n_vert, const void* const data) const
 {
-    using v_str_t = tiny_gl_text_renderer::vertex_textured_t;
+    using v_str_t = tiny_gl_text_renderer::vertex_glyph_t;
     glBindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, n_vert * sizeof(v_str_t), data, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, n_vert * sizeof(v_str_t), data, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(v_str_t),
         (void*)offsetof(v_str_t, coords_));
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(v_str_t),
         (void*)offsetof(v_str_t, tex_coords_));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(v_str_t),
+        (void*)offsetof(v_str_t, color_));
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
     //glBindVertexArray(0); // Not really needed.
 }
 
@@ -117,7 +120,7 @@ void BufferSet<tiny_gl_text_renderer::vertex_colored_t>::SendIndices(
 
 template<>
 template<>
-void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::SendIndices(
+void BufferSet<tiny_gl_text_renderer::vertex_glyph_t>::SendIndices(
     const unsigned int n_primitives, const tiny_gl_text_renderer::quad_t* const data) const
 {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
@@ -126,7 +129,7 @@ void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::SendIndices(
 
 template<>
 template<>
-void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::SendIndices(
+void BufferSet<tiny_gl_text_renderer::vertex_glyph_t>::SendIndices(
     const unsigned int n_primitives, const tiny_gl_text_renderer::wire_t* const data) const
 {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
@@ -135,7 +138,7 @@ void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::SendIndices(
 
 template<>
 template<>
-void BufferSet<tiny_gl_text_renderer::vertex_textured_t>::SendIndices(
+void BufferSet<tiny_gl_text_renderer::vertex_glyph_t>::SendIndices(
     const unsigned int n_primitives, const tiny_gl_text_renderer::marker_t* const data) const
 {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
@@ -171,23 +174,7 @@ void BufferSet<VERTEX_TYPE>::DrawMarkers(const unsigned int n_primitives) const
     DrawPrimitives<1u, GL_POINTS>(n_primitives, vao_, ibo_);
 }
 
-template<typename VERTEX_TYPE>
-void BufferSet<VERTEX_TYPE>::DrawQuadsWithTextures(const size_t n_labels,
-    std::function<GLuint(const size_t)> get_label_tex_id) const
-{
-    constexpr unsigned int n_primitives = 1u;
-    constexpr unsigned int n_indices = 4u;
-    glBindVertexArray(vao_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
-    for (size_t i_label = 0u; i_label < n_labels; i_label++) {
-        glBindTexture(GL_TEXTURE_2D, get_label_tex_id(i_label));
-        glDrawElements(GL_QUADS, n_indices * n_primitives, GL_UNSIGNED_INT,
-                        (GLvoid*)(i_label * sizeof(tiny_gl_text_renderer::quad_t)));
-    }
-    //glBindVertexArray(0); // Not really needed.
-}
-
 template class BufferSet<tiny_gl_text_renderer::vertex_colored_t>;
-template class BufferSet<tiny_gl_text_renderer::vertex_textured_t>;
+template class BufferSet<tiny_gl_text_renderer::vertex_glyph_t>;
 
 } // end of namespace tiny_graph_plot
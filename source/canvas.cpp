@@ -7,11 +7,12 @@
 
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
-#include "stb_image_write.h"
 
 #include "canvas_shader_sources.h"
+#include "colormap.h"
 #include "graph.h"
 #include "histogram1d.h"
+#include "histogram2d.h"
 
 namespace tiny_graph_plot
 {
@@ -29,8 +30,9 @@ using tiny_gl_text_renderer::quad_t;
 #define MINFRAMEHEIGHT 50
 
 template<typename T>
-Canvas<T>::Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h)
-:   UserWindow(window, w, h),
+Canvas<T>::Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h,
+    const OffscreenContext* offscreen_context)
+:   UserWindow(window, w, h, offscreen_context),
     buf_set_axes_("axes"),
     buf_set_vref_("vref"),
     buf_set_cursor_("cursor"),
@@ -39,7 +41,14 @@ Canvas<T>::Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h
     prog_onscr_q_("prog_onscr_quads"),
     prog_w_("prog_wires"),
     prog_onscr_w_("prog_onscr_wires"),
-    prog_m_("prog_markers"),
+    prog_gr_w_("prog_graph_wires"),
+    prog_gr_m_("prog_graph_markers"),
+    prog_h_("prog_histograms"),
+    prog_h2_("prog_histograms2d"),
+    prog_d_reduce_("prog_density_reduce"),
+    prog_d_resolve_("prog_density_resolve"),
+    prog_static_("prog_static_layer"),
+    prog_pg_("prog_procedural_grid"),
     prog_c_("prog_circles")
 {
 #ifdef SET_CONTEXT
@@ -47,6 +56,9 @@ Canvas<T>::Canvas(GLFWwindow* window, const unsigned int w, const unsigned int h
 #endif
     //this->UpdateSizeLimits();
     this->Init();
+    if (_window == nullptr) {
+        this->InitOffscreenTarget();
+    }
 }
 
 template<typename T>
@@ -56,6 +68,10 @@ Canvas<T>::~Canvas(void)
     glfwMakeContextCurrent(_window);
 #endif
 
+    png_exporter_.Finish();
+    png_exporter_.Release();
+    profiler_.Release();
+
     // VAOs, VBOs, IBOs ----------------------------------------------------------
     {
         glDeleteVertexArrays(1, &_vaoID_grid);
@@ -70,8 +86,36 @@ Canvas<T>::~Canvas(void)
 
         glDeleteVertexArrays(1, &_vaoID_graphs);
         glDeleteBuffers(1, &_vboID_graphs);
-        glDeleteBuffers(1, &_iboID_graphs_w);
-        glDeleteBuffers(1, &_iboID_graphs_m);
+        glDeleteBuffers(1, &_tboID_graphs);
+        glDeleteTextures(1, &_texID_graphs);
+        glDeleteBuffers(1, &_iboID_graphs);
+
+        glDeleteVertexArrays(1, &_vaoID_histograms);
+        for (const HistogramBuffers& buffers : histogram_buffers_) {
+            glDeleteBuffers(1, &buffers.tboID_);
+            glDeleteTextures(1, &buffers.texID_);
+        }
+        for (const Histogram2dTexture& texture : histogram2d_textures_) {
+            glDeleteTextures(1, &texture.texID_);
+        }
+        glDeleteTextures(1, &_texID_colormap);
+
+        glDeleteFramebuffers(1, &_fboID_density);
+        glDeleteFramebuffers(1, &_fboID_target);
+        glDeleteRenderbuffers(1, &_rboID_target);
+        glDeleteFramebuffers(1, &_fboID_resolve);
+        glDeleteRenderbuffers(1, &_rboID_resolve);
+        glDeleteFramebuffers(1, &_fboID_static_ms);
+        glDeleteRenderbuffers(1, &_rboID_static_ms);
+        glDeleteFramebuffers(1, &_fboID_static);
+        glDeleteTextures(1, &_texID_static);
+        if (!_texID_density_reduce.empty()) {
+            glDeleteTextures((GLsizei)_texID_density_reduce.size(), _texID_density_reduce.data());
+        }
+        for (const DensityCache& cache : density_caches_) {
+            glDeleteTextures(1, &cache.texID_);
+            glDeleteTextures(1, &cache.maxTexID_);
+        }
 
         glDeleteVertexArrays(1, &_vaoID_sel);
         glDeleteBuffers(1, &_vboID_sel);
@@ -95,6 +139,12 @@ void Canvas<T>::AddHistogram(const Histogram1d<T, unsigned long>& p_histo)
     _histograms.push_back(&p_histo);
 }
 
+template<typename T>
+void Canvas<T>::AddHistogram2d(const Histogram2d<T, unsigned long>& p_histo)
+{
+    _histograms2d.push_back(&p_histo);
+}
+
 template<typename T>
 void Canvas<T>::Show(void)
 {
@@ -102,59 +152,15 @@ void Canvas<T>::Show(void)
     glfwMakeContextCurrent(_window);
 #endif
 
-    glfwShowWindow(_window);
+    if (_window != nullptr) {
+        glfwShowWindow(_window);
+    }
 
     this->SendFrameVerticesToGPU();
 
     glProgramUniform1f(prog_c_.GetProgId(), _circle_r_unif_c, (float)circle_r_);
 
-    SizeInfo total_size; // Zeroed on construction
-    _total_xy_range = _graphs.at(0)->GetXYrange();
-
-    for (const auto* const gr : _graphs) {
-        total_size += gr->GetSizeInfo();
-        _total_xy_range.Include(gr->GetXYrange());
-    }
-    for (const auto* const histo : _histograms) {
-        total_size += histo->GetSizeInfo();
-        _total_xy_range.Include(histo->GetXYrange());
-    }
-
-    // Allocate vertex buffer space for all graphs. ------------------------------
-    {
-        const unsigned int n_vert = total_size._n_v;
-        glBindVertexArray(_vaoID_graphs);
-        glBindBuffer(GL_ARRAY_BUFFER, _vboID_graphs);
-        glBufferData(GL_ARRAY_BUFFER, n_vert * sizeof(vertex_colored_t),
-            NULL, GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(vertex_colored_t),
-            (void*)offsetof(vertex_colored_t, coords_));
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(vertex_colored_t),
-            (void*)offsetof(vertex_colored_t, color_));
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
-        //glBindVertexArray(0); // Not really needed.
-    }
-
-    // Allocate index buffers space for all graphs. ------------------------------
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_m);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, total_size._n_m * sizeof(marker_t),
-            NULL, GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_w);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, total_size._n_w * sizeof(wire_t),
-            NULL, GL_STATIC_DRAW);
-    }
-
-    SizeInfo cur_offset; // Zeroed on construction
-    for (const auto* const gr : _graphs) {
-        this->SendDrawableToGPU(gr, cur_offset);
-        cur_offset += gr->GetSizeInfo();
-    }
-    for (const auto* const histo : _histograms) {
-        this->SendDrawableToGPU(histo, cur_offset);
-        cur_offset += histo->GetSizeInfo();
-    }
+    this->AllocateGraphBuffers();
 
     // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
@@ -305,6 +311,17 @@ void Canvas<T>::Show(void)
         }
     }
 
+    // Frame stats, empty until shown, see SetPerfOverlay()
+    const int perf_x = margin_xl_pix_ + ch_width;
+    const int perf_y = margin_yt_pix_ + line_height / 2;
+    _perf_labels_start_idx = text_rend_.AddLabel("", perf_x, perf_y, gen_text_color_, font_size_);
+    i_label++;
+    for (size_t i = 0u; i < (size_t)frame_pass_t::FP_N; i++) {
+        text_rend_.AddLabel("", perf_x, perf_y + (int)(i + 1u) * line_height, gen_text_color_, font_size_);
+        i_label++;
+    }
+    perf_overlay_valid_ = false;
+
     this->FinalizeTextRenderer();
 
     // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -319,38 +336,215 @@ void Canvas<T>::Draw(void) /*const*/
     glfwMakeContextCurrent(_window);
 #endif
 
+    profiler_.BeginFrame();
+    profiler_.Begin(frame_pass_t::FP_FRAME);
+    profiler_.Begin(frame_pass_t::FP_SYNC);
+    png_exporter_.Poll();
+    if (this->GraphsChanged()) {
+        static_layer_valid_ = false;
+    }
+    this->SyncGraphs();
+    if (!chunk_translations_valid_) {
+        this->SendChunkTranslationsToGPU();
+    }
+    if (!grid_valid_) {
+        this->SendGridToGPU();
+    }
+    profiler_.End(frame_pass_t::FP_SYNC);
+
+    if (_window == nullptr) {
+        // Drawn once per export, there is nothing to reuse
+        this->DrawScene();
+    } else {
+        this->UpdateStaticLayer();
+        this->DrawStaticLayer();
+    }
+
+    this->SwitchToFullWindow();
+    if (!axes_values_valid_) {
+        this->UpdateTexAxesValues();
+    }
+    if (perf_overlay_) {
+        this->UpdateTexPerfOverlay();
+    }
+    //++++++++++++++++
+    profiler_.Begin(frame_pass_t::FP_TEXT);
+    text_rend_.Draw();
+    profiler_.End(frame_pass_t::FP_TEXT);
+    //++++++++++++++++
+
+    // Requested by ExportPNGAsync(), the back buffer is read before it is swapped
+    if (_window != nullptr && !pending_exports_.empty()) {
+        for (const auto& request : pending_exports_) {
+            png_exporter_.Read(0u, _window_w, _window_h, request.first, request.second);
+        }
+        pending_exports_.clear();
+        glBindFramebuffer(GL_FRAMEBUFFER, _fboID_target);
+    }
+    profiler_.End(frame_pass_t::FP_FRAME);
+}
+
+template<typename T>
+void Canvas<T>::DrawScene(void)
+{
     this->SwitchToFrame();
+    profiler_.Begin(frame_pass_t::FP_GRID);
     this->DrawGrid();
+    profiler_.End(frame_pass_t::FP_GRID);
     this->DrawAxes();
     this->DrawVref();
     this->SwitchToFullWindow();
     this->DrawFrame();
     this->SwitchToFrame();
 
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, _texID_graphs);
+    glActiveTexture(GL_TEXTURE0);
+
+    // 2D histograms are the background of the graphs
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw 2D histograms");
+    profiler_.Begin(frame_pass_t::FP_HISTOGRAMS2D);
+    for (size_t i = 0; i < _histograms2d.size(); i++) {
+        if (_histograms2d[i]->GetVisible()) {
+            this->DrawHistogram2d(i);
+        }
+    }
+    profiler_.End(frame_pass_t::FP_HISTOGRAMS2D);
+    glPopDebugGroup();
+
     SizeInfo cur_offset; // Zeroed on construction
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw graphs");
-    for (const auto* const gr : _graphs) {
+    profiler_.Begin(frame_pass_t::FP_GRAPHS);
+    for (size_t i = 0; i < _graphs.size(); i++) {
+        const Graph<T>* const gr = _graphs[i];
         if (gr->GetVisible()) {
-            this->DrawDrawable(gr, cur_offset);
+            if (gr->GetDensityMode()) {
+                this->DrawGraphDensity(i, cur_offset);
+            } else {
+                this->DrawGraph(gr, cur_offset);
+            }
         }
         cur_offset += gr->GetSizeInfo();
     }
+    profiler_.End(frame_pass_t::FP_GRAPHS);
     glPopDebugGroup();
 
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw histograms");
-    for (const auto* const histo : _histograms) {
-        if (histo->GetVisible()) {
-            this->DrawDrawable(histo, cur_offset);
+    profiler_.Begin(frame_pass_t::FP_HISTOGRAMS);
+    for (size_t i = 0; i < _histograms.size(); i++) {
+        if (_histograms[i]->GetVisible()) {
+            this->DrawHistogram(i);
         }
-        cur_offset += histo->GetSizeInfo();
     }
+    profiler_.End(frame_pass_t::FP_HISTOGRAMS);
     glPopDebugGroup();
+}
+
+template<typename T>
+void Canvas<T>::BuildStaticLayerKey(std::vector<double>& o_key) const
+{
+    o_key.clear();
+    const auto add_color = [&o_key](const color_t& c) {
+        o_key.insert(o_key.end(), { c[0], c[1], c[2], c[3] });
+    };
+    o_key.insert(o_key.end(), { (double)_window_w, (double)_window_h,
+        (double)margin_xl_pix_, (double)margin_xr_pix_, (double)margin_yb_pix_, (double)margin_yt_pix_,
+        _visible_range.lowx(), _visible_range.dx(), _visible_range.lowy(), _visible_range.dy(),
+        (double)ref_x_ });
+    o_key.insert(o_key.end(), { (double)enable_hgrid_, (double)enable_vgrid_, (double)enable_axes_,
+        (double)enable_vref_, (double)enable_frame_, (double)procedural_grid_ });
+    add_color(background_color_);
+    add_color(in_frame_bg_color_);
+    add_color(axes_line_color_);
+    add_color(vref_line_color_);
+    add_color(frame_line_color_);
+    add_color(_grid.GetHGridFineColor());
+    add_color(_grid.GetVGridFineColor());
+    add_color(_grid.GetHGridCoarseColor());
+    add_color(_grid.GetVGridCoarseColor());
+    o_key.insert(o_key.end(), { axes_line_width_, vref_line_width_, frame_line_width_,
+        _grid.GetHGridFineLineWidth(), _grid.GetVGridFineLineWidth(),
+        _grid.GetHGridCoarseLineWidth(), _grid.GetVGridCoarseLineWidth() });
+    // The drawables can be changed through their own setters at any time
+    const auto add_drawable = [&](const Drawable<T>* const p_dr) {
+        o_key.insert(o_key.end(), { (double)p_dr->GetVisible(), p_dr->GetLineWidth(), p_dr->GetMarkerSize() });
+        add_color(p_dr->GetColor());
+    };
+    for (const Graph<T>* const gr : _graphs) {
+        add_drawable(gr);
+        o_key.push_back((double)gr->GetDensityMode());
+    }
+    for (const auto* const histo : _histograms) add_drawable(histo);
+    for (const auto* const histo : _histograms2d) add_drawable(histo);
+}
 
+template<typename T>
+void Canvas<T>::UpdateStaticLayer(void)
+{
+    this->BuildStaticLayerKey(static_layer_key_next_);
+    if (static_layer_valid_ && static_layer_key_next_ == static_layer_key_) return;
+    static_layer_key_.swap(static_layer_key_next_);
+
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Update static layer");
+    profiler_.Begin(frame_pass_t::FP_STATIC_LAYER);
+    if (static_layer_w_ != _window_w || static_layer_h_ != _window_h) {
+        // Multisampled as the window, resolved into a texture which is copied to the window
+        if (_fboID_static_ms == 0u) {
+            glGenFramebuffers(1, &_fboID_static_ms);
+            glGenRenderbuffers(1, &_rboID_static_ms);
+            glGenFramebuffers(1, &_fboID_static);
+            glGenTextures(1, &_texID_static);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, _rboID_static_ms);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGBA8, _window_w, _window_h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fboID_static_ms);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _rboID_static_ms);
+        glObjectLabel(GL_FRAMEBUFFER, _fboID_static_ms, -1, "static_layer_ms_fbo");
+        glBindTexture(GL_TEXTURE_2D, _texID_static);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _window_w, _window_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fboID_static);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texID_static, 0);
+        glObjectLabel(GL_FRAMEBUFFER, _fboID_static, -1, "static_layer_fbo");
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "ERROR: static layer framebuffer is incomplete.\n");
+        }
+        static_layer_w_ = _window_w;
+        static_layer_h_ = _window_h;
+    }
+
+    _fboID_scene = _fboID_static_ms;
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_scene);
+    glClear(GL_COLOR_BUFFER_BIT);
+    this->FillInFrame();
+    this->DrawScene();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fboID_static_ms);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fboID_static);
+    glBlitFramebuffer(0, 0, _window_w, _window_h, 0, 0, _window_w, _window_h,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    _fboID_scene = _fboID_target;
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_target);
+    static_layer_valid_ = true;
+    profiler_.End(frame_pass_t::FP_STATIC_LAYER);
+    glPopDebugGroup();
+}
+
+template<typename T>
+void Canvas<T>::DrawStaticLayer(void) const
+{
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw static layer");
     this->SwitchToFullWindow();
-    this->UpdateTexAxesValues();
-    //++++++++++++++++
-    text_rend_.Draw();
-    //++++++++++++++++
+    glDisable(GL_BLEND);
+    prog_static_.Use();
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_2D, _texID_static);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(_vaoID_histograms);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glEnable(GL_BLEND);
+    glPopDebugGroup();
 }
 
 template<typename T>
@@ -396,14 +590,42 @@ void Canvas<T>::Init(void)
         {
         glGenVertexArrays(1, &_vaoID_graphs);
         glGenBuffers(1, &_vboID_graphs);
-        glGenBuffers(1, &_iboID_graphs_w);
-        glGenBuffers(1, &_iboID_graphs_m);
+        glGenBuffers(1, &_tboID_graphs);
+        glGenTextures(1, &_texID_graphs);
+        glGenBuffers(1, &_iboID_graphs);
 
         const std::string name("graphs");
         glObjectLabel(GL_VERTEX_ARRAY, _vaoID_graphs, -1, (name + std::string("_vao")).c_str());
         glObjectLabel(GL_BUFFER, _vboID_graphs, -1, (name + std::string("_vbo")).c_str());
-        glObjectLabel(GL_BUFFER, _iboID_graphs_w, -1, (name + std::string("_w_ibo")).c_str());
-        glObjectLabel(GL_BUFFER, _iboID_graphs_m, -1, (name + std::string("_m_ibo")).c_str());
+        glObjectLabel(GL_BUFFER, _tboID_graphs, -1, (name + std::string("_tbo")).c_str());
+        glObjectLabel(GL_BUFFER, _iboID_graphs, -1, (name + std::string("_ibo")).c_str());
+        }
+
+        {
+        glGenVertexArrays(1, &_vaoID_histograms);
+
+        const std::string name("histograms");
+        glObjectLabel(GL_VERTEX_ARRAY, _vaoID_histograms, -1, (name + std::string("_vao")).c_str());
+        }
+
+        {
+        constexpr unsigned int n_colors = 256u;
+        const std::vector<unsigned char> colors = BuildViridisColormap(n_colors);
+        glGenTextures(1, &_texID_colormap);
+        glBindTexture(GL_TEXTURE_1D, _texID_colormap);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, (GLsizei)n_colors, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glObjectLabel(GL_TEXTURE, _texID_colormap, -1, "colormap_tex");
+        }
+
+        {
+        glGenFramebuffers(1, &_fboID_density);
+
+        const std::string name("density");
+        glObjectLabel(GL_FRAMEBUFFER, _fboID_density, -1, (name + std::string("_fbo")).c_str());
         }
 
         buf_set_cursor_.Generate();
@@ -437,8 +659,63 @@ void Canvas<T>::Init(void)
     prog_w_.Generate(canvas_w_vp_source, nullptr, canvas_w_fp_source);
     // Wires / screen space
     prog_onscr_w_.Generate(canvas_onscr_w_vp_source, nullptr, canvas_onscr_w_fp_source);
-    // Markers / visible range space
-    prog_m_.Generate(canvas_m_vp_source, nullptr, canvas_m_fp_source);
+    // Graph wires and markers / visible range space
+    prog_gr_w_.Generate(canvas_gr_w_vp_source, nullptr, canvas_gr_w_fp_source);
+    _color_unif_gr_w = glGetUniformLocation(prog_gr_w_.GetProgId(), "drawcolor");
+    _scale_unif_gr_w = glGetUniformLocation(prog_gr_w_.GetProgId(), "visrange_scale");
+    prog_gr_m_.Generate(canvas_gr_m_vp_source, nullptr, canvas_gr_m_fp_source);
+    _color_unif_gr_m = glGetUniformLocation(prog_gr_m_.GetProgId(), "drawcolor");
+    _marker_size_unif_gr_m = glGetUniformLocation(prog_gr_m_.GetProgId(), "marker_size");
+    _scale_unif_gr_m = glGetUniformLocation(prog_gr_m_.GetProgId(), "visrange_scale");
+    // The chunk translations are bound to the texture unit 1
+    for (const ShaderProgram* const prog : { &prog_gr_w_, &prog_gr_m_ }) {
+        glProgramUniform1i(prog->GetProgId(),
+            glGetUniformLocation(prog->GetProgId(), "chunk_translation"), 1);
+        glProgramUniform1i(prog->GetProgId(),
+            glGetUniformLocation(prog->GetProgId(), "chunk_size"),
+            (GLint)Graph<T>::GetVertexChunkSize());
+    }
+    // Histograms / visible range space, the bin values are bound to the texture unit 2
+    prog_h_.Generate(canvas_h_vp_source, nullptr, canvas_h_fp_source);
+    _color_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "drawcolor");
+    _marker_size_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "marker_size");
+    _vertices_per_bin_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "vertices_per_bin");
+    _bin_ref_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "bin_ref");
+    _bin_transform_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "bin_transform");
+    _y_transform_unif_h = glGetUniformLocation(prog_h_.GetProgId(), "y_transform");
+    glProgramUniform1i(prog_h_.GetProgId(),
+        glGetUniformLocation(prog_h_.GetProgId(), "bin_values"), 2);
+    // 2D histograms / visible range space, the bins and the colormap are bound to the texture units 3 and 4
+    prog_h2_.Generate(canvas_h2_vp_source, nullptr, canvas_h2_fp_source);
+    _rect_unif_h2 = glGetUniformLocation(prog_h2_.GetProgId(), "rect");
+    _uv_rect_unif_h2 = glGetUniformLocation(prog_h2_.GetProgId(), "uv_rect");
+    _value_scale_unif_h2 = glGetUniformLocation(prog_h2_.GetProgId(), "value_scale");
+    glProgramUniform1i(prog_h2_.GetProgId(),
+        glGetUniformLocation(prog_h2_.GetProgId(), "bin_values"), 3);
+    glProgramUniform1i(prog_h2_.GetProgId(),
+        glGetUniformLocation(prog_h2_.GetProgId(), "colormap"), 4);
+    // Density maps / whole viewport, the counts and their maximum are bound to the texture units 5 and 6
+    prog_d_reduce_.Generate(canvas_d_vp_source, nullptr, canvas_d_reduce_fp_source);
+    glProgramUniform1i(prog_d_reduce_.GetProgId(),
+        glGetUniformLocation(prog_d_reduce_.GetProgId(), "src"), 5);
+    prog_d_resolve_.Generate(canvas_d_vp_source, nullptr, canvas_d_resolve_fp_source);
+    glProgramUniform1i(prog_d_resolve_.GetProgId(),
+        glGetUniformLocation(prog_d_resolve_.GetProgId(), "density"), 5);
+    glProgramUniform1i(prog_d_resolve_.GetProgId(),
+        glGetUniformLocation(prog_d_resolve_.GetProgId(), "density_max"), 6);
+    glProgramUniform1i(prog_d_resolve_.GetProgId(),
+        glGetUniformLocation(prog_d_resolve_.GetProgId(), "colormap"), 4);
+    // Static layer / whole window, its texture is bound to the texture unit 7
+    prog_static_.Generate(canvas_d_vp_source, nullptr, canvas_static_fp_source);
+    glProgramUniform1i(prog_static_.GetProgId(),
+        glGetUniformLocation(prog_static_.GetProgId(), "layer"), 7);
+    // Procedural grid / frame
+    prog_pg_.Generate(canvas_d_vp_source, nullptr, canvas_pg_fp_source);
+    _lines_unif_pg = glGetUniformLocation(prog_pg_.GetProgId(), "lines");
+    _colors_unif_pg = glGetUniformLocation(prog_pg_.GetProgId(), "colors");
+    _widths_unif_pg = glGetUniformLocation(prog_pg_.GetProgId(), "widths");
+    _extent_unif_pg = glGetUniformLocation(prog_pg_.GetProgId(), "extent");
+    _stipple_unif_pg = glGetUniformLocation(prog_pg_.GetProgId(), "stipple_origin");
     // Circles / visible range space
     prog_c_.Generate(canvas_c_vp_source, canvas_c_gp_source, canvas_c_fp_source);
     _circle_r_unif_c = glGetUniformLocation(prog_c_.GetProgId(), "circle_r");
@@ -465,6 +742,31 @@ void Canvas<T>::Init(void)
         in_frame_bg_color_.GetData());
     // In principle, can be omitted
     //glProgramUniform1f(_progID_c, _circle_r_unif_c, (float)circle_r_);
+
+    profiler_.Init();
+}
+
+template<typename T>
+void Canvas<T>::InitOffscreenTarget(void)
+{
+    // Same number of samples as the windows, see CanvasManager::CreateCanvas()
+    const auto make_target = [this](GLuint& o_fboID, GLuint& o_rboID, const GLsizei p_samples,
+        const char* const p_name) {
+        glGenFramebuffers(1, &o_fboID);
+        glGenRenderbuffers(1, &o_rboID);
+        glBindRenderbuffer(GL_RENDERBUFFER, o_rboID);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, p_samples, GL_RGBA8, _window_w, _window_h);
+        glBindFramebuffer(GL_FRAMEBUFFER, o_fboID);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, o_rboID);
+        glObjectLabel(GL_FRAMEBUFFER, o_fboID, -1, p_name);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "ERROR: offscreen framebuffer '%s' is incomplete.\n", p_name);
+        }
+    };
+    make_target(_fboID_resolve, _rboID_resolve, 0, "offscreen_resolve_fbo");
+    make_target(_fboID_target, _rboID_target, 4, "offscreen_target_fbo");
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    _fboID_scene = _fboID_target;
 }
 
 template<typename T>
@@ -473,8 +775,12 @@ void Canvas<T>::Clear(void) const
 #ifdef SET_CONTEXT
     glfwMakeContextCurrent(_window);
 #endif
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_target);
     glClear(GL_COLOR_BUFFER_BIT);
-    this->FillInFrame();
+    // The window is covered by the static layer, which has its own in frame background
+    if (_window == nullptr) {
+        this->FillInFrame();
+    }
 }
 
 template<typename T>
@@ -519,10 +825,10 @@ void Canvas<T>::Reshape(int p_width, int p_height)
 template<typename T>
 void Canvas<T>::PrintCursorValues(const double xs, const double ys) const
 {
-    const Vec4f ps = Vec4f((float)xs, (float)ys, 0.0f, 1.0f);
-    Vec4f pv;
-    Vec4f pc;
-    const Vec4f pr = this->TransformToVisrange(ps, &pc, &pv);
+    const Vec4d ps = Vec4d(xs, ys, 0.0, 1.0);
+    Vec4d pv;
+    Vec4d pc;
+    const Vec4d pr = this->TransformToVisrange(ps, &pc, &pv);
     ps.Print("\t|\t"); pv.Print("\t|\t"); pc.Print("\t|\t"); pr.Print("\n");
 }
 
@@ -668,17 +974,27 @@ int Canvas<T>::SendGridToGPU(void)
     glfwMakeContextCurrent(_window);
 #endif
 
+    grid_valid_ = true;
     const float vw = (float)(_window_w - (margin_xl_pix_ + margin_xr_pix_));
     const float vh = (float)(_window_h - (margin_yb_pix_ + margin_yt_pix_));
+    const T fine_step_x = _grid.GetFineXstep();
+    const T fine_step_y = _grid.GetFineYstep();
     if (_grid.CalculateStep(_visible_range, vw, vh) == 1) {
         // The range is degenerate
         //TODO decide what to do
         return 1;
     }
+    if (procedural_grid_) {
+        // Nothing to build, the lines are computed from the steps when drawn
+        if (_grid.GetFineXstep() == fine_step_x && _grid.GetFineYstep() == fine_step_y) return 1;
+        axes_values_valid_ = false;
+        return 0;
+    }
     if (_grid.BuildGrid(_visible_range, _total_xy_range) == 1) {
         // No changes have to be made
         return 1;
     }
+    axes_values_valid_ = false;
 
     // Send vertices and colors. -------------------------------------------------
     {
@@ -732,6 +1048,10 @@ void Canvas<T>::DrawGrid(void) const
     if (!enable_hgrid_ && !enable_vgrid_) {
         return;
     }
+    if (procedural_grid_) {
+        this->DrawProceduralGrid();
+        return;
+    }
 
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw grid");
 
@@ -782,6 +1102,71 @@ void Canvas<T>::DrawGrid(void) const
     glPopDebugGroup();
 }
 
+template<typename T>
+void Canvas<T>::DrawProceduralGrid(void) const
+{
+    // Visible part of the total range, the grid lines span the total range
+    const double xmin = std::fmax((double)_visible_range.lowx(),  (double)_total_xy_range.lowx());
+    const double xmax = std::fmin((double)_visible_range.highx(), (double)_total_xy_range.highx());
+    const double ymin = std::fmax((double)_visible_range.lowy(),  (double)_total_xy_range.lowy());
+    const double ymax = std::fmin((double)_visible_range.highy(), (double)_total_xy_range.highy());
+    if (!(xmin < xmax) || !(ymin < ymax)) return;
+
+    // Visible range to window pixels. The differences are taken before
+    // scaling, so that nothing large is subtracted at deep zoom.
+    const double sx = (double)(_window_w - (margin_xl_pix_ + margin_xr_pix_)) / (double)_visible_range.dx();
+    const double sy = (double)(_window_h - (margin_yb_pix_ + margin_yt_pix_)) / (double)_visible_range.dy();
+    const auto to_pix_x = [&](const double x) {
+        return (double)margin_xl_pix_ + (x - (double)_visible_range.lowx()) * sx; };
+    const auto to_pix_y = [&](const double y) {
+        return (double)margin_yb_pix_ + (y - (double)_visible_range.lowy()) * sy; };
+
+    GLfloat lines[4 * 3];
+    const auto set_lines = [&lines](const int p_i, const bool p_enabled, const T p_min, const T p_max,
+        const T p_step, const double p_scale, const auto& p_to_pix) {
+        T first = p_min;
+        const unsigned int n = p_enabled ? Grid<T>::CountLines(p_min, p_max, p_step, first) : 0u;
+        lines[p_i * 3 + 0] = (GLfloat)p_to_pix((double)first);
+        lines[p_i * 3 + 1] = (GLfloat)((double)p_step * p_scale);
+        lines[p_i * 3 + 2] = (GLfloat)n;
+    };
+    set_lines(0, enable_vgrid_, (T)xmin, (T)xmax, _grid.GetFineXstep(), sx, to_pix_x);
+    set_lines(1, enable_vgrid_, (T)xmin, (T)xmax, _grid.GetCoarseXstep(), sx, to_pix_x);
+    set_lines(2, enable_hgrid_, (T)ymin, (T)ymax, _grid.GetFineYstep(), sy, to_pix_y);
+    set_lines(3, enable_hgrid_, (T)ymin, (T)ymax, _grid.GetCoarseYstep(), sy, to_pix_y);
+
+    GLfloat colors[4 * 4];
+    const color_t grid_colors[4] = { _grid.GetVGridFineColor(), _grid.GetVGridCoarseColor(),
+        _grid.GetHGridFineColor(), _grid.GetHGridCoarseColor() };
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) colors[i * 4 + j] = grid_colors[i][j];
+    }
+    const GLfloat widths[4] = { _grid.GetVGridFineLineWidth(), _grid.GetVGridCoarseLineWidth(),
+        _grid.GetHGridFineLineWidth(), _grid.GetHGridCoarseLineWidth() };
+
+    // The stipple pattern starts at the first pixel of each line, the lines start at the total range
+    const auto stipple_origin = [](const double p_start) {
+        const double first_pixel = std::ceil(p_start - 0.5);
+        return (GLfloat)(first_pixel - 8.0 * std::floor(first_pixel / 8.0));
+    };
+
+    const GLuint prog = prog_pg_.GetProgId();
+    glProgramUniform3fv(prog, _lines_unif_pg, 4, lines);
+    glProgramUniform4fv(prog, _colors_unif_pg, 4, colors);
+    glProgramUniform1fv(prog, _widths_unif_pg, 4, widths);
+    glProgramUniform4f(prog, _extent_unif_pg,
+        (GLfloat)to_pix_x(xmin), (GLfloat)to_pix_x(xmax), (GLfloat)to_pix_y(ymin), (GLfloat)to_pix_y(ymax));
+    glProgramUniform2f(prog, _stipple_unif_pg,
+        stipple_origin(to_pix_x((double)_total_xy_range.lowx())),
+        stipple_origin(to_pix_y((double)_total_xy_range.lowy())));
+
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw procedural grid");
+    prog_pg_.Use();
+    glBindVertexArray(_vaoID_histograms);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glPopDebugGroup();
+}
+
 // 2. Axes =======================================================================
 
 template<typename T>
@@ -799,16 +1184,21 @@ void Canvas<T>::DrawAxes(void) const
 
     // Send vertices and colors. -------------------------------------------------
     {
+        // Relative to the center of the visible range, see _visrange_to_clip_rtc
+        const double xm = static_cast<double>(_visible_range.xm());
+        const double ym = static_cast<double>(_visible_range.ym());
         constexpr unsigned int n_vert = 4u;
         vertex_colored_t vertices[n_vert];
         vertices[0].coords_ = point_t(
-            static_cast<float>(_total_xy_range.lowx()), 0.0f, 0.0f, 1.0f);
+            static_cast<float>(static_cast<double>(_total_xy_range.lowx()) - xm),
+            static_cast<float>(-ym), 0.0f, 1.0f);
         vertices[1].coords_ = point_t(
-            static_cast<float>(_total_xy_range.highx()), 0.0f, 0.0f, 1.0f);
-        vertices[2].coords_ = point_t(
-            0.0f, static_cast<float>(_total_xy_range.lowy()), 0.0f, 1.0f);
-        vertices[3].coords_ = point_t(
-            0.0f, static_cast<float>(_total_xy_range.highy()), 0.0f, 1.0f);
+            static_cast<float>(static_cast<double>(_total_xy_range.highx()) - xm),
+            static_cast<float>(-ym), 0.0f, 1.0f);
+        vertices[2].coords_ = point_t(static_cast<float>(-xm),
+            static_cast<float>(static_cast<double>(_total_xy_range.lowy()) - ym), 0.0f, 1.0f);
+        vertices[3].coords_ = point_t(static_cast<float>(-xm),
+            static_cast<float>(static_cast<double>(_total_xy_range.highy()) - ym), 0.0f, 1.0f);
         vertices[0].color_ = axes_line_color_;
         vertices[1].color_ = axes_line_color_;
         vertices[2].color_ = axes_line_color_;
@@ -844,12 +1234,15 @@ void Canvas<T>::DrawVref(void) const
 
     // Send vertices and colors. -------------------------------------------------
     {
+        // Relative to the center of the visible range, see _visrange_to_clip_rtc
+        const double ym = static_cast<double>(_visible_range.ym());
+        const float x = static_cast<float>(static_cast<double>(ref_x_) - static_cast<double>(_visible_range.xm()));
         constexpr unsigned int n_vert = 2u;
         vertex_colored_t vertices[n_vert];
-        vertices[0].coords_ = point_t(static_cast<float>(ref_x_),
-            static_cast<float>(_total_xy_range.lowy()), 0.0f, 1.0f);
-        vertices[1].coords_ = point_t(static_cast<float>(ref_x_),
-            static_cast<float>(_total_xy_range.highy()), 0.0f, 1.0f);
+        vertices[0].coords_ = point_t(x,
+            static_cast<float>(static_cast<double>(_total_xy_range.lowy()) - ym), 0.0f, 1.0f);
+        vertices[1].coords_ = point_t(x,
+            static_cast<float>(static_cast<double>(_total_xy_range.highy()) - ym), 0.0f, 1.0f);
         vertices[0].color_ = vref_line_color_;
         vertices[1].color_ = vref_line_color_;
 
@@ -956,96 +1349,695 @@ void Canvas<T>::DrawFrame(void) const
 // 5. Graphs =====================================================================
 
 template<typename T>
-void Canvas<T>::SendDrawableToGPU(const Drawable<T>* const p_graph, const SizeInfo& p_offset) const
+void Canvas<T>::UpdateTotalRange(void)
+{
+    _total_xy_range = _graphs.at(0)->GetXYrange();
+    for (const auto* const gr : _graphs) {
+        _total_xy_range.Include(gr->GetXYrange());
+    }
+    for (const auto* const histo : _histograms) {
+        _total_xy_range.Include(histo->GetXYrange());
+    }
+    for (const auto* const histo : _histograms2d) {
+        _total_xy_range.Include(histo->GetXYrange());
+    }
+}
+
+template<typename T>
+void Canvas<T>::AllocateGraphBuffers(void)
+{
+    this->UpdateTotalRange();
+
+    // Nothing has been sent yet, so all the graphs are sent as a whole
+    graphs_upload_state_.assign(_graphs.size(), GraphUploadState());
+    density_caches_.resize(_graphs.size());
+    for (DensityCache& cache : density_caches_) {
+        cache.valid_ = false;
+    }
+    this->RelayoutGraphBuffers();
+
+    histogram_buffers_.resize(_histograms.size());
+    for (size_t i = 0; i < _histograms.size(); i++) {
+        this->SendHistogramToGPU(i);
+    }
+    histogram2d_textures_.resize(_histograms2d.size());
+    for (size_t i = 0; i < _histograms2d.size(); i++) {
+        this->SendHistogram2dToGPU(i);
+    }
+}
+
+template<typename T>
+void Canvas<T>::RelayoutGraphBuffers(void)
 {
 #ifdef SET_CONTEXT
     glfwMakeContextCurrent(_window);
 #endif
 
-    const SizeInfo& cur_size = p_graph->GetSizeInfo();
+    SizeInfo total_size; // Zeroed on construction
+    for (const auto* const gr : _graphs) {
+        total_size += gr->GetSizeInfo();
+    }
+    const unsigned int chunk_size = Graph<T>::GetVertexChunkSize();
+    const unsigned int n_vert = total_size._n_v;
+    const unsigned int n_chunks = (n_vert + chunk_size - 1u) / chunk_size;
 
-    // Send vertices and colors. -------------------------------------------------
+    // Allocate vertex buffer space for all graphs. ------------------------------
+    // The graphs reserve space for the points which may be appended later.
+    // Only the positions are stored, the color and the marker size are
+    // uniforms set per drawable.
+    GLuint vboID = 0u;
+    glGenBuffers(1, &vboID);
+    glObjectLabel(GL_BUFFER, vboID, -1, "graphs_vbo");
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vboID);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)n_vert * sizeof(Vec2f),
+        NULL, GL_DYNAMIC_DRAW);
+
+    // The final chunks of the graphs whose data was kept are moved on the GPU,
+    // so only the rest of their points is sent again.
+    std::vector<Vec2d> chunk_origins(n_chunks, Vec2d(0.0, 0.0));
+    glBindBuffer(GL_COPY_READ_BUFFER, _vboID_graphs);
+    unsigned int old_offset = 0u;
+    unsigned int new_offset = 0u;
+    for (size_t i = 0; i < _graphs.size(); i++) {
+        const Graph<T>* const gr = _graphs[i];
+        GraphUploadState& state = graphs_upload_state_[i];
+        if (state.generation_ == gr->GetDataGeneration()) {
+            for (size_t i_level = 0; i_level < state.n_final_.size(); i_level++) {
+                const unsigned int n = (state.n_final_[i_level] / chunk_size) * chunk_size;
+                if (n == 0u) continue;
+                const unsigned int src = old_offset + state.level_offsets_[i_level];
+                const unsigned int dst = new_offset + gr->GetLevelOffset((unsigned int)i_level);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                    (GLintptr)src * sizeof(Vec2f), (GLintptr)dst * sizeof(Vec2f),
+                    (GLsizeiptr)n * sizeof(Vec2f));
+                std::copy(chunk_origins_.begin() + src / chunk_size,
+                          chunk_origins_.begin() + (src + n) / chunk_size,
+                          chunk_origins.begin() + dst / chunk_size);
+            }
+        } else {
+            state.generation_ = gr->GetDataGeneration();
+            state.n_final_.clear();
+        }
+        old_offset += state.n_v_;
+        state.n_v_ = gr->GetSizeInfo()._n_v;
+        new_offset += state.n_v_;
+    }
+    glDeleteBuffers(1, &_vboID_graphs);
+    _vboID_graphs = vboID;
+    chunk_origins_.swap(chunk_origins);
+    chunk_translations_valid_ = false;
     {
-        vertex_colored_t* vertices = new vertex_colored_t[cur_size._n_v];
-
-        for (unsigned int i = 0; i < cur_size._n_v; i++) {
-            const Vec2<T>& cur_pt = p_graph->GetPoint(i);
-            vertices[i].coords_[0] = static_cast<float>(cur_pt.x());
-            vertices[i].coords_[1] = static_cast<float>(cur_pt.y());
-            vertices[i].coords_[2] = 0.0f;
-            vertices[i].coords_[3] = 1.0f;
-            vertices[i].color_ = p_graph->GetColor();
+        glBindVertexArray(_vaoID_graphs);
+        glBindBuffer(GL_ARRAY_BUFFER, _vboID_graphs);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2f), (void*)0);
+        glEnableVertexAttribArray(0);
+        //glBindVertexArray(0); // Not really needed.
+    }
+
+    // Allocate texture buffer space for the translations of the chunks. ---------
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, _tboID_graphs);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)std::max(n_chunks, 1u) * sizeof(Vec2f),
+            NULL, GL_DYNAMIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, _texID_graphs);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, _tboID_graphs);
+    }
+
+    SizeInfo cur_offset; // Zeroed on construction
+    for (size_t i = 0; i < _graphs.size(); i++) {
+        this->SendGraphToGPU(_graphs[i], cur_offset, graphs_upload_state_[i]);
+        cur_offset += _graphs[i]->GetSizeInfo();
+    }
+}
+
+template<typename T>
+bool Canvas<T>::GraphsChanged(void) const
+{
+    if (graphs_upload_state_.size() != _graphs.size()) return false; // Not shown yet
+    for (size_t i = 0; i < _graphs.size(); i++) {
+        const Graph<T>* const gr = _graphs[i];
+        const GraphUploadState& state = graphs_upload_state_[i];
+        if (state.generation_ != gr->GetDataGeneration() ||
+            state.n_v_ != gr->GetSizeInfo()._n_v ||
+            state.n_points_ != gr->GetNpoints()) {
+            return true;
         }
+    }
+    for (size_t i = 0; i < _histograms.size(); i++) {
+        if (histogram_buffers_[i].generation_ != _histograms[i]->GetDataGeneration()) {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < _histograms2d.size(); i++) {
+        if (histogram2d_textures_[i].generation_ != _histograms2d[i]->GetDataGeneration()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+void Canvas<T>::SyncGraphs(void)
+{
+    if (!this->GraphsChanged()) return;
+
+    bool relayout = false;
+    for (size_t i = 0; i < _graphs.size(); i++) {
+        const Graph<T>* const gr = _graphs[i];
+        const GraphUploadState& state = graphs_upload_state_[i];
+        if (state.generation_ != gr->GetDataGeneration() ||
+            state.n_v_ != gr->GetSizeInfo()._n_v) {
+            relayout = true;
+            break;
+        }
+    }
 
+    if (relayout) {
+        // The data was replaced or a graph outgrew its reserved space
+        this->RelayoutGraphBuffers();
+    } else {
+        // Only the points appended since the previous upload are sent
+        SizeInfo cur_offset; // Zeroed on construction
+        for (size_t i = 0; i < _graphs.size(); i++) {
+            const Graph<T>* const gr = _graphs[i];
+            GraphUploadState& state = graphs_upload_state_[i];
+            if (state.n_points_ != gr->GetNpoints()) {
+                this->SendGraphToGPU(gr, cur_offset, state);
+            }
+            cur_offset += gr->GetSizeInfo();
+        }
+    }
+    // A changed histogram costs one upload of its bin values
+    for (size_t i = 0; i < _histograms.size(); i++) {
+        if (histogram_buffers_[i].generation_ != _histograms[i]->GetDataGeneration()) {
+            this->SendHistogramToGPU(i);
+        }
+    }
+    for (size_t i = 0; i < _histograms2d.size(); i++) {
+        if (histogram2d_textures_[i].generation_ != _histograms2d[i]->GetDataGeneration()) {
+            this->SendHistogram2dToGPU(i);
+        }
+    }
+    this->UpdateTotalRange();
+
+    // The grid lines span the total range
+    _grid.Invalidate();
+    const int res = this->SendGridToGPU();
+    if (res == 0) { this->UpdateTexTextGridSize(); }
+}
+
+template<typename T>
+void Canvas<T>::PackVertices(const Vec2<T>* const p_points, const unsigned int p_n,
+    Vec2f* const o_vertices, Vec2d* const o_origins)
+{
+    // Positions are stored as differences to the first point of their chunk
+    const unsigned int chunk_size = Graph<T>::GetVertexChunkSize();
+    for (unsigned int first = 0u; first < p_n; first += chunk_size) {
+        const unsigned int last = std::min(first + chunk_size, p_n);
+        const Vec2<T>& p0 = p_points[first];
+        const Vec2d origin(
+            std::isfinite(p0.x()) ? static_cast<double>(p0.x()) : 0.0,
+            std::isfinite(p0.y()) ? static_cast<double>(p0.y()) : 0.0);
+        o_origins[first / chunk_size] = origin;
+        for (unsigned int i = first; i < last; i++) {
+            o_vertices[i] = Vec2f(
+                static_cast<float>(static_cast<double>(p_points[i].x()) - origin.x()),
+                static_cast<float>(static_cast<double>(p_points[i].y()) - origin.y()));
+        }
+    }
+}
+
+template<typename T>
+void Canvas<T>::SendVerticesToGPU(const Vec2<T>* const p_points, const unsigned int p_n,
+    const unsigned int p_offset)
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    if (p_n == 0u) return;
+
+    // 'p_offset' has to be a multiple of the chunk size
+    std::vector<Vec2f> vertices(p_n);
+    Canvas<T>::PackVertices(p_points, p_n, vertices.data(),
+        &chunk_origins_[p_offset / Graph<T>::GetVertexChunkSize()]);
+    chunk_translations_valid_ = false;
+
+    // Send positions. -----------------------------------------------------------
+    {
         glBindVertexArray(_vaoID_graphs);
         glBindBuffer(GL_ARRAY_BUFFER, _vboID_graphs);
         glBufferSubData(GL_ARRAY_BUFFER,
-            p_offset._n_v * sizeof(vertex_colored_t),
-            cur_size._n_v * sizeof(vertex_colored_t), vertices);
+            (GLintptr)p_offset * sizeof(Vec2f),
+            (GLsizeiptr)p_n * sizeof(Vec2f), vertices.data());
         //glBindVertexArray(0); // Not really needed.
+    }
+}
 
-        if (vertices != nullptr) delete[] vertices;
+template<typename T>
+void Canvas<T>::SendChunkTranslationsToGPU(void)
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    // The large parts cancel out here in double precision, so only the
+    // small translations of the chunks close to the visible range and the
+    // small relative positions are seen by the GPU.
+    const double xm = _visible_range.xm();
+    const double ym = _visible_range.ym();
+    const double sx = 2.0 / _visible_range.dx();
+    const double sy = 2.0 / _visible_range.dy();
+    std::vector<Vec2f> translations(chunk_origins_.size());
+    for (size_t i = 0; i < chunk_origins_.size(); i++) {
+        translations[i] = Vec2f(
+            static_cast<float>((chunk_origins_[i].x() - xm) * sx),
+            static_cast<float>((chunk_origins_[i].y() - ym) * sy));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, _tboID_graphs);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0,
+        (GLsizeiptr)translations.size() * sizeof(Vec2f), translations.data());
+    chunk_translations_valid_ = true;
+}
+
+template<typename T>
+void Canvas<T>::SendGraphToGPU(const Graph<T>* const p_graph, const SizeInfo& p_offset,
+    GraphUploadState& p_state)
+{
+    // All the levels of detail are stored one after another. The chunks of
+    // each level which could not change since the previous call are skipped.
+    // A chunk is always sent as a whole, because its origin is its first point.
+    const unsigned int chunk_size = Graph<T>::GetVertexChunkSize();
+    const unsigned int n_levels = p_graph->GetNlevels();
+    p_state.n_final_.resize(n_levels, 0u);
+    p_state.level_offsets_.resize(n_levels);
+    for (unsigned int i_level = 0; i_level < n_levels; i_level++) {
+        unsigned int n;
+        const Vec2<T>* const data = p_graph->GetLevelData(i_level, n);
+        const unsigned int first = (std::min(p_state.n_final_[i_level], n) / chunk_size) * chunk_size;
+        this->SendVerticesToGPU(data + first, n - first,
+            p_offset._n_v + p_graph->GetLevelOffset(i_level) + first);
+        p_state.n_final_[i_level] = std::min(p_graph->GetLevelNfinal(i_level), n);
+        p_state.level_offsets_[i_level] = p_graph->GetLevelOffset(i_level);
+    }
+    p_state.n_points_ = p_graph->GetNpoints();
+}
+
+template<typename T>
+void Canvas<T>::DrawGraph(const Graph<T>* const p_graph, const SizeInfo& p_offset) const
+{
+    // With many points per pixel column only the first, the lowest, the highest
+    // and the last point of each column are drawn, which gives the same picture.
+    // Otherwise the part of the data which falls into the visible range is drawn.
+    unsigned int first;
+    unsigned int n;
+    p_graph->GetVisibleSpan(0u,
+        static_cast<T>(_visible_range.lowx()), static_cast<T>(_visible_range.highx()),
+        first, n);
+    const int vw = _window_w - (margin_xl_pix_ + margin_xr_pix_);
+    if (vw > 0 && p_graph->DecimateToColumns(_visible_range.lowx(), _visible_range.dx() / (double)vw,
+                                             (unsigned int)vw, decimated_vertices_)) {
+        // A marker wider than a pixel is not covered by the line through its point,
+        // so then the markers of all the visible points are drawn and only the line is decimated
+        const bool all_markers = (p_graph->GetMarkerSize() > 1.0f);
+        if (all_markers) {
+            this->DrawVertexRange(p_graph, p_offset, first, n, false, vertex_pass_t::VP_MARKERS);
+        }
+        // The kept points of a column come from different levels, so consecutive
+        // vertices of the line are not adjacent in the vertex buffer
+        glBindVertexArray(_vaoID_graphs);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, decimated_vertices_.size() * sizeof(unsigned int),
+            decimated_vertices_.data(), GL_STREAM_DRAW);
+        this->DrawVertexRange(p_graph, p_offset, 0u, (unsigned int)decimated_vertices_.size(), true,
+            all_markers ? vertex_pass_t::VP_WIRES : vertex_pass_t::VP_ALL);
+        return;
     }
-    // Send markers and wires indices. -------------------------------------------
-    {
-        marker_t* markers = new marker_t[cur_size._n_m];
-        wire_t* wires = new wire_t[cur_size._n_w];
+    this->DrawVertexRange(p_graph, p_offset, first, n);
+}
 
-        for (unsigned int i = 0; i < cur_size._n_m; i++) {
-            markers[i].v0 = i;
+template<typename T>
+void Canvas<T>::DrawGraphDensity(const size_t p_index, const SizeInfo& p_offset)
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    const Graph<T>* const gr = _graphs[p_index];
+    DensityCache& cache = density_caches_[p_index];
+    const int w = _window_w - (margin_xl_pix_ + margin_xr_pix_);
+    const int h = _window_h - (margin_yb_pix_ + margin_yt_pix_);
+    if (w <= 0 || h <= 0) return;
+    if (!cache.valid_ || cache.w_ != w || cache.h_ != h ||
+        cache.generation_ != gr->GetDataGeneration() ||
+        cache.n_points_ != gr->GetNpoints() ||
+        cache.range_.lowx() != _visible_range.lowx() || cache.range_.dx() != _visible_range.dx() ||
+        cache.range_.lowy() != _visible_range.lowy() || cache.range_.dy() != _visible_range.dy()) {
+        this->SplatGraphDensity(p_index, p_offset, w, h);
+    }
+
+    // Colormap pass, drawn into the frame
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Resolve density");
+    prog_d_resolve_.Use();
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, cache.texID_);
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_2D, cache.maxTexID_);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_1D, _texID_colormap);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(_vaoID_histograms);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glPopDebugGroup();
+}
+
+template<typename T>
+void Canvas<T>::SplatGraphDensity(const size_t p_index, const SizeInfo& p_offset,
+    const int p_w, const int p_h)
+{
+    const auto make_texture = [](GLuint& o_texID, const int p_tex_w, const int p_tex_h) {
+        if (o_texID == 0u) glGenTextures(1, &o_texID);
+        glBindTexture(GL_TEXTURE_2D, o_texID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, p_tex_w, p_tex_h, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    };
+    const Graph<T>* const gr = _graphs[p_index];
+    DensityCache& cache = density_caches_[p_index];
+    if (cache.w_ != p_w || cache.h_ != p_h || cache.texID_ == 0u) {
+        make_texture(cache.texID_, p_w, p_h);
+        cache.w_ = p_w;
+        cache.h_ = p_h;
+    }
+    if (cache.maxTexID_ == 0u) {
+        make_texture(cache.maxTexID_, 1, 1);
+    }
+    // The intermediate levels of the reduction are shared by all the graphs
+    if (density_reduce_w_ != p_w || density_reduce_h_ != p_h) {
+        if (!_texID_density_reduce.empty()) {
+            glDeleteTextures((GLsizei)_texID_density_reduce.size(), _texID_density_reduce.data());
+            _texID_density_reduce.clear();
         }
-        for (unsigned int i = 0; i < cur_size._n_w; i++) {
-            wires[i].v0 = i;
-            wires[i].v1 = i + 1;
+        for (int lw = (p_w + 7) / 8, lh = (p_h + 7) / 8; lw > 1 || lh > 1;
+             lw = (lw + 7) / 8, lh = (lh + 7) / 8) {
+            GLuint texID = 0u;
+            make_texture(texID, lw, lh);
+            _texID_density_reduce.push_back(texID);
         }
+        density_reduce_w_ = p_w;
+        density_reduce_h_ = p_h;
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_m);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, p_offset._n_m * sizeof(marker_t),
-            cur_size._n_m * sizeof(marker_t), markers);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_w);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, p_offset._n_w * sizeof(wire_t),
-            cur_size._n_w * sizeof(wire_t), wires);
-
-        if (markers != nullptr) delete[] markers;
-        if (wires != nullptr) delete[] wires;
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Splat density");
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_density);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.texID_, 0);
+    glViewport(0, 0, p_w, p_h);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // Each point of the original data adds one to its pixel
+    glBlendFunc(GL_ONE, GL_ONE);
+    if (gr->GetNpoints() > 0u) {
+        prog_gr_m_.Use();
+        glProgramUniform4f(prog_gr_m_.GetProgId(), _color_unif_gr_m, 1.0f, 1.0f, 1.0f, 1.0f);
+        glProgramUniform1f(prog_gr_m_.GetProgId(), _marker_size_unif_gr_m, 1.0f);
+        glBindVertexArray(_vaoID_graphs);
+        glDrawArrays(GL_POINTS, (GLint)(p_offset._n_v + gr->GetLevelOffset(0u)),
+            (GLsizei)gr->GetNpoints());
+    }
+
+    // Maximum of the counts, 8x8 pixels per pass, the last pass writes into maxTexID_
+    glDisable(GL_BLEND);
+    prog_d_reduce_.Use();
+    glBindVertexArray(_vaoID_histograms);
+    GLuint src = cache.texID_;
+    int lw = p_w;
+    int lh = p_h;
+    for (size_t i = 0; i <= _texID_density_reduce.size(); i++) {
+        const GLuint dst = (i < _texID_density_reduce.size()) ? _texID_density_reduce[i] : cache.maxTexID_;
+        lw = (i < _texID_density_reduce.size()) ? (lw + 7) / 8 : 1;
+        lh = (i < _texID_density_reduce.size()) ? (lh + 7) / 8 : 1;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst, 0);
+        glViewport(0, 0, lw, lh);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, src);
+        glActiveTexture(GL_TEXTURE0);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        src = dst;
     }
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_scene);
+    glClearColor(background_color_[0], background_color_[1],
+                 background_color_[2], background_color_[3]);
+    this->SwitchToFrame();
+    glPopDebugGroup();
+
+    cache.range_ = _visible_range;
+    cache.generation_ = gr->GetDataGeneration();
+    cache.n_points_ = gr->GetNpoints();
+    cache.valid_ = true;
 }
 
 template<typename T>
-void Canvas<T>::DrawDrawable(const Drawable<T>* const p_graph, const SizeInfo& p_offset) const
+void Canvas<T>::DrawVertexRange(const Drawable<T>* const p_graph, const SizeInfo& p_offset,
+    const unsigned int p_first, const unsigned int p_n, const bool p_indexed,
+    const vertex_pass_t p_pass) const
 {
 #ifdef SET_CONTEXT
     glfwMakeContextCurrent(_window);
 #endif
 
-    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw drawable");
+    if (p_n == 0u) return;
 
-    const SizeInfo& cur_size = p_graph->GetSizeInfo();
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw drawable");
 
-    // Draw markers. Markers indices have already been sent. ---------------------
-    {
-        prog_m_.Use();
-        glPointSize(p_graph->GetMarkerSize());
+    // Graph vertices form a polyline, so only the decimated ones need an index buffer.
+    const GLint first = (GLint)(p_offset._n_v + p_first);
+    const auto draw = [&](const GLenum p_mode) {
+        if (p_indexed) {
+            glDrawElementsBaseVertex(p_mode, (GLsizei)p_n, GL_UNSIGNED_INT,
+                (void*)(p_first * sizeof(unsigned int)), (GLint)p_offset._n_v);
+        } else {
+            glDrawArrays(p_mode, first, (GLsizei)p_n);
+        }
+    };
+    // Draw markers. -------------------------------------------------------------
+    if (p_pass != vertex_pass_t::VP_WIRES) {
+        prog_gr_m_.Use();
+        glProgramUniform4fv(prog_gr_m_.GetProgId(), _color_unif_gr_m, 1,
+            p_graph->GetColor().GetData());
+        glProgramUniform1f(prog_gr_m_.GetProgId(), _marker_size_unif_gr_m,
+            p_graph->GetMarkerSize());
         glBindVertexArray(_vaoID_graphs);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_m);
-        glDrawElementsBaseVertex(GL_POINTS, 1 * cur_size._n_m, GL_UNSIGNED_INT,
-            (GLvoid*)(p_offset._n_m * sizeof(marker_t)), (GLint)p_offset._n_v);
+        draw(GL_POINTS);
         //glBindVertexArray(0); // Not really needed.
     }
-    // Draw wires. Wires indices have already been sent. -------------------------
-    {
-        prog_w_.Use();
+    // Draw wires. ---------------------------------------------------------------
+    if (p_pass != vertex_pass_t::VP_MARKERS) {
+        prog_gr_w_.Use();
+        glProgramUniform4fv(prog_gr_w_.GetProgId(), _color_unif_gr_w, 1,
+            p_graph->GetColor().GetData());
         glLineWidth(p_graph->GetLineWidth());
         glBindVertexArray(_vaoID_graphs);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _iboID_graphs_w);
-        glDrawElementsBaseVertex(GL_LINES, 2 * cur_size._n_w, GL_UNSIGNED_INT,
-            (GLvoid*)(p_offset._n_w * sizeof(wire_t)), (GLint)p_offset._n_v);
+        draw(GL_LINE_STRIP);
         //glBindVertexArray(0); // Not really needed.
     }
 
     glPopDebugGroup();
 }
 
+template<typename T>
+void Canvas<T>::SendHistogramToGPU(const size_t p_index)
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    const Histogram1d<T, unsigned long>* const histo = _histograms[p_index];
+    HistogramBuffers& buffers = histogram_buffers_[p_index];
+    if (buffers.tboID_ == 0u) {
+        glGenBuffers(1, &buffers.tboID_);
+        glGenTextures(1, &buffers.texID_);
+        glObjectLabel(GL_BUFFER, buffers.tboID_, -1, "histogram_tbo");
+    }
+
+    // Only the bin values are sent, the GPU has no 64-bit integer texels
+    const unsigned int n_bins = histo->GetNbins();
+    const unsigned long* const values = histo->GetBinValues();
+    std::vector<float> bins(std::max(n_bins, 1u), 0.0f);
+    for (unsigned int i = 0; i < n_bins; i++) {
+        bins[i] = static_cast<float>(values[i]);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers.tboID_);
+    if (buffers.n_bins_ != n_bins) {
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)bins.size() * sizeof(float),
+            bins.data(), GL_DYNAMIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, buffers.texID_);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, buffers.tboID_);
+        buffers.n_bins_ = n_bins;
+    } else {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0,
+            (GLsizeiptr)bins.size() * sizeof(float), bins.data());
+    }
+    buffers.generation_ = histo->GetDataGeneration();
+}
+
+template<typename T>
+void Canvas<T>::DrawHistogram(const size_t p_index) const
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    const Histogram1d<T, unsigned long>* const histo = _histograms[p_index];
+    const HistogramBuffers& buffers = histogram_buffers_[p_index];
+    const unsigned int n_bins = buffers.n_bins_;
+    if (n_bins == 0u) return;
+
+    // Only the visible bins and their neighbours, for the vertical steps, are drawn
+    const double x_min = static_cast<double>(histo->GetXmin());
+    const double bin_width = (static_cast<double>(histo->GetXmax()) - x_min) / (double)n_bins;
+    const auto bin_at = [&](const double x) {
+        return std::min(std::max(std::floor((x - x_min) / bin_width), 0.0), (double)n_bins);
+    };
+    const unsigned int first = (unsigned int)std::max(bin_at(_visible_range.lowx()) - 1.0, 0.0);
+    const unsigned int last = (unsigned int)std::min(bin_at(_visible_range.highx()) + 2.0, (double)n_bins);
+    if (last <= first) return;
+
+    // The x of the bins is taken relative to the bin closest to the center of
+    // the visible range, the large parts cancel out in double precision here.
+    const double xm = _visible_range.xm();
+    const double ym = _visible_range.ym();
+    const double sx = 2.0 / _visible_range.dx();
+    const double sy = 2.0 / _visible_range.dy();
+    const unsigned int bin_ref = std::min((unsigned int)bin_at(xm), n_bins - 1u);
+    const GLuint prog = prog_h_.GetProgId();
+    prog_h_.Use();
+    glProgramUniform4fv(prog, _color_unif_h, 1, histo->GetColor().GetData());
+    glProgramUniform1f(prog, _marker_size_unif_h, histo->GetMarkerSize());
+    glProgramUniform1i(prog, _bin_ref_unif_h, (GLint)bin_ref);
+    glProgramUniform2f(prog, _bin_transform_unif_h,
+        (float)((x_min + (double)bin_ref * bin_width - xm) * sx), (float)(bin_width * sx));
+    glProgramUniform2f(prog, _y_transform_unif_h, (float)sy, (float)(-ym * sy));
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.texID_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(_vaoID_histograms);
+
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw histogram");
+    // Draw markers at the centers of the bins. ----------------------------------
+    glProgramUniform1i(prog, _vertices_per_bin_unif_h, 1);
+    glDrawArrays(GL_POINTS, (GLint)first, (GLsizei)(last - first));
+    // Draw the outline, 3 vertices per bin. -------------------------------------
+    glProgramUniform1i(prog, _vertices_per_bin_unif_h, 3);
+    glLineWidth(histo->GetLineWidth());
+    glDrawArrays(GL_LINE_STRIP, (GLint)(3u * first), (GLsizei)(3u * (last - first)));
+    glPopDebugGroup();
+    //glBindVertexArray(0); // Not really needed.
+}
+
+template<typename T>
+void Canvas<T>::SendHistogram2dToGPU(const size_t p_index)
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    const Histogram2d<T, unsigned long>* const histo = _histograms2d[p_index];
+    Histogram2dTexture& texture = histogram2d_textures_[p_index];
+    const unsigned int nx = histo->GetNbinsX();
+    const unsigned int ny = histo->GetNbinsY();
+    if (nx == 0u || ny == 0u) return;
+    if (texture.texID_ == 0u) {
+        glGenTextures(1, &texture.texID_);
+        glObjectLabel(GL_TEXTURE, texture.texID_, -1, "histogram2d_tex");
+    }
+    glBindTexture(GL_TEXTURE_2D, texture.texID_);
+
+    // Only the runs of rows changed since the previous upload are sent
+    const bool reallocate = (texture.n_bins_x_ != nx || texture.n_bins_y_ != ny);
+    if (reallocate) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, (GLsizei)nx, (GLsizei)ny, 0,
+            GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        texture.n_bins_x_ = nx;
+        texture.n_bins_y_ = ny;
+    }
+    const unsigned long* const values = histo->GetBinValues();
+    std::vector<float> rows;
+    unsigned int first = 0u;
+    while (first < ny) {
+        if (!reallocate && histo->GetRowGeneration(first) <= texture.generation_) {
+            first++;
+            continue;
+        }
+        unsigned int last = first + 1u;
+        while (last < ny && (reallocate || histo->GetRowGeneration(last) > texture.generation_)) {
+            last++;
+        }
+        const size_t n = (size_t)(last - first) * nx;
+        const unsigned long* const run = values + (size_t)first * nx;
+        rows.resize(n);
+        for (size_t i = 0u; i < n; i++) {
+            rows[i] = static_cast<float>(run[i]);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)first, (GLsizei)nx, (GLsizei)(last - first),
+            GL_RED, GL_FLOAT, rows.data());
+        first = last;
+    }
+    texture.generation_ = histo->GetDataGeneration();
+}
+
+template<typename T>
+void Canvas<T>::DrawHistogram2d(const size_t p_index) const
+{
+#ifdef SET_CONTEXT
+    glfwMakeContextCurrent(_window);
+#endif
+
+    const Histogram2d<T, unsigned long>* const histo = _histograms2d[p_index];
+    const Histogram2dTexture& texture = histogram2d_textures_[p_index];
+    if (texture.n_bins_x_ == 0u || histo->GetMaxValue() == 0u) return;
+
+    // The quad is cut to the visible range in double precision,
+    // so that its corners stay close to the clip space at any zoom.
+    const XYrange<T>& range = histo->GetXYrange();
+    const double x0 = std::max((double)range.lowx(), _visible_range.lowx());
+    const double x1 = std::min((double)range.highx(), _visible_range.highx());
+    const double y0 = std::max((double)range.lowy(), _visible_range.lowy());
+    const double y1 = std::min((double)range.highy(), _visible_range.highy());
+    if (!(x0 < x1 && y0 < y1)) return;
+    const double xm = _visible_range.xm();
+    const double ym = _visible_range.ym();
+    const double sx = 2.0 / _visible_range.dx();
+    const double sy = 2.0 / _visible_range.dy();
+    const double u = 1.0 / (double)range.dx();
+    const double v = 1.0 / (double)range.dy();
+    const GLuint prog = prog_h2_.GetProgId();
+    prog_h2_.Use();
+    glProgramUniform4f(prog, _rect_unif_h2,
+        (float)((x0 - xm) * sx), (float)((y0 - ym) * sy),
+        (float)((x1 - xm) * sx), (float)((y1 - ym) * sy));
+    glProgramUniform4f(prog, _uv_rect_unif_h2,
+        (float)((x0 - (double)range.lowx()) * u), (float)((y0 - (double)range.lowy()) * v),
+        (float)((x1 - (double)range.lowx()) * u), (float)((y1 - (double)range.lowy()) * v));
+    glProgramUniform1f(prog, _value_scale_unif_h2, 1.0f / (float)histo->GetMaxValue());
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, texture.texID_);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_1D, _texID_colormap);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(_vaoID_histograms);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    //glBindVertexArray(0); // Not really needed.
+}
+
 // 6. Cursor =====================================================================
 
 template<typename T>
@@ -1062,6 +2054,7 @@ void Canvas<T>::DrawCursor(const double xs, const double ys) const
     this->SwitchToFullWindow(); //TODO move outside?
 
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw cursor");
+    profiler_.Begin(frame_pass_t::FP_CURSOR);
 
     // Send vertices and colors. -------------------------------------------------
     {
@@ -1093,6 +2086,7 @@ void Canvas<T>::DrawCursor(const double xs, const double ys) const
         glDisable(GL_LINE_STIPPLE);
     }
 
+    profiler_.End(frame_pass_t::FP_CURSOR);
     glPopDebugGroup();
 }
 
@@ -1114,12 +2108,19 @@ void Canvas<T>::DrawSelRectangle(const double xs0, const double ys0,
     {
         constexpr unsigned int n_vert = 4u;
         vertex_colored_t vertices[n_vert];
-        const Vec4f p0r = this->TransformToVisrange(xs0, ys0);
-        const Vec4f p1r = this->TransformToVisrange(xs1, ys1);
-        vertices[0].coords_ = point_t(p0r.x(), p0r.y(), 0.0f, 1.0f);
-        vertices[1].coords_ = point_t(p1r.x(), p0r.y(), 0.0f, 1.0f);
-        vertices[2].coords_ = point_t(p1r.x(), p1r.y(), 0.0f, 1.0f);
-        vertices[3].coords_ = point_t(p0r.x(), p1r.y(), 0.0f, 1.0f);
+        // Relative to the center of the visible range, see _visrange_to_clip_rtc
+        const Vec4d p0r = this->TransformToVisrange(xs0, ys0);
+        const Vec4d p1r = this->TransformToVisrange(xs1, ys1);
+        const double xm = static_cast<double>(_visible_range.xm());
+        const double ym = static_cast<double>(_visible_range.ym());
+        const float x0 = static_cast<float>(p0r.x() - xm);
+        const float y0 = static_cast<float>(p0r.y() - ym);
+        const float x1 = static_cast<float>(p1r.x() - xm);
+        const float y1 = static_cast<float>(p1r.y() - ym);
+        vertices[0].coords_ = point_t(x0, y0, 0.0f, 1.0f);
+        vertices[1].coords_ = point_t(x1, y0, 0.0f, 1.0f);
+        vertices[2].coords_ = point_t(x1, y1, 0.0f, 1.0f);
+        vertices[3].coords_ = point_t(x0, y1, 0.0f, 1.0f);
         vertices[0].color_ = tiny_gl_text_renderer::colors::sel_color;
         vertices[1].color_ = tiny_gl_text_renderer::colors::sel_color;
         vertices[2].color_ = tiny_gl_text_renderer::colors::sel_color;
@@ -1181,13 +2182,16 @@ void Canvas<T>::DrawCircles(const double xs, const double ys) const
         vertex_colored_t* vertices = new vertex_colored_t[n_vert];
         marker_t* markers = new marker_t[n_vert];
 
-        const Vec4f pr = this->TransformToVisrange(xs, ys);
+        const Vec4d pr = this->TransformToVisrange(xs, ys);
+        const T x = static_cast<T>(pr.x());
         int i_gr = 0;
         for (const auto* const gr : _graphs) {
             if (!gr->GetVisible()) continue;
-            const T y = gr->Evaluate(static_cast<T>(pr.x()));
+            const T y = gr->Evaluate(x);
+            // Relative to the center of the visible range, see _visrange_to_clip_rtc
             vertices[i_gr].coords_ = point_t(
-                pr.x(), static_cast<float>(y), 0.0f, 1.0f);
+                static_cast<float>(static_cast<double>(x) - _visible_range.xm()),
+                static_cast<float>(static_cast<double>(y) - _visible_range.ym()), 0.0f, 1.0f);
             vertices[i_gr].color_ = gr->GetColor();
             markers[i_gr].v0 = i_gr;
             i_gr++;
@@ -1219,7 +2223,7 @@ void Canvas<T>::UpdateTexTextCur(const double xs, const double ys)
     glfwMakeContextCurrent(_window);
 #endif
 
-    const Vec4f pr = this->TransformToVisrange(xs, ys);
+    const Vec4d pr = this->TransformToVisrange(xs, ys);
     const T x = static_cast<T>(pr.x());
     const T y = static_cast<T>(pr.y());
     const T& x0 = ref_x_;
@@ -1240,10 +2244,13 @@ void Canvas<T>::UpdateTexTextCur(const double xs, const double ys)
     text_rend_.UpdateLabel(buf, i_lab2);
     i_lab2++;
 
+    // Each graph is evaluated once, the values are reused for the differences
+    std::vector<T> y_at_x(_graphs.size());
     int i_gr = 0;
     for (const auto* const gr : _graphs) {
         const T y0 = gr->Evaluate(x0);
         const T yi = gr->Evaluate(x);
+        y_at_x[i_gr] = yi;
         snprintf(&buf[0], BUFSIZE, "y%d=% 0.4f", i_gr, yi);
         text_rend_.UpdateLabel(buf, i_lab1);
         snprintf(&buf[0], BUFSIZE, "dy%d=% 0.4f", i_gr, yi - y0);
@@ -1258,11 +2265,7 @@ void Canvas<T>::UpdateTexTextCur(const double xs, const double ys)
 
     for (int i = 0; i < (int)(_graphs.size()); i++) {
         for (int j = i + 1; j < (int)(_graphs.size()); j++) {
-            const Graph<T>* const gri = _graphs.at(i);
-            const Graph<T>* const grj = _graphs.at(j);
-            const T yi = gri->Evaluate(x);
-            const T yj = grj->Evaluate(x);
-            const T dy = yj - yi;
+            const T dy = y_at_x[j] - y_at_x[i];
             snprintf(&buf[0], BUFSIZE, "% 0.4f", dy);
             text_rend_.UpdateLabel(buf, i_lab3);
             i_lab3 += 5;
@@ -1277,11 +2280,11 @@ void Canvas<T>::UpdateTexTextRef(const double xs, const double ys)
     glfwMakeContextCurrent(_window);
 #endif
 
-    const Vec4f pr = this->TransformToVisrange(xs, ys);
+    const Vec4d pr = this->TransformToVisrange(xs, ys);
 
     if (!_total_xy_range.IncludesX(pr.x())) return;
 
-    ref_x_ = pr.x();
+    ref_x_ = static_cast<T>(pr.x());
 
     const size_t BUFSIZE = 32;
     char buf[BUFSIZE];
@@ -1327,34 +2330,58 @@ void Canvas<T>::UpdateTexAxesValues(void)
 #ifdef SET_CONTEXT
     glfwMakeContextCurrent(_window);
 #endif
-    unsigned int nv_;
-    const vertex_colored_t* const vertices = _grid.GetVerticesData(nv_);
-    unsigned int nx_;
-    unsigned int ny_;
-    const wire_t* const wires = _grid.GetWiresCoarseData(nx_, ny_);
+    // The coarse grid lines, at the multiples of the coarse steps as placed
+    // by Grid::BuildGrid() and by the procedural grid
+    const T xmin = std::fmax(_visible_range.lowx(),  _total_xy_range.lowx());
+    const T xmax = std::fmin(_visible_range.highx(), _total_xy_range.highx());
+    const T ymin = std::fmax(_visible_range.lowy(),  _total_xy_range.lowy());
+    const T ymax = std::fmin(_visible_range.highy(), _total_xy_range.highy());
+    const bool empty = !(xmin < xmax) || !(ymin < ymax);
+    T x_first = T(0);
+    T y_first = T(0);
+    const unsigned int nx_ = empty ? 0u : Grid<T>::CountLines(xmin, xmax, _grid.GetCoarseXstep(), x_first);
+    const unsigned int ny_ = empty ? 0u : Grid<T>::CountLines(ymin, ymax, _grid.GetCoarseYstep(), y_first);
+    const double x_step = static_cast<double>(_grid.GetCoarseXstep());
+    const double y_step = static_cast<double>(_grid.GetCoarseYstep());
+    const auto x_value = [&](const unsigned int i) {
+        return static_cast<double>(x_first) + static_cast<double>(i) * x_step;
+    };
+    const auto y_value = [&](const unsigned int i) {
+        return static_cast<double>(y_first) + static_cast<double>(i) * y_step;
+    };
+    // Visible range to clip space in double, the inverse of _clip_to_visrange_hp
+    const auto to_clip = [this](const double p_value, const unsigned int p_axis) {
+        return static_cast<float>((p_value - _clip_to_visrange_hp[3*4+p_axis]) / _clip_to_visrange_hp[p_axis*4+p_axis]);
+    };
 
     const unsigned int nx = std::min(_n_x_axis_value_labels_max, nx_);
     const unsigned int ny = std::min(_n_y_axis_value_labels_max, ny_);
 
     const int ch_width = (int)(font_size_ * (float)tiny_gl_text_renderer::CHAR_WIDTH);
     //const int line_height = (int)(font_size_ * (float)tiny_gl_text_renderer::CHAR_HEIGHT);
-    constexpr size_t BUFSIZE = 32;
-    char buf[BUFSIZE];
+
+    // The same values come back at the same steps, the map is bounded for long pans
+    constexpr size_t max_tick_strings = 1024u;
+    const double steps[2] = { _grid.GetCoarseXstep(), _grid.GetCoarseYstep() };
+    for (unsigned int axis = 0u; axis < 2u; axis++) {
+        if (steps[axis] != tick_strings_step_[axis] ||
+            tick_strings_[axis].size() > max_tick_strings) {
+            tick_strings_[axis].clear();
+            tick_strings_step_[axis] = steps[axis];
+        }
+    }
 
     // X axis --------------------------------------------------------------------
 
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Update X axis labels");
 
     for (unsigned int i = 0; i < nx; i++) {
-        const unsigned int idx0 = wires[i].v0;
-        //const unsigned int idx1 = wires[i].v1;
-
-        snprintf(buf, BUFSIZE, "%g", vertices[idx0].coords_.x());
-        const int offset = -(ch_width * (int)strlen(buf)) / 2;
-        text_rend_.UpdateLabel(buf, _x_axis_values_lables_start_idx + (size_t)i);
+        const double value = x_value(i);
+        const std::string& str = this->GetTickString(0u, value, x_step);
+        const int offset = -(ch_width * (int)str.size()) / 2;
+        text_rend_.UpdateLabel(str.c_str(), _x_axis_values_lables_start_idx + (size_t)i);
 
-        const Vec4f vr(vertices[idx0].coords_.x(), 0.0f, 0.0f, 1.0f);
-        const Vec4f vc = _visrange_to_clip * vr;
+        const Vec4f vc(to_clip(value, 0u), 0.0f, 0.0f, 1.0f);
         //const Vec4f vs = _clip_to_screen * vc;
         const Vec4f vv = _clip_to_viewport * vc;
         const Vec4f vs = _viewport_to_screen * vv;
@@ -1373,15 +2400,12 @@ void Canvas<T>::UpdateTexAxesValues(void)
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Update Y axis labels");
 
     for (unsigned int i = 0; i < ny; i++) {
-        const unsigned int idx0 = wires[nx_+i].v0;
-        //const unsigned int idx1 = wires[nx_+i].v1;
-
-        snprintf(buf, BUFSIZE, "%g", vertices[idx0].coords_.y());
-        const int offset = (ch_width * (int)strlen(buf)) / 2;
-        text_rend_.UpdateLabel(buf, _y_axis_values_lables_start_idx + (size_t)i);
+        const double value = y_value(i);
+        const std::string& str = this->GetTickString(1u, value, y_step);
+        const int offset = (ch_width * (int)str.size()) / 2;
+        text_rend_.UpdateLabel(str.c_str(), _y_axis_values_lables_start_idx + (size_t)i);
 
-        const Vec4f vr(0.0f, vertices[idx0].coords_.y(), 0.0f, 1.0f);
-        const Vec4f vc = _visrange_to_clip * vr;
+        const Vec4f vc(0.0f, to_clip(value, 1u), 0.0f, 1.0f);
         //const Vec4f vs = _clip_to_screen * vc;
         const Vec4f vv = _clip_to_viewport * vc;
         const Vec4f vs = _viewport_to_screen * vv;
@@ -1394,6 +2418,67 @@ void Canvas<T>::UpdateTexAxesValues(void)
     }
 
     glPopDebugGroup();
+
+    axes_values_valid_ = true;
+}
+
+template<typename T>
+void Canvas<T>::SetPerfOverlay(const bool p_on)
+{
+    perf_overlay_ = p_on;
+    perf_overlay_valid_ = false;
+    if (!perf_overlay_ && _perf_labels_start_idx != 0u) {
+        for (size_t i = 0u; i <= (size_t)frame_pass_t::FP_N; i++) {
+            text_rend_.UpdateLabel("", _perf_labels_start_idx + i);
+        }
+    }
+}
+
+template<typename T>
+void Canvas<T>::UpdateTexPerfOverlay(void)
+{
+    // A few times per second, faster changing values could not be read anyway
+    const auto now = std::chrono::steady_clock::now();
+    if (_perf_labels_start_idx == 0u) return;
+    if (perf_overlay_valid_ && now - perf_overlay_time_ < std::chrono::milliseconds(250)) return;
+    perf_overlay_valid_ = true;
+    perf_overlay_time_ = now;
+
+    constexpr size_t BUFSIZE = 64;
+    char buf[BUFSIZE];
+    snprintf(buf, BUFSIZE, "%-13s%8s%8s%8s%8s", "ms", "cpu p50", "p99", "gpu p50", "p99");
+    text_rend_.UpdateLabel(buf, _perf_labels_start_idx);
+    const FrameStats stats = profiler_.GetStats();
+    for (size_t i = 0u; i < (size_t)frame_pass_t::FP_N; i++) {
+        const PassStats& pass = stats.passes_[i];
+        if (pass.n_cpu_samples_ == 0u) {
+            snprintf(buf, BUFSIZE, "%-13s%8s%8s%8s%8s", pass.name_, "-", "-", "-", "-");
+        } else if (pass.n_gpu_samples_ == 0u) {
+            snprintf(buf, BUFSIZE, "%-13s%8.3f%8.3f%8s%8s", pass.name_,
+                pass.cpu_p50_ms_, pass.cpu_p99_ms_, "-", "-");
+        } else {
+            snprintf(buf, BUFSIZE, "%-13s%8.3f%8.3f%8.3f%8.3f", pass.name_,
+                pass.cpu_p50_ms_, pass.cpu_p99_ms_, pass.gpu_p50_ms_, pass.gpu_p99_ms_);
+        }
+        text_rend_.UpdateLabel(buf, _perf_labels_start_idx + 1u + i);
+    }
+}
+
+template<typename T>
+const std::string& Canvas<T>::GetTickString(const unsigned int p_axis,
+    const double p_value, const double p_step)
+{
+    // Far from zero neighbouring values may round to the same float, their indices differ
+    const long long index = std::llround(p_value / p_step);
+    std::unordered_map<long long, std::string>& strings = tick_strings_[p_axis];
+    auto it = strings.find(index);
+    if (it == strings.end()) {
+        constexpr size_t BUFSIZE = 32;
+        char buf[BUFSIZE];
+        Grid<T>::FormatValue(p_value, p_step, buf, BUFSIZE);
+        it = strings.emplace(index, std::string(buf)).first;
+    }
+    return it->second;
 }
 
 // ===============================================================================
@@ -1405,11 +2490,11 @@ void Canvas<T>::CenterView(const double xs, const double ys)
 ////    glfwMakeContextCurrent(_window);
 ////#endif
 
-    const Vec4f pr = this->TransformToVisrange(xs, ys);
-    const float cur_center_x = 0.5f * _visible_range.twoxm();
-    const float cur_center_y = 0.5f * _visible_range.twoym();
-    _visible_range.MoveX((float)pr.x() - cur_center_x);
-    _visible_range.MoveY((float)pr.y() - cur_center_y);
+    const Vec4d pr = this->TransformToVisrange(xs, ys);
+    const double cur_center_x = 0.5 * _visible_range.twoxm();
+    const double cur_center_y = 0.5 * _visible_range.twoym();
+    _visible_range.MoveX(pr.x() - cur_center_x);
+    _visible_range.MoveY(pr.y() - cur_center_y);
 
     this->UpdateMatricesPanZoom();
     const int res = this->SendGridToGPU();
@@ -1423,10 +2508,10 @@ void Canvas<T>::Pan(const double xs, const double ys)
 ////    glfwMakeContextCurrent(_window);
 ////#endif
 
-    const Vec4f p2r = this->TransformToVisrange(_xs_prev, _ys_prev);
-    const Vec4f p1r = this->TransformToVisrange(xs, ys);
-    const float shift_x = ((float)p1r.x() - (float)p2r.x());
-    const float shift_y = ((float)p1r.y() - (float)p2r.y());
+    const Vec4d p2r = this->TransformToVisrange(_xs_prev, _ys_prev);
+    const Vec4d p1r = this->TransformToVisrange(xs, ys);
+    const double shift_x = (p1r.x() - p2r.x());
+    const double shift_y = (p1r.y() - p2r.y());
 
     _visible_range.MoveX(-shift_x);
     _visible_range.MoveY(-shift_y);
@@ -1443,33 +2528,35 @@ void Canvas<T>::Zoom(const double xs, const double ys)
 ////    glfwMakeContextCurrent(_window);
 ////#endif
 
-    const Vec4f deltas((float)(-xs + _xs_start), (float)(-ys + _ys_start), 0.0f, 0.0f);
-    Vec4f deltac;
+    const Vec4d deltas(-xs + _xs_start, -ys + _ys_start, 0.0, 0.0);
+    Vec4d deltac;
     this->TransformToVisrange(deltas, &deltac);
-    const float kx = 1.0f + 0.5f * deltac.x();
-    const float ky = 1.0f + 0.5f * deltac.y();
-
-    if (kx < 0.0f || ky < 0.0f) return;
-
-    Vec4f p0c;
-    Vec4f p1c;
-    const Vec4f p0r = this->TransformToVisrange(_xs_start, _ys_start, &p0c);
-    //const Vec4f p1r = this->TransformToVisrange(xs, ys, &p1c);
-    //const float kx = 1.0f + 0.5f * ((float)p0c.x() - (float)p1c.x());
-    //const float ky = 1.0f + 0.5f * ((float)p0c.y() - (float)p1c.y());
-    const float center_x = (float)p0r.x();
-    const float center_y = (float)p0r.y();
-    const float dxr_down_start = center_x - _visible_range_start.lowx();
-    //const float dxr_up_start   = _visible_range_start.highx() - center_x;
-    const float dyr_down_start = center_y - _visible_range_start.lowy();
-    //const float dyr_up_start   = _visible_range_start.highy() - center_y;
-    if (kx * _visible_range_start.dx() > (float)1.0e-7 &&
-        kx * _visible_range_start.dx() < (float)1.0e+7) { // Limit zooming
-        _visible_range.SetXrange2(center_x - dxr_down_start * kx, kx * _visible_range_start.dx());
-    }
-    if (ky * _visible_range_start.dy() > (float)1.0e-7 &&
-        ky * _visible_range_start.dy() < (float)1.0e+7) { // Limit zooming
-        _visible_range.SetYrange2(center_y - dyr_down_start * ky, ky * _visible_range_start.dy());
+    const double kx = 1.0 + 0.5 * deltac.x();
+    const double ky = 1.0 + 0.5 * deltac.y();
+
+    if (kx < 0.0 || ky < 0.0) return;
+
+    Vec4d p0c;
+    //Vec4d p1c;
+    const Vec4d p0r = this->TransformToVisrange(_xs_start, _ys_start, &p0c);
+    //const Vec4d p1r = this->TransformToVisrange(xs, ys, &p1c);
+    //const double kx = 1.0 + 0.5 * (p0c.x() - p1c.x());
+    //const double ky = 1.0 + 0.5 * (p0c.y() - p1c.y());
+    const double center_x = p0r.x();
+    const double center_y = p0r.y();
+    const double dxr_down_start = center_x - _visible_range_start.lowx();
+    //const double dxr_up_start   = _visible_range_start.highx() - center_x;
+    const double dyr_down_start = center_y - _visible_range_start.lowy();
+    //const double dyr_up_start   = _visible_range_start.highy() - center_y;
+    // Limit zooming. The lower limit is relative to the position of the range,
+    // as a double only has about 16 significant digits.
+    const double new_dx = kx * _visible_range_start.dx();
+    const double new_dy = ky * _visible_range_start.dy();
+    if (new_dx > 1.0e-12 * std::fabs(center_x) && new_dx > 1.0e-30 && new_dx < 1.0e+30) {
+        _visible_range.SetXrange2(center_x - dxr_down_start * kx, new_dx);
+    }
+    if (new_dy > 1.0e-12 * std::fabs(center_y) && new_dy > 1.0e-30 && new_dy < 1.0e+30) {
+        _visible_range.SetYrange2(center_y - dyr_down_start * ky, new_dy);
     }
 
     this->UpdateMatricesPanZoom();
@@ -1509,14 +2596,14 @@ void Canvas<T>::ZoomTo(const double xs0, const double ys0, const double xs1, con
     ////    glfwMakeContextCurrent(_window);
     ////#endif
 
-    const Vec4f p0r = this->TransformToVisrange(xs0, ys0);
-    const Vec4f p1r = this->TransformToVisrange(xs1, ys1);
+    const Vec4d p0r = this->TransformToVisrange(xs0, ys0);
+    const Vec4d p1r = this->TransformToVisrange(xs1, ys1);
 
     _visible_range.Set1(
-        static_cast<float>(std::fmin(p0r.x(), p1r.x())),
-        static_cast<float>(std::fmax(p0r.x(), p1r.x())),
-        static_cast<float>(std::fmin(p0r.y(), p1r.y())),
-        static_cast<float>(std::fmax(p0r.y(), p1r.y())));
+        std::fmin(p0r.x(), p1r.x()),
+        std::fmax(p0r.x(), p1r.x()),
+        std::fmin(p0r.y(), p1r.y()),
+        std::fmax(p0r.y(), p1r.y()));
 
     this->UpdateMatricesPanZoom();
     const int res = this->SendGridToGPU();
@@ -1568,14 +2655,14 @@ void Canvas<T>::FixedAspRatCamera(void)
         const double midy           = 0.5 * _visible_range.twoym();
         const double new_half_range = 0.5 * _visible_range.dx();
         _visible_range.SetYrange1(
-            static_cast<float>(midy - new_half_range * asp_rat_inv),
-            static_cast<float>(midy + new_half_range * asp_rat_inv));
+            midy - new_half_range * asp_rat_inv,
+            midy + new_half_range * asp_rat_inv);
     } else {
         const double midx           = 0.5 * _visible_range.twoxm();
         const double new_half_range = 0.5 * _visible_range.dy();
         _visible_range.SetXrange1(
-            static_cast<float>(midx - new_half_range * asp_rat),
-            static_cast<float>(midx + new_half_range * asp_rat));
+            midx - new_half_range * asp_rat,
+            midx + new_half_range * asp_rat);
     }
 
     this->UpdateMatricesReshape();
@@ -1594,11 +2681,13 @@ void Canvas<T>::ExportSnapshot(void)
     getenv_s(&len[1], drive_dir[1], _MAX_PATH, "HOMEPATH");
     if (len[0] == 0 || len[1] == 0) return;
     const std::string dir = std::string(drive_dir[0]) + std::string(drive_dir[1]);
-    const char filename[] = "snapshot.png";
-    this->ExportPNG(dir.c_str(), filename);
 #else
-    //TODO implement
+    const char* const home = getenv("HOME");
+    if (home == nullptr) return;
+    const std::string dir(home);
 #endif
+    const char filename[] = "snapshot.png";
+    this->ExportPNGAsync(dir.c_str(), filename, snapshot_callback_);
 }
 
 template<typename T>
@@ -1645,15 +2734,43 @@ void Canvas<T>::ToggleGraphVisibility(const int iGraph) const
 }
 
 template<typename T>
-void Canvas<T>::ExportPNG(const char* const dir, const char* const filename) const
+void Canvas<T>::ExportPNG(const char* const dir, const char* const filename)
 {
-    unsigned char* const data = new unsigned char[_window_h * _window_w * 3];
-    if (!data) return;
-    glReadPixels(0, 0, _window_w, _window_h, GL_RGB, GL_UNSIGNED_BYTE, data);
-    const std::string path = std::string(dir) + std::string("\\") + std::string(filename);
-    stbi_flip_vertically_on_write(1);
-    stbi_write_png(path.c_str(), _window_w, _window_h, 3, data, _window_w * 3 * sizeof(unsigned char));
-    delete[] data;
+    const std::string path = std::string(dir) + std::string("/") + std::string(filename);
+    if (_window == nullptr) {
+        this->DrawOffscreen();
+    }
+    png_exporter_.Read((_window == nullptr) ? _fboID_resolve : 0u, _window_w, _window_h, path);
+    glBindFramebuffer(GL_FRAMEBUFFER, _fboID_target);
+    png_exporter_.Finish();
+}
+
+template<typename T>
+void Canvas<T>::ExportPNGAsync(const char* const dir, const char* const filename,
+    const PngExporter::Callback& callback)
+{
+    const std::string path = std::string(dir) + std::string("/") + std::string(filename);
+    if (_window == nullptr) {
+        this->DrawOffscreen();
+        png_exporter_.Read(_fboID_resolve, _window_w, _window_h, path, callback);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fboID_target);
+    } else {
+        pending_exports_.emplace_back(path, callback);
+        this->RequestFrame();
+    }
+}
+
+template<typename T>
+void Canvas<T>::DrawOffscreen(void)
+{
+    // Nothing has been drawn yet, the multisampled frame is resolved into a readable one
+    this->MakeContextCurrent();
+    this->Clear();
+    this->Draw();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fboID_target);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fboID_resolve);
+    glBlitFramebuffer(0, 0, _window_w, _window_h, 0, 0, _window_w, _window_h,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
 }
 
 template<typename T>
@@ -1678,11 +2795,11 @@ void Canvas<T>::UpdateMatricesReshape(void)
         ax,   ay,   0.0f, 1.0f);
 
     // Double precision matrix
-    //_screen_to_viewport_hp.Set(
-    //    1.0, 0.0, 0.0, 0.0,
-    //    0.0, 1.0, 0.0, 0.0,
-    //    0.0, 0.0, 1.0, 0.0,
-    //    -(double)margin_xl_pix_, -(double)margin_yb_pix_, 0.0, 1.0);
+    _screen_to_viewport_hp.Set(
+        1.0, 0.0, 0.0, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        -(double)margin_xl_pix_, -(double)margin_yb_pix_, 0.0, 1.0);
 
     const double vw = (double)(_window_w - (margin_xl_pix_ + margin_xr_pix_));
     const double vh = (double)(_window_h - (margin_yb_pix_ + margin_yt_pix_));
@@ -1704,11 +2821,11 @@ void Canvas<T>::UpdateMatricesReshape(void)
         hvw,  hvh,  0.0f, 1.0f);
 
     // Double precision matrix
-    //_viewport_to_clip_hp.Set(
-    //    2.0 / vw, 0.0,      0.0, 0.0,
-    //     0.0,     2.0 / vh, 0.0, 0.0,
-    //     0.0,     0.0,      1.0, 0.0,
-    //    -1.0,    -1.0,      0.0, 1.0);
+    _viewport_to_clip_hp.Set(
+        2.0 / vw, 0.0,      0.0, 0.0,
+         0.0,     2.0 / vh, 0.0, 0.0,
+         0.0,     0.0,      1.0, 0.0,
+        -1.0,    -1.0,      0.0, 1.0);
 
     // hww - half window width, hwh - -"- height
     const float hww = (float)(0.5 * (double)_window_w);
@@ -1738,8 +2855,11 @@ void Canvas<T>::UpdateMatricesReshape(void)
     prog_onscr_q_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
     prog_w_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
     prog_onscr_w_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
-    prog_m_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
+    prog_gr_w_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
+    prog_gr_m_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
     prog_c_.CommitCamera1(_screen_to_viewport, _viewport_to_clip, _screen_to_clip);
+
+    axes_values_valid_ = false;
 }
 
 template<typename T>
@@ -1749,42 +2869,37 @@ void Canvas<T>::UpdateMatricesPanZoom(void)
     glfwMakeContextCurrent(_window);
 #endif
 
-    const float hdx     = (float)(0.5 * _visible_range.dx());
-    const float hdy     = (float)(0.5 * _visible_range.dy());
-    const float xm      = (float)(_visible_range.xm());
-    const float ym      = (float)(_visible_range.ym());
+    // There is no translation, everything drawn in the visible range is
+    // positioned relative to its center, which is subtracted in double.
     const float hdx_inv = (float)(2.0 / _visible_range.dx()); // 1/hdx
     const float hdy_inv = (float)(2.0 / _visible_range.dy()); // 1/hdy
-    const float tx      = (float)(-_visible_range.twoxm() / _visible_range.dx()); // -2*xm/dx
-    const float ty      = (float)(-_visible_range.twoym() / _visible_range.dy()); // -2*ym/dy
 
-    _clip_to_visrange.Set(
-        hdx,  0.0f, 0.0f, 0.0f,
-        0.0f, hdy,  0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f,
-        xm,   ym,   0.0f, 1.0f);
-    _visrange_to_clip.Set(
+    _visrange_to_clip_rtc.Set(
         hdx_inv, 0.0f,    0.0f, 0.0f,
         0.0f,    hdy_inv, 0.0f, 0.0f,
         0.0f,    0.0f,    1.0f, 0.0f,
-        tx,      ty,      0.0f, 1.0f);
+        0.0f,    0.0f,    0.0f, 1.0f);
 
     // Double precision matrix
-    //_clip_to_visrange_hp.Set(
-    //    0.5 * _visible_range.dx(), 0.0,                       0.0, 0.0,
-    //    0.0,                       0.5 * _visible_range.dy(), 0.0, 0.0,
-    //    0.0,                       0.0,                       1.0, 0.0,
-    //    _visible_range.xm(),       _visible_range.ym(),       0.0, 1.0);
+    _clip_to_visrange_hp.Set(
+        0.5 * _visible_range.dx(), 0.0,                       0.0, 0.0,
+        0.0,                       0.5 * _visible_range.dy(), 0.0, 0.0,
+        0.0,                       0.0,                       1.0, 0.0,
+        _visible_range.xm(),       _visible_range.ym(),       0.0, 1.0);
 
     // Double precision matrix
     //_screen_to_visrange_hp = clip_to_visrange_hp * _screen_to_clip_hp;
     
-    prog_sel_q_.CommitCamera2(_visrange_to_clip);
-    prog_onscr_q_.CommitCamera2(_visrange_to_clip);
-    prog_w_.CommitCamera2(_visrange_to_clip);
-    prog_onscr_w_.CommitCamera2(_visrange_to_clip);
-    prog_m_.CommitCamera2(_visrange_to_clip);
-    prog_c_.CommitCamera2(_visrange_to_clip);
+    prog_sel_q_.CommitCamera2(_visrange_to_clip_rtc);
+    prog_onscr_q_.CommitCamera2(_visrange_to_clip_rtc);
+    prog_w_.CommitCamera2(_visrange_to_clip_rtc);
+    prog_onscr_w_.CommitCamera2(_visrange_to_clip_rtc);
+    prog_c_.CommitCamera2(_visrange_to_clip_rtc);
+    // The graphs are positioned by the translations of their chunks
+    glProgramUniform2f(prog_gr_w_.GetProgId(), _scale_unif_gr_w, hdx_inv, hdy_inv);
+    glProgramUniform2f(prog_gr_m_.GetProgId(), _scale_unif_gr_m, hdx_inv, hdy_inv);
+    chunk_translations_valid_ = false;
+    axes_values_valid_ = false;
 }
 
 // ===============================================================================
@@ -1799,6 +2914,7 @@ void Canvas<T>::UpdateSizeLimits(void)
     const int min_h = margin_yb_pix_ + MINFRAMEHEIGHT + margin_yt_pix_;
     const int min_w2 = (MINWINWIDTH > min_w) ? MINWINWIDTH : min_w;
     const int min_h2 = (MINWINHEIGHT > min_h) ? MINWINHEIGHT : min_h;
+    if (_window == nullptr) return; // Offscreen canvases keep their size
     glfwSetWindowSizeLimits(_window, min_w2, min_h2,
         GLFW_DONT_CARE, GLFW_DONT_CARE);
 }
@@ -1812,8 +2928,10 @@ void Canvas<T>::FinalizeTextRenderer(void)
 #ifdef SET_CONTEXT
     glfwMakeContextCurrent(_window);
 #endif
-    int win_w; int win_h;
-    glfwGetWindowSize(_window, &win_w, &win_h);
+    int win_w = _window_w; int win_h = _window_h;
+    if (_window != nullptr) {
+        glfwGetWindowSize(_window, &win_w, &win_h);
+    }
     text_rend_.FirstReshape(win_w, win_h);
 }
 //+++++++++++++++++++++++++++++++++++++++++++++
@@ -1,5 +1,7 @@
 #include "canvas_manager.h"
 
+#include <algorithm>
+
 #include "glew_routines.h"
 #include "glfw_callback_functions.h"
 
@@ -7,27 +9,36 @@ namespace tiny_graph_plot
 {
 
 template<typename T>
-CanvasManager<T>::CanvasManager(void) {
+CanvasManager<T>::CanvasManager(GraphManager<T>* const p_graph_manager)
+:   graph_manager_(p_graph_manager) {
+    // GLFW is initialized with the first window, the offscreen canvases work without a display
     glfwSetErrorCallback(tiny_graph_plot::glfw_callback_functions::error_callback_glfw);
-    if (!glfwInit()) {
-        fprintf(stderr, "GLFW: error: failed to initialize.\n\nAborting.\n");
-        exit(EXIT_FAILURE);
-    }
 }
 
 template<typename T>
 CanvasManager<T>::~CanvasManager(void) {
     for (auto* canv : canvases_) {
+        canv->MakeContextCurrent();
         delete canv;
     }
     canvases_.clear();
-    glfwTerminate();
+    offscreen_context_.Destroy();
+    if (glfw_initialized_) {
+        glfwTerminate();
+    }
 }
 
 template<typename T>
 Canvas<T>& CanvasManager<T>::CreateCanvas(const char* name,
     const unsigned int w, const unsigned int h,
     const unsigned int x, const unsigned int y) {
+    if (!glfw_initialized_) {
+        if (!glfwInit()) {
+            fprintf(stderr, "GLFW: error: failed to initialize.\n\nAborting.\n");
+            exit(EXIT_FAILURE);
+        }
+        glfw_initialized_ = true;
+    }
     glfwWindowHint(GLFW_SAMPLES, 4);
     GLFWwindow* window = glfwCreateWindow(w, h, name, NULL, NULL);
     if (!window) {
@@ -37,6 +48,7 @@ Canvas<T>& CanvasManager<T>::CreateCanvas(const char* name,
     }
     glfwSetWindowPos(window, x, y);
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(1); // One frame per vertical blank, see UserWindow::SetSwapInterval()
 
     if (!glew_initialized_) {
         tiny_graph_plot::init_glew();
@@ -50,13 +62,112 @@ Canvas<T>& CanvasManager<T>::CreateCanvas(const char* name,
     return *new_canv;
 }
 
+template<typename T>
+Canvas<T>& CanvasManager<T>::CreateOffscreenCanvas(const unsigned int w, const unsigned int h) {
+    if (!offscreen_context_.IsValid() && !offscreen_context_.Create()) {
+        fprintf(stderr, "ERROR: failed to create an offscreen OpenGL context.\n\nAborting.\n");
+        exit(EXIT_FAILURE);
+    }
+    offscreen_context_.MakeCurrent();
+
+    if (!glew_initialized_) {
+        tiny_graph_plot::init_glew(true);
+        glew_initialized_ = true;
+    }
+
+    Canvas<T>* new_canv = new Canvas<T>(nullptr, w, h, &offscreen_context_);
+    canvases_.push_back(new_canv);
+    return *new_canv;
+}
+
+template<typename T>
+Canvas<T>* CanvasManager<T>::GetFirstWindowCanvas(void) const {
+    for (auto* canv : canvases_) {
+        if (canv->GetWindow() != nullptr) return canv;
+    }
+    return nullptr;
+}
+
 template<typename T>
 void CanvasManager<T>::WaitForTheWindowsToClose(void) {
-    if (canvases_.size() < 1) return;
-    GLFWwindow* const first_window = canvases_.at(0)->GetWindow();
+    const Canvas<T>* const first_canv = this->GetFirstWindowCanvas();
+    if (first_canv == nullptr) return;
+    GLFWwindow* const first_window = first_canv->GetWindow();
     while (!glfwWindowShouldClose(first_window)) {
-        glfwWaitEvents();
+        const bool queues = this->SyncGraphQueues();
+        double timeout = this->RenderFrames();
+        // While exports are in flight the loop wakes up to pass them to the encoder
+        if (this->PollExports() && (timeout < 0.0 || timeout > 0.01)) {
+            timeout = 0.01;
+        }
+        if (queues && (timeout < 0.0 || timeout > queue_poll_period_)) {
+            timeout = queue_poll_period_;
+        }
+        if (timeout < 0.0) {
+            glfwWaitEvents();
+        } else {
+            glfwWaitEventsTimeout(std::max(timeout, 1.0e-4));
+        }
+    }
+}
+
+template<typename T>
+bool CanvasManager<T>::PollEvents(void) {
+    this->PollExports();
+    const Canvas<T>* const first_canv = this->GetFirstWindowCanvas();
+    if (first_canv == nullptr) return false;
+    glfwPollEvents();
+    this->SyncGraphQueues();
+    this->RenderFrames();
+    return !glfwWindowShouldClose(first_canv->GetWindow());
+}
+
+template<typename T>
+double CanvasManager<T>::RenderFrames(void) {
+    const double now = glfwGetTime();
+    double next = -1.0;
+    for (auto* canv : canvases_) {
+        if (canv->RenderFrameIfDue(now)) continue;
+        const double wait = canv->GetTimeToNextFrame(now);
+        if (wait >= 0.0 && (next < 0.0 || wait < next)) {
+            next = wait;
+        }
+    }
+    return next;
+}
+
+template<typename T>
+bool CanvasManager<T>::SyncGraphQueues(void) {
+    // Once for all canvases, each one sees the new points of its graphs
+    const bool queues = (graph_manager_ != nullptr && graph_manager_->DrainQueues());
+    for (auto* canv : canvases_) {
+        // The offscreen canvases are only rendered on export
+        if (canv->GetWindow() == nullptr) continue;
+        if (canv->GraphsChanged()) {
+            canv->RequestFrame();
+        }
+    }
+    return queues;
+}
+
+template<typename T>
+bool CanvasManager<T>::PollExports(void) {
+    bool polled = false;
+    bool pending = false;
+    for (auto* canv : canvases_) {
+        if (canv->png_exporter_.HasPendingReads()) {
+            canv->MakeContextCurrent();
+            canv->png_exporter_.Poll();
+            polled = true;
+            pending = pending || canv->png_exporter_.HasPendingReads();
+        }
+    }
+    // The event callbacks draw the windows without switching the context
+    const Canvas<T>* const first_canv = this->GetFirstWindowCanvas();
+    if (polled && first_canv != nullptr) {
+        first_canv->MakeContextCurrent();
     }
+    return pending;
 }
 
 template class CanvasManager<float>;
@@ -0,0 +1,120 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+
+#include "GL/glew.h"
+
+namespace tiny_graph_plot
+{
+
+void FrameProfiler::Samples::Push(const double p_value) noexcept
+{
+    values_[next_] = p_value;
+    next_ = (next_ + 1u) % n_samples_;
+    n_ = std::min(n_ + 1u, n_samples_);
+}
+
+void FrameProfiler::Samples::GetPercentiles(double& o_p50, double& o_p99) const
+{
+    o_p50 = 0.0;
+    o_p99 = 0.0;
+    if (n_ == 0u) return;
+    double sorted[n_samples_];
+    std::copy(values_, values_ + n_, sorted);
+    // Nearest rank
+    const size_t i50 = (n_ - 1u) / 2u;
+    const size_t i99 = (n_ - 1u) * 99u / 100u;
+    std::nth_element(sorted, sorted + i99, sorted + n_);
+    o_p99 = sorted[i99];
+    std::nth_element(sorted, sorted + i50, sorted + i99);
+    o_p50 = sorted[i50];
+}
+
+void FrameProfiler::Init(void)
+{
+    if (queries_[0][0][0] != 0u) return;
+    glGenQueries((GLsizei)(n_sets_ * n_passes_ * 2u), &queries_[0][0][0]);
+}
+
+void FrameProfiler::Release(void)
+{
+    if (queries_[0][0][0] == 0u) return;
+    glDeleteQueries((GLsizei)(n_sets_ * n_passes_ * 2u), &queries_[0][0][0]);
+    for (size_t s = 0u; s < n_sets_; s++) {
+        for (size_t p = 0u; p < n_passes_; p++) {
+            queries_[s][p][0] = queries_[s][p][1] = 0u;
+            issued_[s][p] = false;
+        }
+    }
+}
+
+void FrameProfiler::BeginFrame(void)
+{
+    n_frames_++;
+    set_ = (set_ + 1u) % n_sets_;
+    for (size_t p = 0u; p < n_passes_; p++) {
+        if (!issued_[set_][p]) continue;
+        issued_[set_][p] = false;
+        GLint available = 0;
+        glGetQueryObjectiv(queries_[set_][p][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) continue; // Dropped rather than waited for
+        GLuint64 t0 = 0u;
+        GLuint64 t1 = 0u;
+        glGetQueryObjectui64v(queries_[set_][p][0], GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(queries_[set_][p][1], GL_QUERY_RESULT, &t1);
+        gpu_[p].Push((t1 > t0) ? (double)(t1 - t0) * 1.0e-6 : 0.0);
+    }
+}
+
+void FrameProfiler::Begin(const frame_pass_t p_pass)
+{
+    const size_t p = (size_t)p_pass;
+    if (queries_[set_][p][0] != 0u) {
+        glQueryCounter(queries_[set_][p][0], GL_TIMESTAMP);
+    }
+    cpu_start_[p] = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::End(const frame_pass_t p_pass)
+{
+    const size_t p = (size_t)p_pass;
+    cpu_[p].Push(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - cpu_start_[p]).count());
+    if (queries_[set_][p][1] != 0u) {
+        glQueryCounter(queries_[set_][p][1], GL_TIMESTAMP);
+        issued_[set_][p] = true;
+    }
+}
+
+FrameStats FrameProfiler::GetStats(void) const
+{
+    FrameStats stats;
+    stats.n_frames_ = n_frames_;
+    for (size_t p = 0u; p < n_passes_; p++) {
+        PassStats& pass = stats.passes_[p];
+        pass.name_ = FrameProfiler::GetPassName((frame_pass_t)p);
+        pass.n_cpu_samples_ = (unsigned int)cpu_[p].n_;
+        pass.n_gpu_samples_ = (unsigned int)gpu_[p].n_;
+        cpu_[p].GetPercentiles(pass.cpu_p50_ms_, pass.cpu_p99_ms_);
+        gpu_[p].GetPercentiles(pass.gpu_p50_ms_, pass.gpu_p99_ms_);
+    }
+    return stats;
+}
+
+const char* FrameProfiler::GetPassName(const frame_pass_t p_pass) noexcept
+{
+    switch (p_pass) {
+    case frame_pass_t::FP_FRAME:        return "frame";
+    case frame_pass_t::FP_SYNC:         return "sync";
+    case frame_pass_t::FP_STATIC_LAYER: return "static layer";
+    case frame_pass_t::FP_GRID:         return "grid";
+    case frame_pass_t::FP_HISTOGRAMS2D: return "2D histograms";
+    case frame_pass_t::FP_GRAPHS:       return "graphs";
+    case frame_pass_t::FP_HISTOGRAMS:   return "histograms";
+    case frame_pass_t::FP_TEXT:         return "text";
+    case frame_pass_t::FP_CURSOR:       return "cursor";
+    default:                            return "";
+    }
+}
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,50 @@
+#include "tiny_gl_text_renderer/glyph_atlas.h"
+
+#include "tiny_gl_text_renderer/font_table.h"
+
+namespace tiny_gl_text_renderer
+{
+
+// The printable characters of set1 in font_table.h
+constexpr char first_glyph = '%';
+constexpr char last_glyph = 'z';
+
+/*static*/
+const GlyphAtlas& GlyphAtlas::Get(void)
+{
+    static const GlyphAtlas atlas;
+    return atlas;
+}
+
+GlyphAtlas::GlyphAtlas(void)
+{
+    constexpr int n_glyphs = last_glyph - first_glyph + 1;
+    constexpr int n_rows = (n_glyphs + n_columns_ - 1) / n_columns_;
+    w_ = n_columns_ * cell_w_;
+    h_ = n_rows * cell_h_;
+    data_.assign((size_t)w_ * (size_t)h_, 0u);
+    for (int ch = first_glyph; ch <= last_glyph; ch++) {
+        int x0, y0;
+        GlyphAtlas::GetGlyph((char)ch, x0, y0);
+        const unsigned short int* const lut = GetLUT((char)ch);
+        for (int yl = 0; yl < CHAR_HEIGHT; yl++) {
+            const unsigned short int sublut = lut[yl + OFFSET];
+            unsigned char* const row = &data_[(size_t)(y0 + yl) * (size_t)w_ + (size_t)x0];
+            for (int xl = 0; xl < CHAR_WIDTH; xl++) {
+                row[xl] = ((sublut >> (CHAR_WIDTH - 1 - xl)) & 0x1) ? 255u : 0u;
+            }
+        }
+    }
+}
+
+/*static*/
+bool GlyphAtlas::GetGlyph(const char p_character, int& o_x, int& o_y) noexcept
+{
+    if (p_character < first_glyph || p_character > last_glyph) return false;
+    const int i_glyph = p_character - first_glyph;
+    o_x = (i_glyph % n_columns_) * cell_w_ + 1;
+    o_y = (i_glyph / n_columns_) * cell_h_ + 1;
+    return true;
+}
+
+} // end of namespace tiny_gl_text_renderer
@@ -0,0 +1,121 @@
+#include "mapped_file.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tiny_graph_plot
+{
+
+MappedFile::~MappedFile()
+{
+    this->Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* const p_path)
+{
+    this->Close();
+    HANDLE file = CreateFileA(p_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "ERROR: failed to open '%s'.\n", p_path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        fprintf(stderr, "ERROR: '%s' is empty or its size is unknown.\n", p_path);
+        CloseHandle(file);
+        return false;
+    }
+    // Copy-on-write access keeps the writes private
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    void* const data = (mapping != NULL) ?
+        MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+    if (data == nullptr) {
+        fprintf(stderr, "ERROR: failed to map '%s' into memory.\n", p_path);
+        if (mapping != NULL) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = data;
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr) UnmapViewOfFile(data_);
+    if (mapping_ != nullptr) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_ != nullptr) CloseHandle(static_cast<HANDLE>(file_));
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0u;
+}
+
+// The file is opened for sequential scan, Windows has no per-range hints
+void MappedFile::AdviseSequential() const {}
+void MappedFile::AdviseNormal() const {}
+
+#else
+
+bool MappedFile::Open(const char* const p_path)
+{
+    this->Close();
+    const int fd = open(p_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: failed to open '%s'.\n", p_path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "ERROR: '%s' is empty or its size is unknown.\n", p_path);
+        close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    // Copy-on-write access keeps the writes private
+    void* const data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "ERROR: failed to map '%s' into memory.\n", p_path);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr) munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0u;
+}
+
+void MappedFile::AdviseSequential() const
+{
+    if (data_ != nullptr) madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+void MappedFile::AdviseNormal() const
+{
+    if (data_ != nullptr) madvise(data_, size_, MADV_NORMAL);
+}
+
+#endif
+
+} // end of namespace tiny_graph_plot
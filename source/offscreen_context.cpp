@@ -0,0 +1,179 @@
+#include "offscreen_context.h"
+
+#include <cstdio>
+
+#if defined(TINY_GRAPH_PLOT_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#elif defined(TINY_GRAPH_PLOT_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+namespace tiny_graph_plot
+{
+
+#if defined(TINY_GRAPH_PLOT_EGL)
+
+bool OffscreenContext::Create(void)
+{
+    if (context_ != nullptr) return true;
+
+    // The surfaceless platform needs neither a window system nor a GPU,
+    // the default display is taken if the platform is not supported
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display != nullptr) {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            fprintf(stderr, "ERROR: EGL: failed to initialize a display.\n");
+            return false;
+        }
+    }
+    display_ = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "ERROR: EGL: desktop OpenGL is not supported.\n");
+        this->Destroy();
+        return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint n_configs = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &n_configs) || n_configs < 1) {
+        fprintf(stderr, "ERROR: EGL: no suitable framebuffer configuration.\n");
+        this->Destroy();
+        return false;
+    }
+
+    // Version of the shaders, the compatibility profile for the quads and the line stipple
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 0,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "ERROR: EGL: failed to create an OpenGL 4.0 context.\n");
+        this->Destroy();
+        return false;
+    }
+    context_ = context;
+
+    // Without EGL_KHR_surfaceless_context a small pbuffer is needed to make the context current
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        EGLSurface surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+        if (surface == EGL_NO_SURFACE) {
+            fprintf(stderr, "ERROR: EGL: failed to create a pbuffer surface.\n");
+            this->Destroy();
+            return false;
+        }
+        surface_ = surface;
+    }
+    return this->MakeCurrent();
+}
+
+void OffscreenContext::Destroy(void)
+{
+    if (display_ == nullptr) return;
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface_ != nullptr) eglDestroySurface(display_, surface_);
+    if (context_ != nullptr) eglDestroyContext(display_, context_);
+    eglTerminate(display_);
+    surface_ = nullptr;
+    context_ = nullptr;
+    display_ = nullptr;
+}
+
+bool OffscreenContext::MakeCurrent(void) const
+{
+    if (context_ == nullptr) return false;
+    const EGLSurface surface = (surface_ != nullptr) ? surface_ : EGL_NO_SURFACE;
+    if (!eglMakeCurrent(display_, surface, surface, context_)) {
+        fprintf(stderr, "ERROR: EGL: failed to make the context current.\n");
+        return false;
+    }
+    return true;
+}
+
+#elif defined(TINY_GRAPH_PLOT_OSMESA)
+
+bool OffscreenContext::Create(void)
+{
+    if (context_ != nullptr) return true;
+
+    // Version of the shaders, the compatibility profile for the quads and the line stipple
+    const int attribs[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 0,
+        OSMESA_STENCIL_BITS, 0,
+        OSMESA_ACCUM_BITS, 0,
+        OSMESA_PROFILE, OSMESA_COMPAT_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 4,
+        OSMESA_CONTEXT_MINOR_VERSION, 0,
+        0
+    };
+    const OSMesaContext context = OSMesaCreateContextAttribs(attribs, nullptr);
+    if (context == nullptr) {
+        fprintf(stderr, "ERROR: OSMesa: failed to create an OpenGL 4.0 context.\n");
+        return false;
+    }
+    context_ = context;
+    buffer_.assign(4u, 0u); // 1x1 RGBA
+    return this->MakeCurrent();
+}
+
+void OffscreenContext::Destroy(void)
+{
+    if (context_ == nullptr) return;
+    OSMesaDestroyContext(static_cast<OSMesaContext>(context_));
+    context_ = nullptr;
+    buffer_.clear();
+}
+
+bool OffscreenContext::MakeCurrent(void) const
+{
+    if (context_ == nullptr) return false;
+    if (!OSMesaMakeCurrent(static_cast<OSMesaContext>(context_),
+            const_cast<unsigned char*>(buffer_.data()), GL_UNSIGNED_BYTE, 1, 1)) {
+        fprintf(stderr, "ERROR: OSMesa: failed to make the context current.\n");
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool OffscreenContext::Create(void)
+{
+    fprintf(stderr, "ERROR: offscreen rendering is not available, "
+        "build with TINY_GRAPH_PLOT_OFFSCREEN set to EGL or OSMESA.\n");
+    return false;
+}
+
+void OffscreenContext::Destroy(void)
+{
+}
+
+bool OffscreenContext::MakeCurrent(void) const
+{
+    return false;
+}
+
+#endif
+
+} // end of namespace tiny_graph_plot
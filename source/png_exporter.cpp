@@ -0,0 +1,193 @@
+#include "png_exporter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "GL/glew.h"
+#include "stb_image_write.h"
+
+namespace tiny_graph_plot
+{
+
+PngExporter::~PngExporter(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_jobs_.notify_all();
+    if (encoder_.joinable()) {
+        encoder_.join();
+    }
+}
+
+void PngExporter::Read(const GLuint p_fbo, const int p_w, const int p_h,
+    const std::string& p_path, const Callback& p_callback)
+{
+    if (p_w <= 0 || p_h <= 0) {
+        fprintf(stderr, "ERROR: the framebuffer is empty, nothing to write into %s.\n", p_path.c_str());
+        return;
+    }
+    if (!encoder_.joinable()) {
+        encoder_ = std::thread(&PngExporter::EncoderLoop, this);
+    }
+
+    Slot& slot = slots_[next_];
+    if (slot.fence_ != nullptr) {
+        this->CompleteSlot(slot, true);
+    }
+    next_ = (next_ + 1u) % n_slots_;
+
+    if (slot.pbo_ == 0u) {
+        glGenBuffers(1, &slot.pbo_);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo_);
+        glObjectLabel(GL_BUFFER, slot.pbo_, -1, "png_export_pbo");
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo_);
+    }
+    const size_t size = (size_t)p_w * (size_t)p_h * 4u;
+    if (slot.capacity_ < size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_READ);
+        slot.capacity_ = size;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, p_fbo);
+    glReadBuffer((p_fbo == 0u) ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // With a pack buffer bound the pointer is an offset into it, the call returns immediately
+    glReadPixels(0, 0, p_w, p_h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // So that the fence is signaled even if nothing else is submitted
+
+    slot.w_ = p_w;
+    slot.h_ = p_h;
+    slot.path_ = p_path;
+    slot.callback_ = p_callback;
+}
+
+void PngExporter::Poll(const bool p_wait)
+{
+    // Oldest first, the fences are signaled in the order of the reads
+    for (size_t i = 0u; i < n_slots_; i++) {
+        Slot& slot = slots_[(next_ + i) % n_slots_];
+        if (slot.fence_ == nullptr) continue;
+        if (!this->CompleteSlot(slot, p_wait)) break;
+    }
+}
+
+void PngExporter::Finish(void)
+{
+    this->Poll(true);
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() { return n_encoding_ == 0u; });
+}
+
+bool PngExporter::HasPendingReads(void) const noexcept
+{
+    for (const Slot& slot : slots_) {
+        if (slot.fence_ != nullptr) return true;
+    }
+    return false;
+}
+
+void PngExporter::Release(void)
+{
+    for (Slot& slot : slots_) {
+        if (slot.fence_ != nullptr) {
+            glDeleteSync(slot.fence_);
+            slot.fence_ = nullptr;
+        }
+        if (slot.pbo_ != 0u) {
+            glDeleteBuffers(1, &slot.pbo_);
+            slot.pbo_ = 0u;
+        }
+        slot.capacity_ = 0u;
+    }
+}
+
+bool PngExporter::CompleteSlot(Slot& p_slot, const bool p_wait)
+{
+    const GLuint64 timeout = p_wait ? GL_TIMEOUT_IGNORED : 0u;
+    const GLenum res = glClientWaitSync(p_slot.fence_, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (res == GL_TIMEOUT_EXPIRED) return false;
+    glDeleteSync(p_slot.fence_);
+    p_slot.fence_ = nullptr;
+
+    Job job;
+    job.w_ = p_slot.w_;
+    job.h_ = p_slot.h_;
+    job.path_ = std::move(p_slot.path_);
+    job.callback_ = std::move(p_slot.callback_);
+    p_slot.path_.clear();
+    p_slot.callback_ = nullptr;
+    if (res == GL_WAIT_FAILED) {
+        fprintf(stderr, "ERROR: failed to wait for the pixels of %s.\n", job.path_.c_str());
+    } else {
+        const size_t size = (size_t)job.w_ * (size_t)job.h_ * 4u;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, p_slot.pbo_);
+        const void* const data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+        if (data != nullptr) {
+            job.rgba_.resize(size);
+            memcpy(job.rgba_.data(), data, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            fprintf(stderr, "ERROR: failed to map the pixels of %s.\n", job.path_.c_str());
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Failed jobs still go to the encoder, so that the callback is called on the same thread
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+        n_encoding_++;
+    }
+    cv_jobs_.notify_one();
+    return true;
+}
+
+void PngExporter::EncoderLoop(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_jobs_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) return; // Stopped and drained
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        const bool ok = !job.rgba_.empty() && Encode(job);
+        if (job.callback_) {
+            job.callback_(job.path_, ok);
+        }
+        lock.lock();
+        n_encoding_--;
+        cv_done_.notify_all();
+    }
+}
+
+bool PngExporter::Encode(const Job& p_job)
+{
+    // Top row first and without alpha. The rows are flipped here rather than with
+    // stbi_flip_vertically_on_write(), which is a global flag shared by all threads.
+    const size_t w = (size_t)p_job.w_;
+    const size_t h = (size_t)p_job.h_;
+    std::vector<unsigned char> rgb(w * h * 3u);
+    for (size_t y = 0u; y < h; y++) {
+        const unsigned char* src = p_job.rgba_.data() + (h - 1u - y) * w * 4u;
+        unsigned char* dst = rgb.data() + y * w * 3u;
+        for (size_t x = 0u; x < w; x++, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+    if (stbi_write_png(p_job.path_.c_str(), p_job.w_, p_job.h_, 3, rgb.data(), p_job.w_ * 3) == 0) {
+        fprintf(stderr, "ERROR: failed to write %s.\n", p_job.path_.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // end of namespace tiny_graph_plot
@@ -0,0 +1,252 @@
+#include "raster_image.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "stb_image_write.h"
+
+#include "tiny_gl_text_renderer/label.h" // Font table and the glyph size
+#include "simd_span.h"
+
+namespace tiny_graph_plot
+{
+
+RasterImage::ClipRect RasterImage::ClipRect::Intersect(const ClipRect& other) const noexcept
+{
+    ClipRect res;
+    res.x0 = std::max(x0, other.x0);
+    res.y0 = std::max(y0, other.y0);
+    res.x1 = std::min(x1, other.x1);
+    res.y1 = std::min(y1, other.y1);
+    return res;
+}
+
+void RasterImage::Resize(const int p_w, const int p_h)
+{
+    w_ = std::max(p_w, 0);
+    h_ = std::max(p_h, 0);
+    pixels_.resize((size_t)w_ * (size_t)h_);
+}
+
+RasterImage::ClipRect RasterImage::GetFullRect(void) const noexcept
+{
+    ClipRect res;
+    res.x1 = w_;
+    res.y1 = h_;
+    return res;
+}
+
+RasterImage::Paint RasterImage::MakePaint(const color_t& p_color) noexcept
+{
+    const auto to_byte = [](const float c) {
+        return (uint32_t)std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+    };
+    Paint res;
+    res.rgba = to_byte(p_color[0]) | (to_byte(p_color[1]) << 8) |
+               (to_byte(p_color[2]) << 16) | 0xFF000000u;
+    res.a = (uint32_t)std::lround(std::min(std::max(p_color[3], 0.0f), 1.0f) * 256.0f);
+    return res;
+}
+
+uint32_t RasterImage::PackRGBA(const unsigned char* const p_rgba) noexcept
+{
+    return (uint32_t)p_rgba[0] | ((uint32_t)p_rgba[1] << 8) |
+           ((uint32_t)p_rgba[2] << 16) | ((uint32_t)p_rgba[3] << 24);
+}
+
+bool RasterImage::WritePNG(const char* const p_path) const
+{
+    if (w_ == 0 || h_ == 0) {
+        fprintf(stderr, "ERROR: the image is empty, nothing to write into %s.\n", p_path);
+        return false;
+    }
+    if (stbi_write_png(p_path, w_, h_, 4, pixels_.data(), 4 * w_) == 0) {
+        fprintf(stderr, "ERROR: failed to write %s.\n", p_path);
+        return false;
+    }
+    return true;
+}
+
+void RasterImage::FillRect(const int p_x0, const int p_y0, const int p_x1, const int p_y1,
+    const Paint& p_paint, const ClipRect& p_clip)
+{
+    ClipRect rect;
+    rect.x0 = p_x0; rect.y0 = p_y0; rect.x1 = p_x1; rect.y1 = p_y1;
+    rect = rect.Intersect(p_clip).Intersect(this->GetFullRect());
+    if (rect.IsEmpty()) return;
+    for (int y = rect.y0; y < rect.y1; y++) {
+        BlendSpan(this->GetRow(y) + rect.x0, (size_t)(rect.x1 - rect.x0), p_paint.rgba, p_paint.a);
+    }
+}
+
+void RasterImage::DrawLine(float p_x0, float p_y0, float p_x1, float p_y1, const float p_width,
+    const Paint& p_paint, const ClipRect& p_clip)
+{
+    if (!std::isfinite(p_x0) || !std::isfinite(p_y0) ||
+        !std::isfinite(p_x1) || !std::isfinite(p_y1)) return;
+    const ClipRect clip = p_clip.Intersect(this->GetFullRect());
+    if (clip.IsEmpty()) return;
+
+    // u is the major axis of the line, v the minor one
+    const bool steep = std::fabs(p_y1 - p_y0) > std::fabs(p_x1 - p_x0);
+    if (steep) {
+        std::swap(p_x0, p_y0);
+        std::swap(p_x1, p_y1);
+    }
+    if (p_x0 > p_x1) {
+        std::swap(p_x0, p_x1);
+        std::swap(p_y0, p_y1);
+    }
+    const float u0 = p_x0;
+    const float v0 = p_y0;
+    const float du = p_x1 - p_x0;
+    const float g = (du > 0.0f) ? (p_y1 - p_y0) / du : 0.0f;
+    // Half of the extent of the line along v, thinner lines are drawn fainter
+    const float h = 0.5f * std::max(p_width, 1.0f) * std::sqrt(1.0f + g * g);
+    const uint32_t a = (p_width < 1.0f) ?
+        (uint32_t)((float)p_paint.a * std::max(p_width, 0.0f)) : p_paint.a;
+    if (a == 0u) return;
+    const int u_lo = steep ? clip.y0 : clip.x0;
+    const int u_hi = steep ? clip.y1 : clip.x1;
+    const int v_lo = steep ? clip.x0 : clip.y0;
+    const int v_hi = steep ? clip.x1 : clip.y1;
+
+    // The pixels with the center in [u0; u1) whose span reaches the clip rectangle
+    float fi0 = std::ceil(u0 - 0.5f);
+    float fi1 = std::ceil(p_x1 - 0.5f);
+    if (g != 0.0f) {
+        const float ua = ((float)v_lo - h - v0) / g + u0 - 0.5f;
+        const float ub = ((float)v_hi + h - v0) / g + u0 - 0.5f;
+        fi0 = std::max(fi0, std::floor(std::min(ua, ub)));
+        fi1 = std::min(fi1, std::ceil(std::max(ua, ub)) + 1.0f);
+    } else if (v0 + h < (float)v_lo || v0 - h > (float)v_hi) {
+        return;
+    }
+    fi0 = std::max(fi0, (float)u_lo);
+    fi1 = std::min(fi1, (float)u_hi);
+    if (!(fi0 < fi1)) return;
+    const int i0 = (int)fi0;
+    const int i1 = (int)fi1;
+
+    const size_t stride_u = steep ? (size_t)w_ : 1u;
+    const size_t stride_v = steep ? 1u : (size_t)w_;
+    for (int i = i0; i < i1; i++) {
+        const float vc = v0 + g * ((float)i + 0.5f - u0);
+        const float top = vc - h;
+        const float bot = vc + h;
+        const int j0 = std::max((int)std::floor(top), v_lo);
+        const int j1 = std::min((int)std::ceil(bot), v_hi);
+        if (j0 >= j1) continue;
+        uint32_t* const base = pixels_.data() + (size_t)i * stride_u;
+        const auto blend_edge = [&](const int j) {
+            const float cov = std::min(bot, (float)(j + 1)) - std::max(top, (float)j);
+            uint32_t* const p = base + (size_t)j * stride_v;
+            *p = BlendPixel(*p, p_paint.rgba, (uint32_t)((float)a * cov + 0.5f));
+        };
+        blend_edge(j0);
+        if (j1 - j0 > 1) {
+            if (steep) {
+                BlendSpan(base + j0 + 1, (size_t)(j1 - j0 - 2), p_paint.rgba, a);
+            } else {
+                for (int j = j0 + 1; j < j1 - 1; j++) {
+                    uint32_t* const p = base + (size_t)j * stride_v;
+                    *p = BlendPixel(*p, p_paint.rgba, a);
+                }
+            }
+            blend_edge(j1 - 1);
+        }
+    }
+}
+
+void RasterImage::DrawMarker(const float p_x, const float p_y, const float p_size,
+    const Paint& p_paint, const ClipRect& p_clip)
+{
+    if (!std::isfinite(p_x) || !std::isfinite(p_y)) return;
+    const float hs = 0.5f * p_size;
+    const ClipRect clip = p_clip.Intersect(this->GetFullRect());
+    const auto to_pix = [](const float c, const int lo, const int hi) {
+        return (int)std::min(std::max(std::ceil(c - 0.5f), (float)lo), (float)hi);
+    };
+    this->FillRect(to_pix(p_x - hs, clip.x0, clip.x1), to_pix(p_y - hs, clip.y0, clip.y1),
+                   to_pix(p_x + hs, clip.x0, clip.x1), to_pix(p_y + hs, clip.y0, clip.y1),
+                   p_paint, clip);
+}
+
+void RasterImage::DrawText(const char* const p_text, const float p_x, const float p_y,
+    const float p_scale, const float p_angle, const Paint& p_paint, const ClipRect& p_clip)
+{
+    using tiny_gl_text_renderer::CHAR_WIDTH;
+    using tiny_gl_text_renderer::CHAR_HEIGHT;
+    using tiny_gl_text_renderer::OFFSET;
+
+    if (p_scale <= 0.0f) return;
+    // Lines of the text, the texture of a label would be tex_w x tex_h
+    std::vector<std::pair<const char*, int>> lines;
+    int max_len = 0;
+    for (const char* p = p_text; ; ) {
+        const char* const end = strchr(p, '\n');
+        const int len = (end != nullptr) ? (int)(end - p) : (int)strlen(p);
+        lines.emplace_back(p, len);
+        max_len = std::max(max_len, len);
+        if (end == nullptr) break;
+        p = end + 1;
+    }
+    const float tex_w = (float)(max_len * CHAR_WIDTH);
+    const float tex_h = (float)((int)lines.size() * CHAR_HEIGHT);
+    if (max_len == 0) return;
+
+    // Same transformation as Label::GetMatrix()
+    const float angle_rad = p_angle * 3.14159265358979f / 180.0f;
+    const float c = std::cos(angle_rad);
+    const float s = std::sin(angle_rad);
+    float bx0 = p_x, bx1 = p_x, by0 = p_y, by1 = p_y;
+    for (const float u : { 0.0f, tex_w }) {
+        for (const float v : { 0.0f, tex_h }) {
+            const float px = p_x + p_scale * (c * u + s * v);
+            const float py = p_y + p_scale * (-s * u + c * v);
+            bx0 = std::min(bx0, px); bx1 = std::max(bx1, px);
+            by0 = std::min(by0, py); by1 = std::max(by1, py);
+        }
+    }
+    ClipRect rect;
+    rect.x0 = (int)std::floor(std::max(bx0, -1.0f));
+    rect.y0 = (int)std::floor(std::max(by0, -1.0f));
+    rect.x1 = (int)std::ceil(std::min(bx1, (float)w_ + 1.0f));
+    rect.y1 = (int)std::ceil(std::min(by1, (float)h_ + 1.0f));
+    rect = rect.Intersect(p_clip).Intersect(this->GetFullRect());
+    if (rect.IsEmpty()) return;
+
+    constexpr int n_sub = 4;
+    const float k = 1.0f / p_scale;
+    for (int y = rect.y0; y < rect.y1; y++) {
+        uint32_t* const row = this->GetRow(y);
+        for (int x = rect.x0; x < rect.x1; x++) {
+            int hits = 0;
+            for (int sy = 0; sy < n_sub; sy++) {
+                const float dy = (float)y + ((float)sy + 0.5f) / (float)n_sub - p_y;
+                for (int sx = 0; sx < n_sub; sx++) {
+                    const float dx = (float)x + ((float)sx + 0.5f) / (float)n_sub - p_x;
+                    const float u = (c * dx - s * dy) * k;
+                    const float v = (s * dx + c * dy) * k;
+                    if (!(u >= 0.0f && v >= 0.0f && u < tex_w && v < tex_h)) continue;
+                    const int iu = (int)u;
+                    const int iv = (int)v;
+                    const std::pair<const char*, int>& line = lines[(size_t)(iv / CHAR_HEIGHT)];
+                    if (iu / CHAR_WIDTH >= line.second) continue;
+                    const unsigned short int* const lut =
+                        tiny_gl_text_renderer::GetLUT(line.first[iu / CHAR_WIDTH]);
+                    if (lut == nullptr) continue;
+                    hits += (lut[iv % CHAR_HEIGHT + OFFSET] >> (CHAR_WIDTH - 1 - iu % CHAR_WIDTH)) & 1;
+                }
+            }
+            if (hits > 0) {
+                row[x] = BlendPixel(row[x], p_paint.rgba, p_paint.a * (uint32_t)hits / (n_sub * n_sub));
+            }
+        }
+    }
+}
+
+} // end of namespace tiny_graph_plot
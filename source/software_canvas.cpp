@@ -0,0 +1,696 @@
+#include "software_canvas.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "tiny_gl_text_renderer/label.h" // The glyph size
+#include "colormap.h"
+#include "graph.h"
+#include "histogram1d.h"
+#include "histogram2d.h"
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+using Paint = RasterImage::Paint;
+using ClipRect = RasterImage::ClipRect;
+
+template<typename T>
+SoftwareCanvas<T>::SoftwareCanvas(const unsigned int w, const unsigned int h)
+{
+    image_.Resize((int)w, (int)h);
+    constexpr unsigned int n_colors = 256u;
+    const std::vector<unsigned char> colors = BuildViridisColormap(n_colors);
+    colormap_.resize(n_colors);
+    for (unsigned int i = 0u; i < n_colors; i++) {
+        colormap_[i] = RasterImage::PackRGBA(&colors[4u * i]);
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::AddGraph(const Graph<T>& p_graph)
+{
+    graphs_.push_back(&p_graph);
+}
+
+template<typename T>
+void SoftwareCanvas<T>::AddHistogram(const Histogram1d<T, unsigned long>& p_histo)
+{
+    histograms_.push_back(&p_histo);
+}
+
+template<typename T>
+void SoftwareCanvas<T>::AddHistogram2d(const Histogram2d<T, unsigned long>& p_histo)
+{
+    histograms2d_.push_back(&p_histo);
+}
+
+template<typename T>
+void SoftwareCanvas<T>::Draw(void)
+{
+    const int w = image_.GetWidth();
+    const int h = image_.GetHeight();
+    frame_.x0 = (int)margin_xl_pix_;
+    frame_.x1 = w - (int)margin_xr_pix_;
+    frame_.y0 = (int)margin_yt_pix_;
+    frame_.y1 = h - (int)margin_yb_pix_;
+
+    this->UpdateTotalRange();
+    visible_range_ = use_fixed_range_ ? fixed_range_ : total_xy_range_;
+    scale_x_ = (double)(frame_.x1 - frame_.x0) / visible_range_.dx();
+    scale_y_ = (double)(frame_.y1 - frame_.y0) / visible_range_.dy();
+
+    frame_rules_.clear();
+    window_rules_.clear();
+    labels_.clear();
+    n_layers_ = 0u;
+    if (!frame_.IsEmpty()) {
+        this->PrepareRules();
+        this->PrepareLayers();
+        this->PrepareLabels();
+    }
+
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const unsigned int n_bands = (unsigned int)((h + band_height_ - 1) / band_height_);
+    const auto band_rect = [&](const unsigned int i_band) {
+        ClipRect clip = image_.GetFullRect();
+        clip.y0 = (int)i_band * band_height_;
+        clip.y1 = std::min(clip.y0 + band_height_, h);
+        return clip;
+    };
+
+    // The density maps are normalized to their maximum, which is known after all the bands are counted
+    bool has_density = false;
+    for (size_t i = 0; i < n_layers_; i++) {
+        Layer& layer = layers_[i];
+        if (layer.kind_ != Layer::Kind::DENSITY) continue;
+        layer.band_max_.assign(n_bands, 0u);
+        this->BinByBand(layer, n_bands);
+        has_density = true;
+    }
+    if (has_density) {
+        pool.ParallelFor(n_bands, [&](const unsigned int i_band) {
+            const ClipRect clip = band_rect(i_band).Intersect(frame_);
+            for (size_t i = 0; i < n_layers_; i++) {
+                if (layers_[i].kind_ == Layer::Kind::DENSITY) {
+                    this->CountDensity(layers_[i], clip, i_band);
+                }
+            }
+        });
+        for (size_t i = 0; i < n_layers_; i++) {
+            Layer& layer = layers_[i];
+            if (layer.kind_ != Layer::Kind::DENSITY) continue;
+            layer.max_count_ = *std::max_element(layer.band_max_.begin(), layer.band_max_.end());
+        }
+    }
+
+    pool.ParallelFor(n_bands, [&](const unsigned int i_band) {
+        this->DrawBand(band_rect(i_band));
+    });
+}
+
+template<typename T>
+bool SoftwareCanvas<T>::ExportPNG(const char* const dir, const char* const filename)
+{
+    this->Draw();
+    const std::string path = std::string(dir) + std::string("/") + std::string(filename);
+    return image_.WritePNG(path.c_str());
+}
+
+template<typename T>
+void SoftwareCanvas<T>::UpdateTotalRange(void)
+{
+    bool first = true;
+    const auto include = [&](const auto& range) {
+        if (first) {
+            total_xy_range_ = range;
+            first = false;
+        } else {
+            total_xy_range_.Include(range);
+        }
+    };
+    for (const auto* const gr : graphs_) include(gr->GetXYrange());
+    for (const auto* const histo : histograms_) include(histo->GetXYrange());
+    for (const auto* const histo : histograms2d_) include(histo->GetXYrange());
+    if (first) {
+        total_xy_range_.Set2(0.0, 1.0, 0.0, 1.0);
+    }
+    total_xy_range_.FixDegenerateCases();
+}
+
+template<typename T>
+void SoftwareCanvas<T>::PrepareRules(void)
+{
+    const auto to_px = [&](const double x) {
+        return (float)((double)frame_.x0 + (x - visible_range_.lowx()) * scale_x_);
+    };
+    const auto to_py = [&](const double y) {
+        return (float)((double)frame_.y1 - (y - visible_range_.lowy()) * scale_y_);
+    };
+    const auto add_rule = [](std::vector<Rule>& o_rules,
+        const float x0, const float y0, const float x1, const float y1,
+        const float width, const color_t& color, const bool dotted) {
+        o_rules.push_back(Rule{ x0, y0, x1, y1, width, RasterImage::MakePaint(color), dotted });
+    };
+
+    // Grid, the same wires as sent to the GPU by the canvas. It is needed for the axis values anyway.
+    grid_.Invalidate();
+    grid_valid_ = grid_.CalculateStep(visible_range_,
+            (double)(frame_.x1 - frame_.x0), (double)(frame_.y1 - frame_.y0)) == 0 &&
+        grid_.BuildGrid(visible_range_, total_xy_range_) == 0;
+    if (grid_valid_ && (enable_hgrid_ || enable_vgrid_)) {
+        unsigned int n_vertices;
+        const vertex_colored_t* const vertices = grid_.GetVerticesData(n_vertices);
+        // The vertices are relative to the center of the visible range
+        const double xm = visible_range_.xm();
+        const double ym = visible_range_.ym();
+        const auto add_wires = [&](const wire_t* const wires, const unsigned int first,
+            const unsigned int n, const float width, const bool dotted) {
+            for (unsigned int i = first; i < first + n; i++) {
+                const vertex_colored_t& v0 = vertices[wires[i].v0];
+                const vertex_colored_t& v1 = vertices[wires[i].v1];
+                add_rule(frame_rules_, to_px(xm + v0.coords_.x()), to_py(ym + v0.coords_.y()),
+                    to_px(xm + v1.coords_.x()), to_py(ym + v1.coords_.y()), width, v0.color_, dotted);
+            }
+        };
+        unsigned int n_fine_x, n_fine_y, n_coarse_x, n_coarse_y;
+        const wire_t* const wires_fine = grid_.GetWiresFineData(n_fine_x, n_fine_y);
+        const wire_t* const wires_coarse = grid_.GetWiresCoarseData(n_coarse_x, n_coarse_y);
+        if (enable_vgrid_) {
+            add_wires(wires_fine, 0u, n_fine_x, grid_.GetVGridFineLineWidth(), true);
+            add_wires(wires_coarse, 0u, n_coarse_x, grid_.GetVGridCoarseLineWidth(), false);
+        }
+        if (enable_hgrid_) {
+            add_wires(wires_fine, n_fine_x, n_fine_y, grid_.GetHGridFineLineWidth(), true);
+            add_wires(wires_coarse, n_coarse_x, n_coarse_y, grid_.GetHGridCoarseLineWidth(), false);
+        }
+    }
+
+    const XYrange<double>& tr = total_xy_range_;
+    if (enable_axes_) {
+        add_rule(frame_rules_, to_px(tr.lowx()), to_py(0.0), to_px(tr.highx()), to_py(0.0),
+            axes_line_width_, axes_line_color_, false);
+        add_rule(frame_rules_, to_px(0.0), to_py(tr.lowy()), to_px(0.0), to_py(tr.highy()),
+            axes_line_width_, axes_line_color_, false);
+    }
+    if (enable_vref_) {
+        add_rule(frame_rules_, to_px(tr.lowx()), to_py(tr.lowy()), to_px(tr.lowx()), to_py(tr.highy()),
+            vref_line_width_, vref_line_color_, false);
+    }
+    if (enable_frame_) {
+        const float x0 = (float)frame_.x0;
+        const float y0 = (float)frame_.y0;
+        const float x1 = (float)frame_.x1;
+        const float y1 = (float)frame_.y1;
+        add_rule(window_rules_, x0, y1, x1, y1, 2.0f, frame_line_color_, false);
+        add_rule(window_rules_, x1, y1, x1, y0, 2.0f, frame_line_color_, false);
+        add_rule(window_rules_, x1, y0, x0, y0, 2.0f, frame_line_color_, false);
+        add_rule(window_rules_, x0, y0, x0, y1, 2.0f, frame_line_color_, false);
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::PrepareLabels(void)
+{
+    const int w = image_.GetWidth();
+    const int h = image_.GetHeight();
+    const Paint paint = RasterImage::MakePaint(gen_text_color_);
+    const int ch_width = (int)(font_size_ * (float)tiny_gl_text_renderer::CHAR_WIDTH);
+    const int line_height = (int)(font_size_ * (float)tiny_gl_text_renderer::CHAR_HEIGHT);
+    const auto add_label = [&](const char* const text, const int x, const int y, const float angle) {
+        labels_.push_back(TextLabel{ std::string(text), (float)x, (float)y, angle, paint });
+    };
+
+    // Axis titles, placed as by Canvas::Show()
+    const int line_len_x = (int)x_axis_title_.size();
+    add_label(x_axis_title_.c_str(), w - (int)margin_xr_pix_ - line_len_x * ch_width,
+        h - (int)margin_yb_pix_ + line_height, 0.0f);
+    const int line_len_y = (int)y_axis_title_.size();
+    const int lbl_pos_x = (y_axis_title_rotated_ ?
+        (int)margin_xl_pix_ - line_height - line_height :
+        (int)margin_xl_pix_ - line_height - line_len_y * ch_width);
+    const int lbl_pos_y = (y_axis_title_rotated_ ?
+        (int)margin_yt_pix_ + line_len_y * ch_width :
+        (int)margin_yt_pix_);
+    add_label(y_axis_title_.c_str(), lbl_pos_x, lbl_pos_y, (y_axis_title_rotated_ ? 90.0f : 0.0f));
+
+    // Grid parameters
+    char buf2[128];
+    snprintf(&buf2[0], 128, "(%g;%g) (%g;%g)",
+        grid_.GetFineXstep(), grid_.GetFineYstep(),
+        grid_.GetCoarseXstep(), grid_.GetCoarseYstep());
+    const int grid_line_len = (int)strlen(buf2);
+    add_label(buf2, w - (int)margin_xr_pix_ - grid_line_len * ch_width, _v_offset, 0.0f);
+
+    // Axis values at the coarse grid lines, as by Canvas::UpdateTexAxesValues()
+    if (!grid_valid_) return;
+    const XYrange<double>& vr = visible_range_;
+    const XYrange<double>& tr = total_xy_range_;
+    const double xmin = std::fmax(vr.lowx(),  tr.lowx());
+    const double xmax = std::fmin(vr.highx(), tr.highx());
+    const double ymin = std::fmax(vr.lowy(),  tr.lowy());
+    const double ymax = std::fmin(vr.highy(), tr.highy());
+    const bool empty = !(xmin < xmax) || !(ymin < ymax);
+    const double x_step = grid_.GetCoarseXstep();
+    const double y_step = grid_.GetCoarseYstep();
+    double x_first = 0.0;
+    double y_first = 0.0;
+    const unsigned int nx = empty ? 0u : Grid<double>::CountLines(xmin, xmax, x_step, x_first);
+    const unsigned int ny = empty ? 0u : Grid<double>::CountLines(ymin, ymax, y_step, y_first);
+    constexpr unsigned int n_labels_max = 20u;
+    constexpr size_t BUFSIZE = 32;
+    char buf[BUFSIZE];
+    for (unsigned int i = 0; i < std::min(n_labels_max, nx); i++) {
+        const double x = x_first + (double)i * x_step;
+        Grid<double>::FormatValue(x, x_step, buf, BUFSIZE);
+        const int offset = -(ch_width * (int)strlen(buf)) / 2;
+        const double xs = (double)frame_.x0 + (x - visible_range_.lowx()) * scale_x_;
+        add_label(buf, (int)xs + offset, h - (int)margin_yb_pix_, 0.0f);
+    }
+    for (unsigned int i = 0; i < std::min(n_labels_max, ny); i++) {
+        const double y = y_first + (double)i * y_step;
+        Grid<double>::FormatValue(y, y_step, buf, BUFSIZE);
+        const int offset = (ch_width * (int)strlen(buf)) / 2;
+        const double ys = (double)frame_.y1 - (y - visible_range_.lowy()) * scale_y_;
+        add_label(buf, (int)margin_xl_pix_ - line_height, (int)ys + offset, 90.0f);
+    }
+}
+
+template<typename T>
+typename SoftwareCanvas<T>::Layer& SoftwareCanvas<T>::NextLayer(const typename Layer::Kind p_kind)
+{
+    if (n_layers_ == layers_.size()) {
+        layers_.emplace_back();
+    }
+    Layer& layer = layers_[n_layers_++];
+    layer.kind_ = p_kind;
+    layer.points_.clear();
+    layer.chunk_rows_.clear();
+    layer.histo2d_ = nullptr;
+    return layer;
+}
+
+template<typename T>
+void SoftwareCanvas<T>::PrepareLayers(void)
+{
+    const int fw = frame_.x1 - frame_.x0;
+    const int fh = frame_.y1 - frame_.y0;
+
+    // 2D histograms are the background of the graphs
+    for (const auto* const histo : histograms2d_) {
+        if (!histo->GetVisible() || histo->GetMaxValue() == 0u) continue;
+        Layer& layer = this->NextLayer(Layer::Kind::HISTOGRAM2D);
+        layer.histo2d_ = histo;
+        const XYrange<T>& range = histo->GetXYrange();
+        const double k = (double)histo->GetNbinsX() / (double)range.dx();
+        layer.bin_x_.resize((size_t)fw);
+        for (int i = 0; i < fw; i++) {
+            const double x = visible_range_.lowx() + ((double)i + 0.5) / scale_x_;
+            const double bin = std::floor((x - (double)range.lowx()) * k);
+            layer.bin_x_[(size_t)i] = (bin >= 0.0 && bin < (double)histo->GetNbinsX()) ? (int)bin : -1;
+        }
+    }
+
+    // Graphs, decimated to the pixel columns as by Canvas::DrawGraph()
+    for (const auto* const gr : graphs_) {
+        if (!gr->GetVisible()) continue;
+        if (gr->GetDensityMode()) {
+            Layer& layer = this->NextLayer(Layer::Kind::DENSITY);
+            unsigned int n;
+            const Vec2<T>* const data = gr->GetLevelData(0u, n);
+            this->TransformPoints(data, n, 0.0f, layer);
+            layer.counts_.resize((size_t)fw * (size_t)fh);
+            continue;
+        }
+        const float margin = 0.5f * std::max(gr->GetLineWidth(), gr->GetMarkerSize()) + 1.0f;
+        const auto next_layer = [&](const float p_line_width, const float p_marker_size) -> Layer& {
+            Layer& layer = this->NextLayer(Layer::Kind::LINES);
+            layer.paint_ = RasterImage::MakePaint(gr->GetColor());
+            layer.line_width_ = p_line_width;
+            layer.marker_size_ = p_marker_size;
+            layer.marker_first_ = 0u;
+            layer.marker_step_ = 1u;
+            return layer;
+        };
+        unsigned int n_level;
+        const Vec2<T>* const data = gr->GetLevelData(0u, n_level);
+        unsigned int first;
+        unsigned int n;
+        gr->GetVisibleSpan(0u,
+            static_cast<T>(visible_range_.lowx()), static_cast<T>(visible_range_.highx()),
+            first, n);
+        if (!gr->DecimateToColumns(visible_range_.lowx(), visible_range_.dx() / (double)fw,
+                                   (unsigned int)fw, decimated_vertices_)) {
+            this->TransformPoints(data + first, n, margin, next_layer(gr->GetLineWidth(), gr->GetMarkerSize()));
+            continue;
+        }
+        // Markers wider than a pixel are drawn at all the visible points, as by Canvas::DrawGraph()
+        const bool all_markers = (gr->GetMarkerSize() > 1.0f);
+        if (all_markers) {
+            this->TransformPoints(data + first, n, margin, next_layer(0.0f, gr->GetMarkerSize()));
+        }
+        decimated_points_.resize(decimated_vertices_.size());
+        for (size_t i = 0u; i < decimated_vertices_.size(); i++) {
+            decimated_points_[i] = gr->GetVertex(decimated_vertices_[i]);
+        }
+        this->TransformPoints(decimated_points_.data(), (unsigned int)decimated_points_.size(), margin,
+            next_layer(gr->GetLineWidth(), all_markers ? 0.0f : gr->GetMarkerSize()));
+    }
+
+    // Histograms as the outline of 3 vertices per bin, see canvas_h_vp_source
+    for (const auto* const histo : histograms_) {
+        const unsigned int n_bins = histo->GetNbins();
+        if (!histo->GetVisible() || n_bins == 0u) continue;
+        const double x_min = static_cast<double>(histo->GetXmin());
+        const double bin_width = (static_cast<double>(histo->GetXmax()) - x_min) / (double)n_bins;
+        const auto bin_at = [&](const double x) {
+            return std::min(std::max(std::floor((x - x_min) / bin_width), 0.0), (double)n_bins);
+        };
+        const unsigned int first = (unsigned int)std::max(bin_at(visible_range_.lowx()) - 1.0, 0.0);
+        const unsigned int last = (unsigned int)std::min(bin_at(visible_range_.highx()) + 2.0, (double)n_bins);
+        if (last <= first) continue;
+        std::vector<Vec2<T>> outline(3u * (last - first));
+        const unsigned long* const values = histo->GetBinValues();
+        for (unsigned int b = first; b < last; b++) {
+            for (unsigned int e = 0u; e < 3u; e++) {
+                outline[3u * (b - first) + e] = Vec2<T>(
+                    static_cast<T>(x_min + ((double)b + 0.5 * (double)e) * bin_width),
+                    static_cast<T>(values[b]));
+            }
+        }
+        Layer& layer = this->NextLayer(Layer::Kind::LINES);
+        layer.paint_ = RasterImage::MakePaint(histo->GetColor());
+        layer.line_width_ = histo->GetLineWidth();
+        layer.marker_size_ = histo->GetMarkerSize();
+        layer.marker_first_ = 1u;
+        layer.marker_step_ = 3u;
+        this->TransformPoints(outline.data(), (unsigned int)outline.size(),
+            0.5f * std::max(layer.line_width_, layer.marker_size_) + 1.0f, layer);
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::TransformPoints(const Vec2<T>* const p_points, const unsigned int p_n,
+    const float p_margin, Layer& o_layer) const
+{
+    o_layer.points_.resize(p_n);
+    const unsigned int n_chunks = (p_n + chunk_size_ - 1u) / chunk_size_;
+    o_layer.chunk_rows_.resize(2u * (size_t)n_chunks);
+    if (p_n == 0u) return;
+
+    const double x0 = (double)frame_.x0;
+    const double y1 = (double)frame_.y1;
+    const double xlow = visible_range_.lowx();
+    const double ylow = visible_range_.lowy();
+    const double sx = scale_x_;
+    const double sy = scale_y_;
+    const float row_max = (float)image_.GetHeight() + 1.0f;
+    const auto transform = [=](const Vec2<T>& p) {
+        return Vec2f((float)(x0 + ((double)p.x() - xlow) * sx),
+                     (float)(y1 - ((double)p.y() - ylow) * sy));
+    };
+    // Several chunks per task, a graph may have millions of points
+    constexpr unsigned int chunks_per_task = 16u;
+    const unsigned int n_tasks = (n_chunks + chunks_per_task - 1u) / chunks_per_task;
+    ThreadPool::GetGlobal().ParallelFor(n_tasks, [&](const unsigned int i_task) {
+        const unsigned int c_end = std::min((i_task + 1u) * chunks_per_task, n_chunks);
+        for (unsigned int c = i_task * chunks_per_task; c < c_end; c++) {
+            const unsigned int i0 = c * chunk_size_;
+            const unsigned int i1 = std::min(i0 + chunk_size_, p_n);
+            float ymin = std::numeric_limits<float>::infinity();
+            float ymax = -std::numeric_limits<float>::infinity();
+            for (unsigned int i = i0; i < i1; i++) {
+                const Vec2f p = transform(p_points[i]);
+                o_layer.points_[i] = p;
+                if (std::isfinite(p.x()) && std::isfinite(p.y())) {
+                    ymin = std::min(ymin, p.y());
+                    ymax = std::max(ymax, p.y());
+                }
+            }
+            if (i1 < p_n) { // The segment to the next chunk
+                const Vec2f p = transform(p_points[i1]);
+                if (std::isfinite(p.x()) && std::isfinite(p.y())) {
+                    ymin = std::min(ymin, p.y());
+                    ymax = std::max(ymax, p.y());
+                }
+            }
+            // Rows outside of the image are limited, an empty chunk gets first > last
+            o_layer.chunk_rows_[2u * c + 0u] =
+                (int)std::floor(std::min(std::max(ymin - p_margin, -1.0f), row_max));
+            o_layer.chunk_rows_[2u * c + 1u] =
+                (int)std::floor(std::min(std::max(ymax + p_margin, -1.0f), row_max));
+        }
+    });
+}
+
+template<typename T>
+void SoftwareCanvas<T>::BinByBand(Layer& p_layer, const unsigned int p_n_bands) const
+{
+    // Counting sort of the points inside the frame by their band. Scatter data
+    // is not sorted along y, so otherwise each band would scan all the points.
+    const size_t n = p_layer.points_.size();
+    constexpr size_t points_per_task = 16u * chunk_size_;
+    const unsigned int n_tasks = (unsigned int)((n + points_per_task - 1u) / points_per_task);
+    const ClipRect frame = frame_;
+    const auto band_of = [frame](const Vec2f& p) {
+        // Also -1 for NaN
+        if (!(p.x() >= (float)frame.x0 && p.x() < (float)frame.x1 &&
+              p.y() >= (float)frame.y0 && p.y() < (float)frame.y1)) return -1;
+        return (int)p.y() / band_height_;
+    };
+    // Points of each task in each band, then where the task writes them
+    std::vector<size_t> offsets((size_t)n_tasks * p_n_bands, 0u);
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    pool.ParallelFor(n_tasks, [&](const unsigned int i_task) {
+        size_t* const counts = offsets.data() + (size_t)i_task * p_n_bands;
+        const size_t i1 = std::min((i_task + 1u) * points_per_task, n);
+        for (size_t i = i_task * points_per_task; i < i1; i++) {
+            const int band = band_of(p_layer.points_[i]);
+            if (band >= 0) counts[band]++;
+        }
+    });
+    p_layer.band_first_.resize((size_t)p_n_bands + 1u);
+    size_t total = 0u;
+    for (unsigned int b = 0u; b < p_n_bands; b++) {
+        p_layer.band_first_[b] = total;
+        for (unsigned int t = 0u; t < n_tasks; t++) {
+            size_t& offset = offsets[(size_t)t * p_n_bands + b];
+            const size_t count = offset;
+            offset = total;
+            total += count;
+        }
+    }
+    p_layer.band_first_[p_n_bands] = total;
+    p_layer.band_points_.resize(total);
+    pool.ParallelFor(n_tasks, [&](const unsigned int i_task) {
+        size_t* const next = offsets.data() + (size_t)i_task * p_n_bands;
+        const size_t i1 = std::min((i_task + 1u) * points_per_task, n);
+        for (size_t i = i_task * points_per_task; i < i1; i++) {
+            const Vec2f& p = p_layer.points_[i];
+            const int band = band_of(p);
+            if (band >= 0) p_layer.band_points_[next[band]++] = p;
+        }
+    });
+}
+
+template<typename T>
+void SoftwareCanvas<T>::CountDensity(Layer& p_layer, const ClipRect& p_clip, const size_t p_band)
+{
+    if (p_clip.IsEmpty()) return;
+    const int fw = frame_.x1 - frame_.x0;
+    uint32_t* const counts = p_layer.counts_.data();
+    for (int y = p_clip.y0; y < p_clip.y1; y++) {
+        std::fill_n(counts + (size_t)(y - frame_.y0) * (size_t)fw, (size_t)fw, 0u);
+    }
+    // The points of the band are inside the frame, see BinByBand()
+    for (size_t i = p_layer.band_first_[p_band]; i < p_layer.band_first_[p_band + 1u]; i++) {
+        const Vec2f& p = p_layer.band_points_[i];
+        const int x = (int)p.x();
+        const int y = (int)p.y();
+        counts[(size_t)(y - frame_.y0) * (size_t)fw + (size_t)(x - frame_.x0)]++;
+    }
+    uint32_t max_count = 0u;
+    for (int y = p_clip.y0; y < p_clip.y1; y++) {
+        const uint32_t* const row = counts + (size_t)(y - frame_.y0) * (size_t)fw;
+        max_count = std::max(max_count, *std::max_element(row, row + fw));
+    }
+    p_layer.band_max_[p_band] = max_count;
+}
+
+template<typename T>
+void SoftwareCanvas<T>::DrawRule(const Rule& p_rule, const ClipRect& p_clip)
+{
+    // The pixels with the center inside the line, as the non-antialiased OpenGL lines
+    const auto to_pix = [](const float c) {
+        return (int)std::min(std::max(std::ceil(c - 0.5f), -1.0f), (float)(1 << 24));
+    };
+    const float hw = 0.5f * std::max(p_rule.width_, 1.0f);
+    const bool vertical = (p_rule.x0_ == p_rule.x1_);
+    const float a0 = vertical ? p_rule.y0_ : p_rule.x0_;
+    const float a1 = vertical ? p_rule.y1_ : p_rule.x1_;
+    const float b  = vertical ? p_rule.x0_ : p_rule.y0_;
+    const int b0 = to_pix(b - hw);
+    const int b1 = to_pix(b + hw);
+    int c0 = to_pix(std::min(a0, a1));
+    int c1 = to_pix(std::max(a0, a1));
+    if (!p_rule.dotted_) {
+        if (vertical) {
+            image_.FillRect(b0, c0, b1, c1, p_rule.paint_, p_clip);
+        } else {
+            image_.FillRect(c0, b0, c1, b1, p_rule.paint_, p_clip);
+        }
+        return;
+    }
+    // Every 8th pixel counted from the first end of the line
+    const int start = (a0 <= a1) ? c0 : c1 - 1;
+    const int lo = vertical ? p_clip.y0 : p_clip.x0;
+    const int hi = vertical ? p_clip.y1 : p_clip.x1;
+    c0 = std::max(c0, lo);
+    c1 = std::min(c1, hi);
+    for (int c = c0; c < c1; c++) {
+        if ((c - start) % 8 != 0) continue;
+        if (vertical) {
+            image_.FillRect(b0, c, b1, c + 1, p_rule.paint_, p_clip);
+        } else {
+            image_.FillRect(c, b0, c + 1, b1, p_rule.paint_, p_clip);
+        }
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::DrawLayer(const Layer& p_layer, const ClipRect& p_clip)
+{
+    if (p_clip.IsEmpty()) return;
+    const int fw = frame_.x1 - frame_.x0;
+
+    if (p_layer.kind_ == Layer::Kind::HISTOGRAM2D) {
+        const Histogram2d<T, unsigned long>* const histo = p_layer.histo2d_;
+        const XYrange<T>& range = histo->GetXYrange();
+        const unsigned int nbx = histo->GetNbinsX();
+        const unsigned int nby = histo->GetNbinsY();
+        const double ky = (double)nby / (double)range.dy();
+        const double scale = 1.0 / (double)histo->GetMaxValue();
+        const unsigned long* const values = histo->GetBinValues();
+        for (int y = p_clip.y0; y < p_clip.y1; y++) {
+            const double yv = visible_range_.lowy() + ((double)frame_.y1 - ((double)y + 0.5)) / scale_y_;
+            const double bin_y = std::floor((yv - (double)range.lowy()) * ky);
+            if (!(bin_y >= 0.0 && bin_y < (double)nby)) continue;
+            const unsigned long* const row_values = values + (size_t)bin_y * nbx;
+            uint32_t* const row = image_.GetRow(y);
+            for (int x = p_clip.x0; x < p_clip.x1; x++) {
+                const int bin_x = p_layer.bin_x_[(size_t)(x - frame_.x0)];
+                if (bin_x < 0) continue;
+                const unsigned long value = row_values[bin_x];
+                if (value == 0u) continue; // Empty bins are transparent
+                const double t = std::min((double)value * scale, 1.0);
+                row[x] = colormap_[(size_t)std::lround(t * (double)(colormap_.size() - 1u))];
+            }
+        }
+        return;
+    }
+
+    if (p_layer.kind_ == Layer::Kind::DENSITY) {
+        const double log_max = std::log(1.0 + (double)std::max(p_layer.max_count_, 1u));
+        for (int y = p_clip.y0; y < p_clip.y1; y++) {
+            const uint32_t* const counts = p_layer.counts_.data() + (size_t)(y - frame_.y0) * (size_t)fw;
+            uint32_t* const row = image_.GetRow(y);
+            for (int x = p_clip.x0; x < p_clip.x1; x++) {
+                const uint32_t count = counts[x - frame_.x0];
+                if (count == 0u) continue;
+                const double t = std::log(1.0 + (double)count) / log_max;
+                row[x] = colormap_[(size_t)std::lround(t * (double)(colormap_.size() - 1u))];
+            }
+        }
+        return;
+    }
+
+    // Markers first, then the line strip, as Canvas::DrawVertexRange()
+    const size_t n = p_layer.points_.size();
+    const size_t n_chunks = p_layer.chunk_rows_.size() / 2u;
+    const auto crosses_band = [&](const size_t c) {
+        return p_layer.chunk_rows_[2u * c + 1u] >= p_clip.y0 && p_layer.chunk_rows_[2u * c] < p_clip.y1;
+    };
+    for (size_t c = 0; c < n_chunks && p_layer.marker_size_ > 0.0f; c++) {
+        if (!crosses_band(c)) continue;
+        const size_t i1 = std::min((c + 1u) * chunk_size_, n);
+        const size_t i0 = c * chunk_size_;
+        const size_t phase = (p_layer.marker_first_ + p_layer.marker_step_ - i0 % p_layer.marker_step_) %
+            p_layer.marker_step_;
+        for (size_t i = i0 + phase; i < i1; i += p_layer.marker_step_) {
+            const Vec2f& p = p_layer.points_[i];
+            image_.DrawMarker(p.x(), p.y(), p_layer.marker_size_, p_layer.paint_, p_clip);
+        }
+    }
+    for (size_t c = 0; c < n_chunks && p_layer.line_width_ > 0.0f; c++) {
+        if (!crosses_band(c)) continue;
+        const size_t i1 = std::min((c + 1u) * chunk_size_, n - 1u);
+        for (size_t i = c * chunk_size_; i < i1; i++) {
+            const Vec2f& p0 = p_layer.points_[i];
+            const Vec2f& p1 = p_layer.points_[i + 1u];
+            image_.DrawLine(p0.x(), p0.y(), p1.x(), p1.y(), p_layer.line_width_, p_layer.paint_, p_clip);
+        }
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::DrawBand(const ClipRect& p_clip)
+{
+    Paint background = RasterImage::MakePaint(background_color_);
+    background.a = 256u; // Cleared, not blended
+    image_.FillRect(p_clip.x0, p_clip.y0, p_clip.x1, p_clip.y1, background, p_clip);
+    if (frame_.IsEmpty()) return;
+
+    const ClipRect in_frame = p_clip.Intersect(frame_);
+    if (enable_frame_) {
+        image_.FillRect(frame_.x0, frame_.y0, frame_.x1, frame_.y1,
+            RasterImage::MakePaint(in_frame_bg_color_), p_clip);
+    }
+    for (const Rule& rule : frame_rules_) {
+        this->DrawRule(rule, in_frame);
+    }
+    for (const Rule& rule : window_rules_) {
+        this->DrawRule(rule, p_clip);
+    }
+    for (size_t i = 0; i < n_layers_; i++) {
+        this->DrawLayer(layers_[i], in_frame);
+    }
+    for (const TextLabel& label : labels_) {
+        image_.DrawText(label.text_.c_str(), label.x_, label.y_, font_size_, label.angle_,
+            label.paint_, p_clip);
+    }
+}
+
+template<typename T>
+void SoftwareCanvas<T>::SetDarkColorScheme(void)
+{
+    grid_.SetDarkColorScheme();
+    background_color_  = tiny_gl_text_renderer::colors::gray1;
+    in_frame_bg_color_ = tiny_gl_text_renderer::colors::gray05;
+    axes_line_color_   = tiny_gl_text_renderer::colors::gray75;
+    vref_line_color_   = tiny_gl_text_renderer::colors::olive;
+    frame_line_color_  = tiny_gl_text_renderer::colors::gray5;
+    gen_text_color_    = tiny_gl_text_renderer::colors::white;
+}
+
+template<typename T>
+void SoftwareCanvas<T>::SetBrightColorScheme(void)
+{
+    grid_.SetBrightColorScheme();
+    background_color_  = tiny_gl_text_renderer::colors::gray9;
+    in_frame_bg_color_ = tiny_gl_text_renderer::colors::gray95;
+    axes_line_color_   = tiny_gl_text_renderer::colors::gray25;
+    vref_line_color_   = tiny_gl_text_renderer::colors::olive;
+    frame_line_color_  = tiny_gl_text_renderer::colors::gray5;
+    gen_text_color_    = tiny_gl_text_renderer::colors::black;
+}
+
+// ===============================================================================
+
+template class SoftwareCanvas<float>;
+template class SoftwareCanvas<double>;
+
+} // end of namespace tiny_graph_plot
@@ -1,15 +1,19 @@
 #include "tiny_gl_text_renderer/text_renderer.h"
 
+#include <algorithm>
+
 #include "GL/glew.h"
 
+#include "tiny_gl_text_renderer/glyph_atlas.h"
 #include "tiny_gl_text_renderer/text_rend_shader_sources.h"
 #include "tiny_gl_text_renderer/mat3.h"
 
 namespace tiny_gl_text_renderer
 {
 
-/*static*/
-/*GLuint TextRenderer::_labels_counter = 0;*/
+// Slots are given to the labels in chunks, so that a label which starts
+// empty, like the axis values, does not have to move when it is filled
+constexpr size_t glyph_slots_granularity = 16u;
 
 TextRenderer::TextRenderer()
 :   buf_set_text_("text"),
@@ -19,14 +23,25 @@ TextRenderer::TextRenderer()
     buf_set_text_.Generate();
     // Programs.
     prog_text_.Generate(text_rend_vp_source, nullptr, text_rend_fp_source);
+    // Glyph atlas.
+    const GlyphAtlas& atlas = GlyphAtlas::Get();
+    glGenTextures(1, &_atlas_tex_id);
+    glBindTexture(GL_TEXTURE_2D, _atlas_tex_id);
+    glObjectLabel(GL_TEXTURE, _atlas_tex_id, -1, "glyph_atlas");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas.GetW(), atlas.GetH(), 0,
+        GL_RED, GL_UNSIGNED_BYTE, atlas.GetData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 TextRenderer::~TextRenderer()
 {
     // Textures.
-    for (const Label& label : _labels) {
-        glDeleteTextures(1, &label.tex_id_);
-    }
+    glDeleteTextures(1, &_atlas_tex_id);
 }
 
 void TextRenderer::UpdateScreenToClipMatrix()
@@ -41,10 +56,7 @@ void TextRenderer::UpdateScreenToClipMatrix()
 
 void TextRenderer::FirstReshape(int w, int h)
 {
-    this->SetCanvasSize(w, h);
-    this->AllocateVerticesAndQuadsMemory();
-    this->SendToGPU();
-    this->UpdateScreenToClipMatrix();
+    this->Reshape(w, h);
 }
 
 void TextRenderer::Reshape(int w, int h)
@@ -60,12 +72,8 @@ void TextRenderer::Draw() const
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "Draw text");
 
     prog_text_.Use();
-    // This lambda allows to loop over the labels inside BufferSet::DrawQuadsWithTextures()
-    // and access texture IDs without BufferSet knowing anything about the Label class.
-    auto get_label_tex_id = [&](const size_t i_label) -> GLuint {
-        return _labels[i_label].tex_id_;
-    };
-    buf_set_text_.DrawQuadsWithTextures(_labels.size(), get_label_tex_id);
+    glBindTexture(GL_TEXTURE_2D, _atlas_tex_id);
+    buf_set_text_.DrawQuads((unsigned int)_n_glyph_slots_on_gpu);
 
     glPopDebugGroup();
 }
@@ -74,11 +82,12 @@ size_t TextRenderer::AddLabel(const char* string, const int x, const int y,
     const color_t& color, const float scaling, const float angle)
 {
     _labels.emplace_back(string, x, y, color, scaling, angle);
-    glGenTextures(1, &_labels.back().tex_id_);
-    glBindTexture(GL_TEXTURE_2D, _labels.back().tex_id_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    this->AllocateGlyphSlots(_labels.back(), CountGlyphs(_labels.back().GetString()));
     _labels_counter++;
+    if (_n_glyph_slots_on_gpu > 0u) {
+        this->RecalculateVerticesSingle(_labels.size() - 1u);
+        this->SendToGPU();
+    }
     return (size_t)(_labels_counter - 1); // not nice but should work
 }
 
@@ -91,15 +100,25 @@ const std::string& TextRenderer::GetLabelString(const size_t i_label)
 void TextRenderer::UpdateLabel(const char* string, const size_t i_label)
 {
     Label& label = _labels.at(i_label);
-    label.UpdateString(string);
+    if (!label.UpdateString(string)) return;
+    const size_t n_glyphs = CountGlyphs(label.GetString());
+    if (n_glyphs > label.n_glyph_slots_) {
+        // The old slots are cleared, also on the GPU, and left to the other labels
+        const vertex_glyph_t empty(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, color_t(0.0f));
+        std::fill_n(_vertices.begin() + (ptrdiff_t)(label.first_glyph_ * 4u),
+            label.n_glyph_slots_ * 4u, empty);
+        this->SendToGPUverticesSingle(i_label);
+        this->ReleaseGlyphSlots(label);
+        this->AllocateGlyphSlots(label, n_glyphs);
+    }
     this->RecalculateVerticesSingle(i_label);
     this->SendToGPUverticesSingle(i_label);
-    this->SendToGPUtextureSingle(i_label);
 }
 
 void TextRenderer::UpdatePosition(const int x, const int y, const size_t i_label)
 {
     Label& label = _labels.at(i_label);
+    if (label.GetTexX() == x && label.GetTexY() == y) return;
     label.UpdatePosition(x, y);
     this->RecalculateVerticesSingle(i_label);
     this->SendToGPUverticesSingle(i_label);
@@ -108,6 +127,7 @@ void TextRenderer::UpdatePosition(const int x, const int y, const size_t i_label
 void TextRenderer::UpdatePositionX(const int x, const size_t i_label)
 {
     Label& label = _labels.at(i_label);
+    if (label.GetTexX() == x) return;
     label.UpdatePositionX(x);
     this->RecalculateVerticesSingle(i_label);
     this->SendToGPUverticesSingle(i_label);
@@ -116,6 +136,7 @@ void TextRenderer::UpdatePositionX(const int x, const size_t i_label)
 void TextRenderer::UpdatePositionY(const int y, const size_t i_label)
 {
     Label& label = _labels.at(i_label);
+    if (label.GetTexY() == y) return;
     label.UpdatePositionY(y);
     this->RecalculateVerticesSingle(i_label);
     this->SendToGPUverticesSingle(i_label);
@@ -124,6 +145,7 @@ void TextRenderer::UpdatePositionY(const int y, const size_t i_label)
 void TextRenderer::UpdateRotation(const float angle, const size_t i_label)
 {
     Label& label = _labels.at(i_label);
+    if (label.GetAngle() == angle) return;
     label.UpdateRotation(angle);
     this->RecalculateVerticesSingle(i_label);
     this->SendToGPUverticesSingle(i_label);
@@ -131,103 +153,136 @@ void TextRenderer::UpdateRotation(const float angle, const size_t i_label)
 
 void TextRenderer::RecalculateVertices()
 {
-    size_t i_label = 0u;
-    for (const Label& label : _labels) {
-        (void)label; // unused iterator variable.
+    for (size_t i_label = 0u; i_label < _labels.size(); i_label++) {
         this->RecalculateVerticesSingle(i_label);
-        i_label++;
     }
 }
 
-void TextRenderer::SendToGPU() const
+void TextRenderer::SendToGPU()
 {
     // Vertices.
-    constexpr unsigned int vertices_per_label = 4u;
-    const unsigned int n_vert = _labels_counter * vertices_per_label;
-    const vertex_textured_t* const vertices = _vertices.data();
-    buf_set_text_.Allocate(n_vert, vertices);
+    constexpr unsigned int vertices_per_glyph = 4u;
+    const unsigned int n_vert = (unsigned int)_n_glyph_slots * vertices_per_glyph;
+    buf_set_text_.Allocate(n_vert, _vertices.data());
     // Indices.
-    constexpr unsigned int quads_per_label = 1u; 
-    const quad_t* const quads = _quads.data();
-    buf_set_text_.SendIndices(_labels_counter * quads_per_label, quads);
-    // Textures.
-    size_t i_label = 0u;
-    for (const Label& label : _labels) {
-        (void)label; // unused iterator variable.
-        this->SendToGPUtextureSingle(i_label);
-        i_label++;
+    for (unsigned int i = (unsigned int)_quads.size(); i < (unsigned int)_n_glyph_slots; i++) {
+        _quads.emplace_back(i * 4u + 0u, i * 4u + 1u, i * 4u + 2u, i * 4u + 3u);
     }
+    buf_set_text_.SendIndices((unsigned int)_n_glyph_slots, _quads.data());
+    _n_glyph_slots_on_gpu = _n_glyph_slots;
 }
 
-void TextRenderer::SendToGPUverticesSingle(const size_t i_label) const
+void TextRenderer::SendToGPUverticesSingle(const size_t i_label)
 {
+    if (_n_glyph_slots_on_gpu == 0u) return; // Everything is sent by FirstReshape()
+    const Label& label = _labels.at(i_label);
+    if (label.first_glyph_ + label.n_glyph_slots_ > _n_glyph_slots_on_gpu) {
+        // The label has just moved beyond the end of the buffer
+        this->SendToGPU();
+        return;
+    }
     // Vertices.
-    constexpr size_t vertices_per_label = 4u;
-    constexpr size_t n_vert = 1u * vertices_per_label;
-    const size_t offset = i_label * 4u;
-    const vertex_textured_t* const vertices = _vertices.data() + offset;
-    buf_set_text_.SendVertices(n_vert, vertices, offset);
+    constexpr size_t vertices_per_glyph = 4u;
+    const size_t n_vert = label.n_glyph_slots_ * vertices_per_glyph;
+    const size_t offset = label.first_glyph_ * vertices_per_glyph;
+    const vertex_glyph_t* const vertices = _vertices.data() + offset;
+    buf_set_text_.SendVertices((unsigned int)n_vert, vertices, (unsigned int)offset);
 }
 
-void TextRenderer::SendToGPUtextureSingle(const size_t i_label) const
+void TextRenderer::AllocateGlyphSlots(Label& label, const size_t n_glyphs)
 {
-    // Textures.
-    const Label& label = _labels.at(i_label);
-    const size_t& tex_w = label.GetTexW();
-    const size_t& tex_h = label.GetTexH();
-    const float* const tex_data = label.GetTexData();
-    glBindTexture(GL_TEXTURE_2D, label.tex_id_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)tex_w, (GLsizei)tex_h, 0,
-        GL_RGBA, GL_FLOAT, tex_data);
-}
-
-void TextRenderer::AllocateVerticesAndQuadsMemory()
-{
-    _vertices.reserve(4u * _labels_counter);
-
-    size_t i_label = 0u;
-    for (const Label& label : _labels) {
-        const size_t& tex_w = label.GetTexW();
-        const size_t& tex_h = label.GetTexH();
-        const Mat3f m = label.GetMatrix();
-        const Vec3f v0c = m * Vec3f(0.0f, 0.0f, 1.0f);
-        const Vec3f v1c = m * Vec3f((float)tex_w, 0.0f, 1.0f);
-        const Vec3f v2c = m * Vec3f((float)tex_w, (float)tex_h, 1.0f);
-        const Vec3f v3c = m * Vec3f(0.0f, (float)tex_h, 1.0f);
-
-        _vertices.emplace_back(v0c.x(), (float)_h - v0c.y(), 0.0f, 1.0f, 0.0f, 0.0f);
-        _vertices.emplace_back(v1c.x(), (float)_h - v1c.y(), 0.0f, 1.0f, 1.0f, 0.0f);
-        _vertices.emplace_back(v2c.x(), (float)_h - v2c.y(), 0.0f, 1.0f, 1.0f, 1.0f);
-        _vertices.emplace_back(v3c.x(), (float)_h - v3c.y(), 0.0f, 1.0f, 0.0f, 1.0f);
-        _quads.emplace_back((unsigned int)i_label * 4u + 0u,
-                            (unsigned int)i_label * 4u + 1u,
-                            (unsigned int)i_label * 4u + 2u,
-                            (unsigned int)i_label * 4u + 3u);
-        i_label++;
+    const size_t n_chunks = (n_glyphs + glyph_slots_granularity - 1u) / glyph_slots_granularity;
+    label.n_glyph_slots_ = ((n_chunks > 0u) ? n_chunks : 1u) * glyph_slots_granularity;
+    // The first free range which is large enough, its slots are already empty
+    const auto range = std::find_if(_free_glyph_slots.begin(), _free_glyph_slots.end(),
+        [&label](const std::pair<size_t, size_t>& r) { return r.second >= label.n_glyph_slots_; });
+    if (range != _free_glyph_slots.end()) {
+        label.first_glyph_ = range->first;
+        range->first += label.n_glyph_slots_;
+        range->second -= label.n_glyph_slots_;
+        if (range->second == 0u) _free_glyph_slots.erase(range);
+        return;
+    }
+    label.first_glyph_ = _n_glyph_slots;
+    _n_glyph_slots += label.n_glyph_slots_;
+    const vertex_glyph_t empty(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, color_t(0.0f));
+    _vertices.resize(_n_glyph_slots * 4u, empty);
+}
+
+void TextRenderer::ReleaseGlyphSlots(const Label& label)
+{
+    // Adjacent free ranges are merged, so that a longer label fits into them
+    const std::pair<size_t, size_t> released(label.first_glyph_, label.n_glyph_slots_);
+    auto range = _free_glyph_slots.insert(
+        std::upper_bound(_free_glyph_slots.begin(), _free_glyph_slots.end(), released), released);
+    const auto next = range + 1;
+    if (next != _free_glyph_slots.end() && range->first + range->second == next->first) {
+        range->second += next->second;
+        _free_glyph_slots.erase(next);
+    }
+    if (range != _free_glyph_slots.begin()) {
+        const auto prev = range - 1;
+        if (prev->first + prev->second == range->first) {
+            prev->second += range->second;
+            _free_glyph_slots.erase(range);
+        }
     }
 }
 
 void TextRenderer::RecalculateVerticesSingle(const size_t i_label)
 {
-    using v_str_t = vertex_textured_t;
+    using v_str_t = vertex_glyph_t;
     const Label& label = _labels.at(i_label);
-
-    const size_t& tex_w = label.GetTexW();
-    const size_t& tex_h = label.GetTexH();
+    const GlyphAtlas& atlas = GlyphAtlas::Get();
+    const float atlas_w = (float)atlas.GetW();
+    const float atlas_h = (float)atlas.GetH();
+    const color_t& color = label.GetColor();
     const Mat3f m = label.GetMatrix();
-    const Vec3f v0c = m * Vec3f(0.0f, 0.0f, 1.0f);
-    const Vec3f v1c = m * Vec3f((float)tex_w, 0.0f, 1.0f);
-    const Vec3f v2c = m * Vec3f((float)tex_w, (float)tex_h, 1.0f);
-    const Vec3f v3c = m * Vec3f(0.0f, (float)tex_h, 1.0f);
-
-    v_str_t& va0 = _vertices.at(i_label * 4 + 0);
-    v_str_t& va1 = _vertices.at(i_label * 4 + 1);
-    v_str_t& va2 = _vertices.at(i_label * 4 + 2);
-    v_str_t& va3 = _vertices.at(i_label * 4 + 3);
-    va0 = v_str_t(v0c.x(), (float)_h - v0c.y(), 0.0f, 1.0f, 0.0f, 0.0f);
-    va1 = v_str_t(v1c.x(), (float)_h - v1c.y(), 0.0f, 1.0f, 1.0f, 0.0f);
-    va2 = v_str_t(v2c.x(), (float)_h - v2c.y(), 0.0f, 1.0f, 1.0f, 1.0f);
-    va3 = v_str_t(v3c.x(), (float)_h - v3c.y(), 0.0f, 1.0f, 0.0f, 1.0f);
+
+    // Same layout as the text in a texture of its own would have:
+    // the top-left corner of the first character at the label position
+    v_str_t* va = &_vertices.at(label.first_glyph_ * 4u);
+    v_str_t* const va_end = va + label.n_glyph_slots_ * 4u;
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    for (const char ch : label.GetString()) {
+        if (ch == '\n') {
+            u0 = 0.0f;
+            v0 += (float)CHAR_HEIGHT;
+            continue;
+        }
+        int tex_x, tex_y;
+        if (GlyphAtlas::GetGlyph(ch, tex_x, tex_y)) {
+            const float u1 = u0 + (float)CHAR_WIDTH;
+            const float v1 = v0 + (float)CHAR_HEIGHT;
+            const Vec3f v0c = m * Vec3f(u0, v0, 1.0f);
+            const Vec3f v1c = m * Vec3f(u1, v0, 1.0f);
+            const Vec3f v2c = m * Vec3f(u1, v1, 1.0f);
+            const Vec3f v3c = m * Vec3f(u0, v1, 1.0f);
+            const float s0 = (float)tex_x / atlas_w;
+            const float t0 = (float)tex_y / atlas_h;
+            const float s1 = (float)(tex_x + CHAR_WIDTH) / atlas_w;
+            const float t1 = (float)(tex_y + CHAR_HEIGHT) / atlas_h;
+            *va++ = v_str_t(v0c.x(), (float)_h - v0c.y(), 0.0f, 1.0f, s0, t0, color);
+            *va++ = v_str_t(v1c.x(), (float)_h - v1c.y(), 0.0f, 1.0f, s1, t0, color);
+            *va++ = v_str_t(v2c.x(), (float)_h - v2c.y(), 0.0f, 1.0f, s1, t1, color);
+            *va++ = v_str_t(v3c.x(), (float)_h - v3c.y(), 0.0f, 1.0f, s0, t1, color);
+        }
+        u0 += (float)CHAR_WIDTH;
+    }
+    const v_str_t empty(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, color_t(0.0f));
+    std::fill(va, va_end, empty);
+}
+
+/*static*/
+size_t TextRenderer::CountGlyphs(const std::string& string) noexcept
+{
+    size_t n_glyphs = 0u;
+    int tex_x, tex_y;
+    for (const char ch : string) {
+        if (GlyphAtlas::GetGlyph(ch, tex_x, tex_y)) n_glyphs++;
+    }
+    return n_glyphs;
 }
 
 } // end of namespace tiny_gl_text_renderer
@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+
+namespace tiny_graph_plot
+{
+
+//! Set for the threads currently executing a task of some pool
+static thread_local bool inside_task = false;
+
+ThreadPool::ThreadPool(const unsigned int p_n_threads)
+{
+    unsigned int n_threads = p_n_threads;
+    if (n_threads == 0u) {
+        n_threads = std::thread::hardware_concurrency();
+    }
+    for (unsigned int i = 1u; i < n_threads; i++) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_work_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::GetGlobal()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::ParallelFor(const unsigned int p_n_tasks,
+                             const std::function<void(unsigned int)>& p_task)
+{
+    if (workers_.empty() || p_n_tasks < 2u || inside_task) {
+        for (unsigned int i = 0u; i < p_n_tasks; i++) {
+            p_task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> call_lock(call_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &p_task;
+        n_tasks_ = p_n_tasks;
+        next_task_ = 0u;
+        n_done_ = 0u;
+        generation_++;
+    }
+    cv_work_.notify_all();
+
+    this->RunTasks();
+
+    // The workers must leave RunTasks() before the task goes out of scope
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this] { return n_done_ == n_tasks_ && n_busy_ == 0u; });
+    task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned long seen_generation = 0u;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_work_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+        if (stop_) return;
+        seen_generation = generation_;
+        n_busy_++;
+        lock.unlock();
+        this->RunTasks();
+        lock.lock();
+        n_busy_--;
+        if (n_busy_ == 0u) {
+            cv_done_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::RunTasks()
+{
+    inside_task = true;
+    unsigned int i;
+    while ((i = next_task_.fetch_add(1u)) < n_tasks_) {
+        (*task_)(i);
+        if (n_done_.fetch_add(1u) + 1u == n_tasks_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_done_.notify_all();
+        }
+    }
+    inside_task = false;
+}
+
+} // end of namespace tiny_graph_plot
@@ -1,26 +1,40 @@
 #include "user_window.h"
 
+#include <algorithm>
+
 #include "glfw_callback_functions.h"
+#include "offscreen_context.h"
 
 #define SET_CONTEXT
 
 namespace tiny_graph_plot
 {
 
-UserWindow::UserWindow(GLFWwindow* window, const unsigned int w, const unsigned int h)
-:   _window(window), _window_w(w), _window_h(h)
+UserWindow::UserWindow(GLFWwindow* window, const unsigned int w, const unsigned int h,
+    const OffscreenContext* offscreen_context)
+:   _window(window), _offscreen_context(offscreen_context), _window_w(w), _window_h(h)
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
+    if (_window == nullptr) return;
     glfwSetWindowUserPointer(_window, reinterpret_cast<void*>(this));
     this->SetCallbacks();
 }
 
+void UserWindow::MakeContextCurrent(void) const
+{
+    if (_window != nullptr) {
+        glfwMakeContextCurrent(_window);
+    } else if (_offscreen_context != nullptr) {
+        _offscreen_context->MakeCurrent();
+    }
+}
+
 void UserWindow::SetCallbacks(void) const
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
     glfwSetFramebufferSizeCallback(_window, glfw_callback_functions::framebuffer_size_callback);
     glfwSetWindowRefreshCallback(_window, glfw_callback_functions::window_refresh_callback);
@@ -37,12 +51,13 @@ void UserWindow::SetCallbacks(void) const
 void UserWindow::framebuffer_size_event(int width, int height)
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
     if (width == 0 && height == 0) return; // Window minimized
     _window_w = width;
     _window_h = height;
     this->Reshape(width, height);
+    this->RequestFrame();
 }
 
 void UserWindow::window_pos_event(int xpos, int ypos)
@@ -68,17 +83,85 @@ void UserWindow::window_focus_event(int focused)
 void UserWindow::window_refresh_event()
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
+    // The system needs the contents now, e.g. while the window is being resized
+    if (_window != nullptr) {
+        this->RenderFrame();
+    } else {
+        this->Clear();
+        this->Draw();
+    }
+}
+
+bool UserWindow::RenderFrameIfDue(const double p_now)
+{
+    const double wait = this->GetTimeToNextFrame(p_now);
+    if (wait < 0.0 || wait > 0.0) return false;
+    this->RenderFrame();
+    _last_frame_time = p_now;
+    return true;
+}
+
+double UserWindow::GetTimeToNextFrame(const double p_now) const noexcept
+{
+    if (!_frame_requested || _window == nullptr) return -1.0;
+    return std::max(_last_frame_time + _min_frame_interval - p_now, 0.0);
+}
+
+void UserWindow::SetSwapInterval(const int interval)
+{
+    if (_window == nullptr) return;
+    this->MakeContextCurrent();
+    glfwSwapInterval(interval);
+}
+
+void UserWindow::RenderFrame()
+{
+    this->MakeContextCurrent();
+    _frame_requested = false;
+    this->ApplyPendingView();
+    double xs; double ys;
+    if (_overlay == overlay_t::OVL_CURSOR) {
+        this->ClampToFrame(_xs_cur, _ys_cur, xs, ys);
+        this->UpdateTexTextCur(xs, ys);
+    }
     this->Clear();
     this->Draw();
+    if (_overlay == overlay_t::OVL_CURSOR) {
+        this->DrawCursor(xs, ys);
+        this->DrawCircles(xs, ys);
+    } else if (_overlay == overlay_t::OVL_SELECTION) {
+        this->DrawSelRectangle(_xs_start, _ys_start, _xs_cur, _ys_cur);
+    }
     glfwSwapBuffers(_window);
 }
 
+void UserWindow::ApplyPendingView()
+{
+    if (!_view_pending) return;
+    _view_pending = false;
+    switch (_cur_action) {
+    case action_t::ACT_PAN:    this->Pan(_xs_cur, _ys_cur);
+        break;
+    case action_t::ACT_ZOOM:   this->Zoom(_xs_cur, _ys_cur);
+        break;
+    case action_t::ACT_ZOOM_F: this->ZoomF(_xs_cur, _ys_cur);
+        break;
+    case action_t::ACT_ZOOM_X: this->ZoomX(_xs_cur, _ys_cur);
+        break;
+    case action_t::ACT_ZOOM_Y: this->ZoomY(_xs_cur, _ys_cur);
+        break;
+    default:
+        break;
+    }
+    _xs_prev = _xs_cur; _ys_prev = _ys_cur;
+}
+
 void UserWindow::key_event(int key, int scancode, int action, int mods)
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
     (void)scancode; (void)mods;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
@@ -88,31 +171,35 @@ void UserWindow::key_event(int key, int scancode, int action, int mods)
         switch (key) {
         case GLFW_KEY_F:
             this->ResetCamera();
-            this->window_refresh_event();
+            this->RequestFrame();
             break;
         case GLFW_KEY_Z:
             this->SetPrevViewport();
-            this->window_refresh_event();
+            this->RequestFrame();
             break;
         case GLFW_KEY_S:
             this->FixedAspRatCamera();
-            this->window_refresh_event();
+            this->RequestFrame();
             break;
         case GLFW_KEY_F1:
             this->ExportSnapshot();
             break;
+        case GLFW_KEY_F2:
+            this->TogglePerfOverlay();
+            this->RequestFrame();
+            break;
 
-        case GLFW_KEY_GRAVE_ACCENT: this->ToggleGraphVisibility(0); this->window_refresh_event(); break;
-        case GLFW_KEY_1: this->ToggleGraphVisibility(1);  this->window_refresh_event(); break;
-        case GLFW_KEY_2: this->ToggleGraphVisibility(2);  this->window_refresh_event(); break;
-        case GLFW_KEY_3: this->ToggleGraphVisibility(3);  this->window_refresh_event(); break;
-        case GLFW_KEY_4: this->ToggleGraphVisibility(4);  this->window_refresh_event(); break;
-        case GLFW_KEY_5: this->ToggleGraphVisibility(5);  this->window_refresh_event(); break;
-        case GLFW_KEY_6: this->ToggleGraphVisibility(6);  this->window_refresh_event(); break;
-        case GLFW_KEY_7: this->ToggleGraphVisibility(7);  this->window_refresh_event(); break;
-        case GLFW_KEY_8: this->ToggleGraphVisibility(8);  this->window_refresh_event(); break;
-        case GLFW_KEY_9: this->ToggleGraphVisibility(9);  this->window_refresh_event(); break;
-        case GLFW_KEY_0: this->ToggleGraphVisibility(10); this->window_refresh_event(); break;
+        case GLFW_KEY_GRAVE_ACCENT: this->ToggleGraphVisibility(0); this->RequestFrame(); break;
+        case GLFW_KEY_1: this->ToggleGraphVisibility(1);  this->RequestFrame(); break;
+        case GLFW_KEY_2: this->ToggleGraphVisibility(2);  this->RequestFrame(); break;
+        case GLFW_KEY_3: this->ToggleGraphVisibility(3);  this->RequestFrame(); break;
+        case GLFW_KEY_4: this->ToggleGraphVisibility(4);  this->RequestFrame(); break;
+        case GLFW_KEY_5: this->ToggleGraphVisibility(5);  this->RequestFrame(); break;
+        case GLFW_KEY_6: this->ToggleGraphVisibility(6);  this->RequestFrame(); break;
+        case GLFW_KEY_7: this->ToggleGraphVisibility(7);  this->RequestFrame(); break;
+        case GLFW_KEY_8: this->ToggleGraphVisibility(8);  this->RequestFrame(); break;
+        case GLFW_KEY_9: this->ToggleGraphVisibility(9);  this->RequestFrame(); break;
+        case GLFW_KEY_0: this->ToggleGraphVisibility(10); this->RequestFrame(); break;
 
         default:
             break;
@@ -123,7 +210,7 @@ void UserWindow::key_event(int key, int scancode, int action, int mods)
 void UserWindow::mouse_button_event(int button, int action, int mods)
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
     double xs; double ys_inv;
     glfwGetCursorPos(_window, &xs, &ys_inv);
@@ -133,12 +220,9 @@ void UserWindow::mouse_button_event(int button, int action, int mods)
         button == GLFW_MOUSE_BUTTON_LEFT &&
         mods == GLFW_MOD_CONTROL) {
         this->UpdateTexTextRef(xs, ys);
-        this->UpdateTexTextCur(xs, ys);
-        this->Clear();
-        this->Draw();
-        this->DrawCursor(xs, ys);
-        this->DrawCircles(xs, ys);
-        glfwSwapBuffers(_window);
+        _xs_cur = xs; _ys_cur = ys;
+        _overlay = overlay_t::OVL_CURSOR;
+        this->RequestFrame();
         return;
     }
 
@@ -147,6 +231,7 @@ void UserWindow::mouse_button_event(int button, int action, int mods)
         this->SaveStartState();
         _xs_start = xs; _ys_start = ys;
         _xs_prev = xs; _ys_prev = ys;
+        _xs_cur = xs; _ys_cur = ys;
         _mouse_moved = false;
         if (button == GLFW_MOUSE_BUTTON_MIDDLE) {
             _cur_action = action_t::ACT_PAN;
@@ -169,6 +254,7 @@ void UserWindow::mouse_button_event(int button, int action, int mods)
     }
     else if (action == GLFW_RELEASE)
     {
+        this->ApplyPendingView();
         if (button == GLFW_MOUSE_BUTTON_MIDDLE && !_mouse_moved &&
             _cur_action == action_t::ACT_PAN) {
             this->CenterView(xs, ys);
@@ -178,64 +264,36 @@ void UserWindow::mouse_button_event(int button, int action, int mods)
             this->ZoomTo(_xs_start, _ys_start, xs, ys);
         }
         _cur_action = action_t::ACT_NO_ACT;
-        this->window_refresh_event();
+        _overlay = overlay_t::OVL_NONE;
+        this->RequestFrame();
     }
 }
 
 void UserWindow::mouse_pos_event(double xs, double ys_inv)
 {
-#ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
-#endif
     const double ys = (double)_window_h - ys_inv;
 
     _mouse_moved = true;
+    _xs_cur = xs; _ys_cur = ys;
 
-    //const int xs_i = (int)xs;
-    //const int ys_i = (int)ys;
-
+    // Only the latest position is used by the next frame, see RenderFrame()
     switch (_cur_action) {
-    case action_t::ACT_NO_ACT: {
-        double xs_; double ys_;
-        this->ClampToFrame(xs, ys, xs_, ys_);
-        this->UpdateTexTextCur(xs_, ys_);
-        this->Clear();
-        this->Draw();
-        this->DrawCursor(xs_, ys_);
-        this->DrawCircles(xs_, ys_);
-        glfwSwapBuffers(_window);
-        return;
-        break; }
-    case action_t::ACT_PAN:    this->Pan(xs, ys);
-        break;
-    case action_t::ACT_ZOOM:   this->Zoom(xs, ys);
+    case action_t::ACT_NO_ACT: _overlay = overlay_t::OVL_CURSOR;
         break;
-    case action_t::ACT_ZOOM_F: this->ZoomF(xs, ys);
+    case action_t::ACT_RECT:   _overlay = overlay_t::OVL_SELECTION;
         break;
-    case action_t::ACT_ZOOM_X: this->ZoomX(xs, ys);
-        break;
-    case action_t::ACT_ZOOM_Y: this->ZoomY(xs, ys);
-        break;
-    case action_t::ACT_RECT: {
-        this->Clear();
-        this->Draw();
-        this->DrawSelRectangle(_xs_start, _ys_start, xs, ys);
-        glfwSwapBuffers(_window);
-        return;
-        break; }
     default:
+        _overlay = overlay_t::OVL_NONE;
+        _view_pending = true;
         break;
     }
-
-    _xs_prev = xs; _ys_prev = ys;
-
-    this->window_refresh_event();
+    this->RequestFrame();
 }
 
 void UserWindow::scroll_event(double xoffset, double yoffset)
 {
 #ifdef SET_CONTEXT
-    glfwMakeContextCurrent(_window);
+    this->MakeContextCurrent();
 #endif
     (void)xoffset; (void)yoffset;
 